@@ -7,5 +7,6 @@
 #include "fgrgamegraphics.h"
 #include "fgrgamedevfileops.h"
 #include "fgroverworld.h"
+#include "fgrroomrenderer.h"
 
 #endif
@@ -5,17 +5,100 @@
 #define __FGR_GAME_DEV_GRAPHICS_H__
 
 #include "fgrutils.h"
+#include "fgrinstance.h"
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cstddef>
 
 namespace fgr {
 
 	namespace game {
 
-		//This class supports animation and is very memory-efficient, as well as time efficient
+		/* Every frame of an animation, packed into a single vertex buffer. Each frame is just a
+		 * range of runs, and each run a range of vertices, so switching frames never touches the
+		 * GPU. Consecutive shapes that draw the same way share a run. Where buffer objects aren't
+		 * supported (or the vertices are wanted on the CPU, for instancing) they stay in memory
+		 * and are drawn as client-side arrays. The vector art is kept too, so frames can be baked
+		 * into texture atlases at whatever zoom they turn out to be drawn at. */
+		class spritestorage : public vertexart {
+		public:
+			//The vertex buffer, or 0 if the vertices are drawn from memory
+			GLuint buffer;
+			//The art itself (shared with whoever else holds it), and every frame's fingerprint (for
+			//finding them in atlases)
+			std::shared_ptr<const animation> source;
+			std::vector<std::size_t> keys;
+
+			//Pack every frame of an animation
+			spritestorage(const animation& art, bool onGPU = true)
+				: spritestorage(std::make_shared<const animation>(art), onGPU) { }
+			spritestorage(const std::shared_ptr<const animation>& art, bool onGPU = true) : vertexart(*art), source(art) {
+				buffer = 0;
+				for (animation::const_iterator itr = art->begin(); itr != art->end(); ++itr)
+					keys.push_back(frameKey(*itr));
+				if (onGPU)
+					upload();
+			}
+			//How much memory this takes up, in bytes, the vector art included
+			std::size_t bytes() const {
+				std::size_t total = vertexart::bytes() + keys.capacity() * sizeof(std::size_t);
+				if (!source)
+					return total;
+				//Every vertex is a node of a std::list, with two links
+				const std::size_t vertex = sizeof(point) + 2 * sizeof(void*);
+				total += sizeof(animation) + source->capacity() * sizeof(frame);
+				for (animation::const_iterator itr = source->begin(); itr != source->end(); ++itr) {
+					total += itr->capacity() * sizeof(shape);
+					for (graphic::const_iterator shp = itr->begin(); shp != itr->end(); ++shp)
+						total += shp->size() * vertex;
+				}
+				return total;
+			}
+			//Draw one frame at the origin of the matrix
+			void draw(std::size_t frame) const {
+				if (frame >= frames.size() || !frames[frame].runs || !vertexCount)
+					return;
+				const vertexframe& f = frames[frame];
+				if (buffer) {
+					glext::bindBuffer(GL_ARRAY_BUFFER, buffer);
+					drawRuns(NULL, &runs[f.firstRun], f.runs);
+					glext::bindBuffer(GL_ARRAY_BUFFER, 0);
+				}
+				else
+					drawRuns(&vertices[0], &runs[f.firstRun], f.runs);
+			}
+			//DESTRUCTOR
+			~spritestorage() {
+				if (buffer)
+					glext::deleteBuffers(1, &buffer);
+			}
+		private:
+			//Not copyable, since it owns a buffer
+			spritestorage(const spritestorage&);
+			spritestorage& operator=(const spritestorage&);
+			//Move the vertices onto the GPU, if buffer objects are supported
+			void upload() {
+				if (vertices.empty() || !glext::loadBuffers())
+					return;
+				glext::genBuffers(1, &buffer);
+				glext::bindBuffer(GL_ARRAY_BUFFER, buffer);
+				glext::bufferData(GL_ARRAY_BUFFER, std::ptrdiff_t(vertices.size() * sizeof(colorvertex)), &vertices[0], GL_STATIC_DRAW);
+				glext::bindBuffer(GL_ARRAY_BUFFER, 0);
+				std::vector<colorvertex>().swap(vertices);
+			}
+		};
+
+		//This class supports animation and is very memory-efficient, as well as time efficient.
+		//Copies of a sprite share its art, and keep their own place in it. Sprites can be drawn
+		//from their vectors, or from textures baked from them (see fgratlas.h).
 		class sprite {
-			std::pair<GLuint, GLsizei> GLhandle;
-			bool defined;
+			std::shared_ptr<const spritestorage> storage;
+			//Where this sprite's frames are baked, or NULL to draw its vectors
+			std::shared_ptr<atlascache> atlas;
 		public:
-			friend class motionsprite;
 			// REPRESENTATION
 			//The delay between frames, in frames.
 			unsigned int delay;
@@ -44,20 +127,76 @@ namespace fgr {
 				resume();
 			}
 
-			//Call the list, advance to the next frame
+			//How many frames this sprite has
+			std::size_t frames() const {
+				return storage ? storage->frames.size() : 0;
+			}
+
+			//How much memory this sprite's art takes up, in bytes (shared by its copies)
+			std::size_t bytes() const {
+				return storage ? storage->bytes() : 0;
+			}
+
+			//The sprite's art (NULL if it has none)
+			const spritestorage* art() const {
+				return storage.get();
+			}
+
+			//Draw the current frame, advance to the next frame
 			void draw() {
-				glCallList(GLhandle.first + currentframe);
+				if (!storage)
+					return;
+				if (atlas)
+					draw(currentPixelsPerUnit());
+				else {
+					storage->draw(currentframe);
+					tick();
+				}
+			}
+
+			//Draw the current frame as if it covered some number of pixels per unit, advance to the next frame.
+			//Only atlases care about the scale: the frame is drawn from the atlas for its zoom bucket.
+			void draw(float pixelsPerUnit) {
+				if (!storage)
+					return;
+				if (!atlas || currentframe >= storage->keys.size()
+					|| !atlas->draw(storage->keys[currentframe], (*storage->source)[currentframe], pixelsPerUnit))
+					storage->draw(currentframe);
+				tick();
+			}
+
+			//Draw from textures baked into an atlas (frames are baked the first time they're drawn
+			//at each zoom), or pass NULL to go back to drawing the vectors
+			void drawFrom(const std::shared_ptr<atlascache>& cache) {
+				atlas = cache;
+			}
+
+			//Whether this sprite is drawn from an atlas
+			bool usingAtlas() const {
+				return atlas != NULL;
+			}
+
+			//Bake every frame into this sprite's atlas ahead of time, at some scales
+			void bake(const std::vector<float>& pixelsPerUnit) {
+				if (storage && atlas)
+					atlas->bake(*storage->source, pixelsPerUnit);
+			}
+
+			//Advance the frame clock without drawing
+			void tick() {
+				if (!storage)
+					return;
 				if (play) {
 					++frameclock;
 					if (frameclock > delay) {
 						frameclock = 0;
 						++currentframe;
-						if (currentframe > GLhandle.second) {
+						if (currentframe >= storage->frames.size()) {
 							if (cycle) {
 								currentframe = 0;
 							}
 							else {
-								--currentframe;
+								currentframe = storage->frames.size() ? unsigned(storage->frames.size()) - 1 : 0;
 								pause();
 							}
 						}
@@ -65,78 +204,42 @@ namespace fgr {
 				}
 			}
 
-			//Assignment operator
-			const sprite& operator=(const sprite& other) {
-				GLhandle = other.GLhandle;
-				defined = other.defined;
-				delay = other.delay;
-				currentframe = other.currentframe;
-				cycle = other.cycle;
-				play = other.play;
-				frameclock = other.frameclock;
-			}
-
 			// CONSTRUCTORS
 			//Default constructor
 			sprite() {
 				currentframe = 0;
 				cycle = true;
 				play = true;
-				GLhandle.first = 0;
-				GLhandle.second = 0;
 				delay = 0;
-				defined = false;
 				frameclock = 0;
 			}
 
-			//Construct from an animation object
-			sprite(const animation& obj, bool timeclock_ = true, bool play_ = true) {
+			//Construct from an animation object (keep the art in memory rather than on the GPU to instance it)
+			sprite(const animation& obj, bool timeclock_ = true, bool play_ = true, bool onGPU = true) {
 				currentframe = 0;
 				frameclock = 0;
 				cycle = obj.cycle;
 				play = play_;
-				GLhandle = compile(obj);
+				storage = std::make_shared<spritestorage>(obj, onGPU);
 				if (obj.size())
 					delay = obj.front().delay;
 				else
 					delay = 100;
-				defined = true;
 			}
 
 			//Construct from a graphic object
 			sprite(const graphic& obj) {
-				currentframe = 0;
-				frameclock = 0;
-				cycle = false;
-				play = false;
-				delay = 100;
-				GLhandle.first = compile(obj);
-				GLhandle.second = 1;
-				defined = true;
+				*this = still(obj);
 			}
 
 			//Construct from a shape object
 			sprite(const shape& obj) {
-				currentframe = 0;
-				frameclock = 0;
-				cycle = false;
-				play = false;
-				delay = 100;
-				GLhandle.first = compile(obj);
-				GLhandle.second = 1;
-				defined = true;
+				*this = still(graphic(obj));
 			}
 
 			//Construct from a glyph object
 			sprite(const glyph& obj) {
-				currentframe = 0;
-				frameclock = 0;
-				cycle = false;
-				play = false;
-				delay = 100;
-				GLhandle.first = compile(obj);
-				GLhandle.second = 1;
-				defined = true;
+				*this = still(graphic(shape(obj)));
 			}
 
 			//Construct from a file path
@@ -155,18 +258,21 @@ namespace fgr {
 					fgr::graphic obj;
 					graphicFromFile(obj, path);
 					*this = sprite(obj);
+					return;
 				}
 				case 'h': {
 					//Treat this as a shape
 					fgr::shape obj;
 					shapeFromFile(obj, path);
 					*this = sprite(obj);
+					return;
 				}
 				case 'l': {
 					//Treat this as a glyph
 					fgr::glyph obj;
 					glyphFromFile(obj, path);
 					*this = sprite(obj);
+					return;
 				}
 				default:
 					//This is an error, but we won't kill the program
@@ -176,114 +282,104 @@ namespace fgr {
 			}
 
 			// OTHER FUNCTIONS
-			//Free up the GPU space that was taken up by this sprite
+			//Let go of this sprite's art (the GPU space is freed once no copy is using it)
 			void cleanup() {
-				if (defined) {
-					glDeleteLists(GLhandle.first, GLhandle.second);
-					defined = false;
-				}
-				return;
+				storage.reset();
+				atlas.reset();
 			}
 
-			//DESTRUCTOR
-			~sprite() {
-				cleanup();
+		private:
+			//A sprite that shows one graphic and never moves on
+			static sprite still(const graphic& obj) {
+				animation art;
+				art.front() = frame(obj);
+				sprite rets(art, true, false);
+				rets.cycle = false;
+				rets.delay = 100;
+				return rets;
 			}
 
 		};
 
-		//A set of instructions that may have different lengths and delay times.
+		/* A sprite that moves about the way a painting component does. Its oscillations are worked
+		 * out from the time whenever it's drawn (see fgr::pose), so it takes the same tiny amount of
+		 * memory however slow they are, and can be drawn at any moment (forwards, backwards or
+		 * skipping about). */
 		class motionsprite {
 		public:
 			sprite artframes;
-			sprite xpososcillationframes;
-			sprite ypososcillationframes;
-			sprite rotoscillationframes;
-			sprite scaleoscillationframes;
-			//sprite pathframes; ///Still needs to be implemented
-			//Draw this sprite
-			void draw() {
+			//The component's placement and oscillations, without its art
+			component motion;
+			//How many times a second draw() is called
+			float framerate;
+			//Seconds since the motion began
+			double clock;
+
+			//The component's transform at some time, in seconds
+			affine pose(double seconds) const {
+				return fgr::pose(motion, seconds);
+			}
+			//Apply the component's transform at some time, in seconds
+			void transform(double seconds) const {
+				multMatrix(pose(seconds));
+			}
+			//Draw this sprite as it is at some time, in seconds
+			void draw(double seconds) {
 				glPushMatrix();
-					//pathframes.draw();
-					xpososcillationframes.draw();
-					ypososcillationframes.draw();
-					rotoscillationframes.draw();
-					scaleoscillationframes.draw();
+					transform(seconds);
 					artframes.draw();
 				glPopMatrix();
 			}
+			//Draw this sprite, then move its clock on by a frame
+			void draw() {
+				draw(clock);
+				clock += 1.0 / framerate;
+			}
+			//Move the art and the clock on by a frame without drawing
+			void tick() {
+				artframes.tick();
+				clock += 1.0 / framerate;
+			}
+			//Jump to some time, in seconds
+			void seek(double seconds) {
+				clock = seconds;
+			}
 			//Constructors
+			motionsprite() {
+				motion.clear();
+				framerate = 60.0f;
+				clock = 0.0;
+			}
 			motionsprite(const component& art, float framerate = 60.0f) {
-				artframes = sprite(art);
-				//The size of the oscillation array, in frames
-				GLsizei resolution;
-
-				//X-positional oscillation
-				if (art.posfreq.x() > 0.001) {
-					resolution = framerate / art.posfreq.x();
-					xpososcillationframes = sprite();
-					xpososcillationframes.GLhandle.first = glGenLists(resolution);
-					xpososcillationframes.GLhandle.second = resolution;
-					for (GLuint i = 0; i < resolution; ++i) {
-						glNewList(xpososcillationframes.GLhandle.first + i, GL_COMPILE);
-							glTranslatef(art.position.x() + art.posamp.x() * cosf(float(i) / float(resolution) * (PI * 2)), 0.0f, 0.0f);
-						glEndList();
-					}
-					xpososcillationframes.defined = true;
-				}
-
-				//Y-positional oscillation
-				if (art.posfreq.y() > 0.001)
-					resolution = framerate / art.posfreq.y();
-				else
-					resolution = 0;
-				ypososcillationframes = sprite();
-				ypososcillationframes.GLhandle.first = glGenLists(resolution);
-				ypososcillationframes.GLhandle.second = resolution;
-				for (GLuint i = 0; i < resolution; ++i) {
-					glNewList(ypososcillationframes.GLhandle.first + i, GL_COMPILE);
-						glTranslatef(0.0f, art.position.y() + art.posamp.y * (float(i) / float(resolution) * (PI * 2)), 0.0f);
-					glEndList();
-				}
-				ypososcillationframes.defined = true;
-
-				//Rotational oscillation
-				if (art.rotfreq > 0.001) {
-					resolution = framerate / art.rotfreq;
-					rotoscillationframes = sprite();
-					rotoscillationframes.GLhandle.first = glGenLists(resolution);
-					rotoscillationframes.GLhandle.second = resolution;
-					for (GLuint i = 0; i < resolution; ++i) {
-						glNewList(rotoscillationframes.GLhandle.first + i, GL_COMPILE);
-							glRotatef(art.rotation + float(i) / float(resolution) * 360.0f, 0.0f, 0.0f, 1.0f);
-						glEndList();
-					}
-					rotoscillationframes.defined = true;
-				}
-
-				//Scaling oscillation
-				if (art.scalefreq > 0.001) {
-					resolution = framerate / art.scalefreq;
-					scaleoscillationframes = sprite();
-					scaleoscillationframes.GLhandle.first = glGenLists(resolution);
-					scaleoscillationframes.GLhandle.second = resolution;
-					float magnitude;
-					for (GLuint i = 0; i < resolution; ++i) {
-						glNewList(scaleoscillationframes.GLhandle.first + i, GL_COMPILE);
-							magnitude = art.scale + art.scaleamp * sinf(float(i) / float(resolution) * (PI * 2));
-							glScalef(magnitude, magnitude, magnitude);
-						glEndList();
-					}
-					scaleoscillationframes.defined = true;
-				}
-
+				*this = motionsprite(art, sprite(art), framerate);
+			}
+			//Move some component about, drawn with art that may be shared with other motionsprites
+			motionsprite(const component& art, const sprite& shared, float framerate = 60.0f) : artframes(shared), motion(art) {
+				motion.clear();
+				motion.shrink_to_fit();
+				//Copying an animation finds its current frame by walking up to it, so it mustn't be left dangling
+				motion.currentframe = motion.begin();
+				this->framerate = framerate > 0.0f ? framerate : 60.0f;
+				clock = 0.0;
 			}
 		};
 
-		//A compiled image class with many moving parts
+		/* A compiled image class with many moving parts. Components with identical art share it,
+		 * and the whole painting is drawn by instancing: every component's transform is worked out
+		 * on the CPU into an instance buffer, its current frame is streamed through that into one
+		 * vertex buffer, and runs that draw the same way are merged wherever that doesn't change
+		 * what overlaps what (see instancebatch), so a painting takes few draw calls. */
 		class multisprite {
 			//These are the video data's many dimensions
 			std::vector<motionsprite> video;
+			//Where every component is this frame (the instance buffer)
+			std::vector<affine> instances;
+			//This frame's vertices, already transformed, and the calls that draw them
+			std::vector<colorvertex> vertices;
+			std::vector<vertexrun> runs;
+			instancebatch batch;
+			//Shared between copies, since it's refilled on every draw anyway
+			std::shared_ptr<vertexstream> stream;
 		public:
 			// CONSTRUCTORS
 			//Default constructor
@@ -293,11 +389,87 @@ namespace fgr {
 
 			//Construct from a painting
 			multisprite(const fgr::painting& art, float framerate = 60.0f) {
-				video.resize(art.size());
-				int i = 0;
-				for (painting::const_iterator itr = art.begin(); itr != art.end(); ++itr, ++i) {
-					video[i] = motionsprite(*itr, framerate);
+				//Every distinct animation so far, by fingerprint (which only suggests they match, so they're compared too)
+				typedef std::unordered_multimap<std::size_t, std::pair<const animation*, sprite> > spritemap;
+				spritemap shared;
+				video.reserve(art.size());
+				for (painting::const_iterator itr = art.begin(); itr != art.end(); ++itr) {
+					std::size_t key = fingerprint(*itr);
+					std::pair<spritemap::iterator, spritemap::iterator> candidates = shared.equal_range(key);
+					spritemap::iterator found = candidates.first;
+					while (found != candidates.second && !sameArt(*found->second.first, *itr))
+						++found;
+					if (found == candidates.second)
+						found = shared.insert(std::make_pair(key, std::make_pair((const animation*)&*itr, sprite(*itr, true, true, false))));
+					video.push_back(motionsprite(*itr, found->second.second, framerate));
+				}
+			}
+
+			// OTHER FUNCTIONS
+			//Work out where every component is, and stream their current frames into one vertex list.
+			//'pixelsPerUnit' is how big the painting is on screen (0 if unknown).
+			void prepare(float pixelsPerUnit = 0.0f) {
+				instances.resize(video.size());
+				for (std::size_t i = 0; i < video.size(); ++i)
+					instances[i] = video[i].pose(video[i].clock);
+				batch.clear(pixelsPerUnit > 0.0f ? 1.0f / pixelsPerUnit : 0.0f);
+				for (std::size_t i = 0; i < video.size(); ++i) {
+					const spritestorage* art = video[i].artframes.art();
+					if (art)
+						batch.append(*art, video[i].artframes.currentframe, instances[i]);
+				}
+				batch.finish(vertices, runs);
+			}
+
+			//Draw every component, then move them all on by a frame
+			void draw() {
+				prepare(currentPixelsPerUnit());
+				if (!stream)
+					stream = std::make_shared<vertexstream>();
+				stream->draw(vertices, runs);
+				tick();
+			}
+
+			//Move every component on by a frame without drawing
+			void tick() {
+				for (std::size_t i = 0; i < video.size(); ++i)
+					video[i].tick();
+			}
+
+			//Jump every component to some time, in seconds
+			void seek(double seconds) {
+				for (std::size_t i = 0; i < video.size(); ++i)
+					video[i].seek(seconds);
+			}
+
+			//How many components there are
+			std::size_t components() const {
+				return video.size();
+			}
+
+			//One of the components
+			const motionsprite& part(std::size_t i) const {
+				return video[i];
+			}
+
+			//How many draw calls the last frame took
+			std::size_t drawCalls() const {
+				return runs.size();
+			}
+
+			//How much memory the art and this frame's vertices take up, in bytes (shared art is counted once)
+			std::size_t bytes() const {
+				std::size_t total = instances.capacity() * sizeof(affine) + vertices.capacity() * sizeof(colorvertex)
+					+ runs.capacity() * sizeof(vertexrun) + batch.bytes();
+				std::vector<const spritestorage*> counted;
+				for (std::size_t i = 0; i < video.size(); ++i) {
+					const spritestorage* art = video[i].artframes.art();
+					if (art && std::find(counted.begin(), counted.end(), art) == counted.end()) {
+						counted.push_back(art);
+						total += art->bytes();
+					}
 				}
+				return total;
 			}
 
 		};
@@ -21,6 +21,59 @@ namespace fgr {
 		//The maximum number of rooms that can be loaded in at once.
 		const unsigned int max_rooms = 16;
 
+		///////////////////////////////////////////////////////////
+		//
+		//           Class prop DEFINITION
+		//
+		//				These are objects that can be interacted
+		//				with (or not) in the world
+		//
+		///////////////////////////////////////////////////////////
+
+		//When a prop is loaded, it knows what function to associate with using this.
+		std::map < std::string, void(*)(prop& object)> prop_functions;
+
+		//These give life to the world
+		class prop : public fgr::spritesheet {	//DP: I think the prop should have a spritesheet, rather than be a spritesheet
+		public:
+			// REPRESENTATION
+			//Structures the graphics of this prop
+			fgr::spritesheet appearance;
+			//Identical to the filepath this was loaded from
+			std::string name;
+			//Position relative to the room's origin point
+			fgr::point position;
+			//Whether or not this prop can be moved.
+			bool movable;
+			//Which layer this prop is drawn in (higher layers are drawn over lower ones)
+			int layer;
+			//Which frame of its sprite this prop is showing
+			unsigned int currentframe;
+			//How many times this prop remembers being interacted with by the player previously
+			int interactionCount;
+			//Local 'variables' for this prop
+			std::map<std::string, std::string> variables;
+			//This function will be called when the player interacts with this prop
+			void(*interact_func)(prop& object);	//DP: Does a prop need to be passed in?
+
+			// MEMBER FUNCTIONS
+			//CONSTURCTORS
+			//Default constructor
+			prop();
+			//Construct from a file path
+			prop(const std::string& path);
+			//Call this when the player interacts with the prop (confusing I know)
+			void interact();
+		};
+		
+		//The following function should be used during program initialization
+		//To map an interaction function to any prop loaded with that name
+		void setPropFunc(const std::string& propname, void(*interact_func)(prop& object)) {
+			prop_functions[propname] = interact_func;
+			return;
+		}
+
+
 		///////////////////////////////////////////////////////////
 		//
 		//           Class room DEFINITION
@@ -49,7 +102,8 @@ namespace fgr {
 			//How far from the player's location we have found this room to be
 			unsigned short traversalDistance;
 
-			//DP: Shouldn't the room have some props in it?
+			//The props sitting in this room
+			std::vector<prop> props;
 
 			// FUNCTIONS
 			//CONSTRUCTORS
@@ -107,55 +161,6 @@ namespace fgr {
 			void cleanup();
 		};
 
-		///////////////////////////////////////////////////////////
-		//
-		//           Class prop DEFINITION
-		//
-		//				These are objects that can be interacted
-		//				with (or not) in the world
-		//
-		///////////////////////////////////////////////////////////
-
-		//When a prop is loaded, it knows what function to associate with using this.
-		std::map < std::string, void(*)(prop& object)> prop_functions;
-
-		//These give life to the world
-		class prop : public fgr::spritesheet {	//DP: I think the prop should have a spritesheet, rather than be a spritesheet
-		public:
-			// REPRESENTATION
-			//Structures the graphics of this prop
-			fgr::spritesheet appearance;
-			//Identical to the filepath this was loaded from
-			std::string name;
-			//Position relative to the room's origin point
-			fgr::point position;
-			//Whether or not this prop can be moved.
-			bool movable;
-			//How many times this prop remembers being interacted with by the player previously
-			int interactionCount;
-			//Local 'variables' for this prop
-			std::map<std::string, std::string> variables;
-			//This function will be called when the player interacts with this prop
-			void(*interact_func)(prop& object);	//DP: Does a prop need to be passed in?
-
-			// MEMBER FUNCTIONS
-			//CONSTURCTORS
-			//Default constructor
-			prop();
-			//Construct from a file path
-			prop(const std::string& path);
-			//Call this when the player interacts with the prop (confusing I know)
-			void interact();
-		};
-		
-		//The following function should be used during program initialization
-		//To map an interaction function to any prop loaded with that name
-		void setPropFunc(const std::string& propname, void(*interact_func)(prop& object)) {
-			prop_functions[propname] = interact_func;
-			return;
-		}
-
-
 		///////////////////////////////////////////////////////////
 		//
 		//           Class door DEFINITION
@@ -277,6 +282,8 @@ namespace fgr {
 		// PROP CLASS IMPLEMENTATION
 		prop::prop() {
 			movable = false;
+			layer = 0;
+			currentframe = 0;
 			interact_func = NULL;
 			interactionCount = 0;
 		}
@@ -0,0 +1,380 @@
+/* This header file defines the room renderer, which draws everything in a room in a few draw
+ * calls. Every visible prop and background component is flattened into world space, and its
+ * runs are sorted into batches by layer and then by material (all the fixed-function pipeline
+ * has to change between calls: the primitive, and the line width or point size). The
+ * background keeps its painter's order: a run that overlaps one before it is put in a
+ * sublayer above it. A prop is only flattened again when it moves, changes frame or changes
+ * sprite, and a batch is only gathered and uploaded again when something in it changed. */
+#pragma once
+
+#ifndef __FGR_ROOM_RENDERER_H__
+#define __FGR_ROOM_RENDERER_H__
+
+#include "fgrgamegraphics.h"
+#include "fgroverworld.h"
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <climits>
+#include <algorithm>
+
+namespace fgr {
+
+	namespace game {
+
+		//The layer background components are drawn in, beneath every prop
+		const int BACKGROUND_LAYER = INT_MIN;
+
+		/* Draws rooms with one call per layer and material. Within a layer of props, fills are
+		 * drawn before lines and lines before points, but nothing else about their order is
+		 * promised: props that must overlap a particular way belong on different layers. The
+		 * background is drawn just as it would be in painter's order, in as few sublayers as
+		 * that takes. Props are told apart by where they are in memory, so taking one out of the
+		 * middle of a room's list means the ones after it are flattened again. */
+		class roomrenderer {
+		public:
+			// CONSTRUCTORS
+			//Default constructor
+			roomrenderer() {
+				frameNumber = 0;
+				calls = 0;
+				rebuiltItems = 0;
+				rebuiltBatches = 0;
+				visibleItems = 0;
+			}
+
+			// FUNCTIONS
+			//Work out what a room looks like through some view: flatten whatever changed, and
+			//gather again the batches that it touched. Doesn't need OpenGL.
+			void prepare(const room& place, const segment& view) {
+				++frameNumber;
+				rebuiltItems = 0;
+				rebuiltBatches = 0;
+				backgroundOrder.clear();
+				for (std::size_t i = 0; i < place.background.components(); ++i) {
+					const motionsprite& part = place.background.part(i);
+					const spritestorage* art = part.artframes.art();
+					if (!art)
+						continue;
+					snapshot state = { std::size_t(art), part.artframes.currentframe, part.pose(part.clock), BACKGROUND_LAYER };
+					backgroundOrder.push_back(&visit(&part, state, *art, view));
+				}
+				for (std::size_t i = 0; i < place.props.size(); ++i) {
+					const prop& thing = place.props[i];
+					const animation* costume = thing.appearance.wearing();
+					if (!costume)
+						continue;
+					wornart& flat = propArt[thing.appearance.wearingSerial()];
+					if (!flat.art)
+						flat.art = std::make_shared<vertexart>(*costume);
+					flat.seen = frameNumber;
+					snapshot state = { thing.appearance.wearingSerial(), thing.currentframe,
+						affine(1.0f, 0.0f, 0.0f, 1.0f, thing.position.x(), thing.position.y()), thing.layer };
+					visit(&thing, state, *flat.art, view);
+				}
+				//Whatever wasn't in the room this frame is gone
+				for (std::map<const void*, item>::iterator itr = items.begin(); itr != items.end();) {
+					if (itr->second.seen == frameNumber) {
+						++itr;
+						continue;
+					}
+					if (itr->second.visible)
+						touch(itr->second);
+					itr = items.erase(itr);
+				}
+				layBackground();
+				//Gather the batches that changed, from every visible item
+				for (std::map<material, batch>::iterator b = batches.begin(); b != batches.end(); ++b) {
+					if (b->second.dirty)
+						b->second.vertices.clear();
+				}
+				visibleItems = 0;
+				for (std::map<const void*, item>::const_iterator itr = items.begin(); itr != items.end(); ++itr) {
+					const item& thing = itr->second;
+					if (!thing.visible)
+						continue;
+					++visibleItems;
+					for (std::size_t r = 0; r < thing.runs.size(); ++r) {
+						batch& into = batches[materialOf(thing, r)];
+						if (into.dirty)
+							into.vertices.insert(into.vertices.end(), thing.vertices.begin() + thing.runs[r].first,
+								thing.vertices.begin() + thing.runs[r].first + thing.runs[r].count);
+					}
+				}
+				calls = 0;
+				for (std::map<material, batch>::iterator b = batches.begin(); b != batches.end(); ++b) {
+					if (b->second.dirty) {
+						b->second.dirty = false;
+						b->second.uploaded = false;
+						++rebuiltBatches;
+					}
+					if (!b->second.vertices.empty())
+						++calls;
+				}
+				//Sprites nothing is wearing any more
+				for (std::map<std::size_t, wornart>::iterator itr = propArt.begin(); itr != propArt.end();) {
+					if (itr->second.seen != frameNumber)
+						itr = propArt.erase(itr);
+					else
+						++itr;
+				}
+			}
+
+			//Draw what was prepared, uploading only the batches that changed
+			void submit() {
+				bool buffers = glext::loadBuffers();
+				for (std::map<material, batch>::iterator b = batches.begin(); b != batches.end(); ++b) {
+					batch& group = b->second;
+					if (group.vertices.empty())
+						continue;
+					vertexrun run;
+					run.mode = b->first.mode;
+					run.first = 0;
+					run.count = GLsizei(group.vertices.size());
+					run.lineWidth = b->first.size;
+					run.pointSize = b->first.size;
+					if (!buffers) {
+						drawRuns(&group.vertices[0], &run, 1);
+						continue;
+					}
+					if (!group.buffer)
+						glext::genBuffers(1, &group.buffer);
+					glext::bindBuffer(GL_ARRAY_BUFFER, group.buffer);
+					if (!group.uploaded) {
+						glext::bufferData(GL_ARRAY_BUFFER, std::ptrdiff_t(group.vertices.size() * sizeof(colorvertex)),
+							&group.vertices[0], GL_DYNAMIC_DRAW);
+						group.uploaded = true;
+					}
+					drawRuns(NULL, &run, 1);
+					glext::bindBuffer(GL_ARRAY_BUFFER, 0);
+				}
+			}
+
+			//Draw a room as seen through some view, then move its background on by a frame
+			void draw(room& place, const segment& view) {
+				prepare(place, view);
+				submit();
+				place.background.tick();
+			}
+
+			//Forget every cached vertex (call this after editing art that's being drawn)
+			void invalidate() {
+				items.clear();
+				propArt.clear();
+				for (std::map<material, batch>::iterator b = batches.begin(); b != batches.end(); ++b)
+					b->second.dirty = true;
+			}
+
+			// STATISTICS (about the last prepare)
+			//How many draw calls the room takes
+			std::size_t drawCalls() const { return calls; }
+			//How many props and background components had to be flattened again
+			std::size_t itemsRebuilt() const { return rebuiltItems; }
+			//How many batches had to be gathered again
+			std::size_t batchesRebuilt() const { return rebuiltBatches; }
+			//How many props and background components were in view
+			std::size_t itemsVisible() const { return visibleItems; }
+
+			//DESTRUCTOR
+			~roomrenderer() {
+				for (std::map<material, batch>::iterator b = batches.begin(); b != batches.end(); ++b) {
+					if (b->second.buffer)
+						glext::deleteBuffers(1, &b->second.buffer);
+				}
+			}
+
+		private:
+			//What batches are sorted by: layer and sublayer, then fills before lines before points, then width
+			struct material {
+				int layer;
+				int sublayer;
+				int rank;
+				GLenum mode;
+				GLfloat size;
+				bool operator<(const material& other) const {
+					if (layer != other.layer) return layer < other.layer;
+					if (sublayer != other.sublayer) return sublayer < other.sublayer;
+					if (rank != other.rank) return rank < other.rank;
+					if (mode != other.mode) return mode < other.mode;
+					return size < other.size;
+				}
+			};
+			//What a prop or background component looked like when it was last flattened (its art is
+			//told apart by the art's address for the background, and the costume's serial for props)
+			struct snapshot {
+				std::size_t art;
+				std::size_t frame;
+				affine where;
+				int layer;
+				bool operator==(const snapshot& other) const {
+					return art == other.art && frame == other.frame && layer == other.layer
+						&& where.a == other.where.a && where.b == other.where.b && where.c == other.where.c
+						&& where.d == other.where.d && where.tx == other.where.tx && where.ty == other.where.ty;
+				}
+			};
+			//A prop or background component, flattened into the room
+			struct item {
+				snapshot state;
+				bool valid;
+				std::vector<colorvertex> vertices;
+				std::vector<vertexrun> runs;
+				//Where each run draws, and where they all do
+				std::vector<segment> runBounds;
+				segment bounds;
+				//The sublayer each run is drawn in (none for props, which are all in sublayer 0)
+				std::vector<int> sublayers;
+				bool visible;
+				std::size_t seen;
+				item() {
+					valid = false;
+					visible = false;
+					seen = 0;
+				}
+			};
+			//Every vertex of one layer and material
+			struct batch {
+				std::vector<colorvertex> vertices;
+				bool dirty;
+				bool uploaded;
+				GLuint buffer;
+				batch() {
+					dirty = true;
+					uploaded = false;
+					buffer = 0;
+				}
+			};
+			std::map<const void*, item> items;
+			std::map<material, batch> batches;
+			//A prop's sprite, flattened once for every prop wearing it
+			struct wornart {
+				std::shared_ptr<vertexart> art;
+				std::size_t seen;
+			};
+			std::map<std::size_t, wornart> propArt;
+			//The background's items, in painter's order, and its runs laid out so far (see layBackground())
+			std::vector<item*> backgroundOrder;
+			struct laidrun {
+				segment bounds;
+				material look;
+			};
+			std::vector<laidrun> laid;
+			//How many runs before it a background run is checked against; it goes above all the others
+			static const std::size_t LOOKBACK = 256;
+			std::size_t frameNumber;
+			std::size_t calls;
+			std::size_t rebuiltItems;
+			std::size_t rebuiltBatches;
+			std::size_t visibleItems;
+
+			//Not copyable, since it owns buffers
+			roomrenderer(const roomrenderer&);
+			roomrenderer& operator=(const roomrenderer&);
+
+			static material materialOf(const vertexrun& run, int layer, int sublayer) {
+				material m;
+				m.layer = layer;
+				m.sublayer = sublayer;
+				m.mode = run.mode;
+				m.rank = run.mode == GL_POINTS ? 2 : run.mode == GL_LINES ? 1 : 0;
+				m.size = run.mode == GL_POINTS ? run.pointSize : run.mode == GL_LINES ? run.lineWidth : 0.0f;
+				return m;
+			}
+			static material materialOf(const item& thing, std::size_t run) {
+				return materialOf(thing.runs[run], thing.state.layer, run < thing.sublayers.size() ? thing.sublayers[run] : 0);
+			}
+			static bool overlaps(const segment& a, const segment& b) {
+				return a.p1.x() <= b.p2.x() && b.p1.x() <= a.p2.x() && a.p1.y() <= b.p2.y() && b.p1.y() <= a.p2.y();
+			}
+			//Mark the batches an item's runs fall in as needing to be gathered again
+			void touch(const item& thing) {
+				for (std::size_t r = 0; r < thing.runs.size(); ++r)
+					batches[materialOf(thing, r)].dirty = true;
+			}
+			/* Put every visible run of the background in the lowest sublayer that still draws it
+			 * after each run before it that it overlaps: the same one if that run's batch comes
+			 * first (or is its own), and the one above otherwise. Runs that don't overlap share
+			 * batches whatever order they come in. */
+			void layBackground() {
+				laid.clear();
+				//The lowest sublayer that's above every run too far back to be checked
+				int floor = 0;
+				std::vector<int> sublayers;
+				for (std::size_t i = 0; i < backgroundOrder.size(); ++i) {
+					item& thing = *backgroundOrder[i];
+					if (!thing.visible)
+						continue;
+					sublayers.resize(thing.runs.size());
+					for (std::size_t r = 0; r < thing.runs.size(); ++r) {
+						if (laid.size() > LOOKBACK)
+							floor = std::max(floor, laid[laid.size() - LOOKBACK - 1].look.sublayer + 1);
+						material look = materialOf(thing.runs[r], BACKGROUND_LAYER, 0);
+						int sublayer = floor;
+						for (std::size_t before = laid.size() > LOOKBACK ? laid.size() - LOOKBACK : 0; before < laid.size(); ++before) {
+							if (!overlaps(laid[before].bounds, thing.runBounds[r]))
+								continue;
+							material under = laid[before].look;
+							under.sublayer = 0;
+							sublayer = std::max(sublayer, laid[before].look.sublayer + (look < under ? 1 : 0));
+						}
+						sublayers[r] = sublayer;
+						look.sublayer = sublayer;
+						laidrun placed = { thing.runBounds[r], look };
+						laid.push_back(placed);
+					}
+					if (sublayers != thing.sublayers) {
+						touch(thing);
+						thing.sublayers = sublayers;
+						touch(thing);
+					}
+				}
+			}
+			//Bring an item up to date with how it looks now
+			item& visit(const void* key, const snapshot& state, const vertexart& art, const segment& view) {
+				item& thing = items[key];
+				bool changed = !thing.valid || !(thing.state == state);
+				if (changed) {
+					if (thing.visible)
+						touch(thing);
+					thing.vertices.clear();
+					thing.runs.clear();
+					art.appendInstance(state.frame, state.where, thing.vertices, thing.runs);
+					thing.runBounds.resize(thing.runs.size());
+					float left = 1e30f, bottom = 1e30f, right = -1e30f, top = -1e30f;
+					for (std::size_t r = 0; r < thing.runs.size(); ++r) {
+						float l = 1e30f, b = 1e30f, rt = -1e30f, t = -1e30f;
+						for (GLint v = thing.runs[r].first; v < thing.runs[r].first + thing.runs[r].count; ++v) {
+							l = std::min(l, thing.vertices[v].x);
+							b = std::min(b, thing.vertices[v].y);
+							rt = std::max(rt, thing.vertices[v].x);
+							t = std::max(t, thing.vertices[v].y);
+						}
+						thing.runBounds[r] = segment(l, b, rt, t);
+						left = std::min(left, l);
+						bottom = std::min(bottom, b);
+						right = std::max(right, rt);
+						top = std::max(top, t);
+					}
+					thing.bounds = segment(left, bottom, right, top);
+					thing.state = state;
+					thing.valid = true;
+					++rebuiltItems;
+				}
+				bool visible = !thing.vertices.empty()
+					&& thing.bounds.p2.x() >= view.p1.x() && thing.bounds.p1.x() <= view.p2.x()
+					&& thing.bounds.p2.y() >= view.p1.y() && thing.bounds.p1.y() <= view.p2.y();
+				if (visible && (changed || !thing.visible))
+					touch(thing);
+				else if (!visible && thing.visible && !changed)
+					touch(thing);
+				thing.visible = visible;
+				thing.seen = frameNumber;
+				return thing;
+			}
+		};
+
+	}
+
+}
+
+#endif
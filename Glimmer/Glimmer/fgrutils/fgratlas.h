@@ -0,0 +1,653 @@
+/* This header file bakes vector art into texture atlases, for art that's drawn at a handful of
+ * fixed scales. Frames are rasterized (anti-aliased) at the scale of a zoom bucket, packed
+ * into square pages with a skyline packer, and drawn as single textured quads. Each zoom bucket
+ * is a power of two in pixels per unit, and art is always baked at the bucket at or above the
+ * scale it's drawn at, so it's only ever shrunk. Baked frames are found by the fingerprint of
+ * their vector art, which stays the source of truth: edited art simply bakes again. Atlases
+ * can be baked ahead of time and saved, or baked a frame at a time as they're needed. */
+#pragma once
+
+#ifndef __FGR_ATLAS_H__
+#define __FGR_ATLAS_H__
+
+#include "fgrraster.h"
+#include "fgrparallel.h"
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+namespace fgr {
+
+	/* Packs rectangles into a fixed-size sheet, keeping only the "skyline" along the top of
+	 * what's been placed so far. Each rectangle goes wherever its top edge ends up lowest,
+	 * then leftmost. Good enough for sprite frames, and linear in the skyline's length. */
+	class rectpacker {
+	public:
+		// CONSTRUCTORS
+		rectpacker(int width = 0, int height = 0) {
+			reset(width, height);
+		}
+
+		// FUNCTIONS
+		//Start over with an empty sheet
+		void reset(int width, int height) {
+			this->width = width;
+			this->height = height;
+			used = 0;
+			skyline.clear();
+			span all = { 0, 0, width };
+			skyline.push_back(all);
+		}
+		//Find room for a w x h rectangle, returns false if there isn't any
+		bool place(int w, int h, int& x, int& y) {
+			if (w <= 0 || h <= 0 || w > width || h > height)
+				return false;
+			std::size_t best = skyline.size();
+			int bestTop = 0, bestBottom = height + 1;
+			for (std::size_t i = 0; i < skyline.size(); ++i) {
+				int top;
+				if (!fits(i, w, h, top))
+					continue;
+				if (top + h < bestBottom || (top + h == bestBottom && skyline[i].x < skyline[best].x)) {
+					best = i;
+					bestTop = top;
+					bestBottom = top + h;
+				}
+			}
+			if (best == skyline.size())
+				return false;
+			x = skyline[best].x;
+			y = bestTop;
+			span placed = { x, y + h, w };
+			skyline.insert(skyline.begin() + best, placed);
+			//Whatever the new span covers is now hidden beneath it
+			for (std::size_t i = best + 1; i < skyline.size();) {
+				int end = placed.x + placed.w;
+				if (skyline[i].x >= end)
+					break;
+				int cut = end - skyline[i].x;
+				if (cut >= skyline[i].w) {
+					skyline.erase(skyline.begin() + i);
+					continue;
+				}
+				skyline[i].x += cut;
+				skyline[i].w -= cut;
+				break;
+			}
+			//Neighbours at the same height become one span
+			for (std::size_t i = 0; i + 1 < skyline.size();) {
+				if (skyline[i].y == skyline[i + 1].y) {
+					skyline[i].w += skyline[i + 1].w;
+					skyline.erase(skyline.begin() + i + 1);
+				}
+				else
+					++i;
+			}
+			used += std::size_t(w) * h;
+			return true;
+		}
+		//How big the sheet is
+		int sheetWidth() const {
+			return width;
+		}
+		int sheetHeight() const {
+			return height;
+		}
+		//The fraction of the sheet that's been given out
+		float occupancy() const {
+			return width > 0 && height > 0 ? float(used) / (float(width) * float(height)) : 0.0f;
+		}
+
+		// SAVING AND LOADING
+		void save(FILE* stream) const {
+			std::int32_t header[3] = { width, height, std::int32_t(skyline.size()) };
+			fwrite(header, sizeof(std::int32_t), 3, stream);
+			std::uint64_t area = used;
+			fwrite(&area, sizeof(area), 1, stream);
+			for (std::size_t i = 0; i < skyline.size(); ++i) {
+				std::int32_t s[3] = { skyline[i].x, skyline[i].y, skyline[i].w };
+				fwrite(s, sizeof(std::int32_t), 3, stream);
+			}
+		}
+		bool load(FILE* stream) {
+			std::int32_t header[3];
+			std::uint64_t area;
+			if (fread(header, sizeof(std::int32_t), 3, stream) != 3 || fread(&area, sizeof(area), 1, stream) != 1
+				|| header[2] <= 0 || header[2] > header[0] + 1)
+				return false;
+			width = header[0];
+			height = header[1];
+			used = std::size_t(area);
+			skyline.resize(std::size_t(header[2]));
+			for (std::size_t i = 0; i < skyline.size(); ++i) {
+				std::int32_t s[3];
+				if (fread(s, sizeof(std::int32_t), 3, stream) != 3)
+					return false;
+				skyline[i].x = s[0];
+				skyline[i].y = s[1];
+				skyline[i].w = s[2];
+			}
+			return true;
+		}
+
+	private:
+		//A stretch of the skyline: everything beneath it is taken
+		struct span {
+			int x, y, w;
+		};
+		std::vector<span> skyline;
+		int width, height;
+		std::size_t used;
+
+		//Whether a w x h rectangle fits with its left edge at skyline span i, and if so where its top is
+		bool fits(std::size_t i, int w, int h, int& top) const {
+			if (skyline[i].x + w > width)
+				return false;
+			top = 0;
+			int left = w;
+			for (std::size_t j = i; left > 0; ++j) {
+				if (j == skyline.size())
+					return false;
+				top = std::max(top, skyline[j].y);
+				if (top + h > height)
+					return false;
+				left -= skyline[j].w;
+			}
+			return true;
+		}
+	};
+
+	//Where a baked frame is: its page, its pixels on that page, and the rectangle of the plane it shows
+	struct atlasregion {
+		std::size_t page;
+		int x, y, w, h;
+		segment world;
+	};
+
+	//A frame, rasterized and waiting to be packed
+	struct bakedimage {
+		int w, h;
+		segment world;
+		std::vector<unsigned char> rgba;
+	};
+
+	//Which zoom bucket a scale falls in (the power of two at or above it)
+	int zoomBucket(float pixelsPerUnit) {
+		if (!(pixelsPerUnit > 0.0f))
+			return 0;
+		return std::max(-16, std::min(16, int(ceilf(log2f(pixelsPerUnit) - 0.001f))));
+	}
+
+	//The scale art in some zoom bucket is baked at, in pixels per unit
+	float bucketScale(int bucket) {
+		return ldexpf(1.0f, bucket);
+	}
+
+	//How many pixels one unit of the plane covers on screen, going by the current OpenGL matrices
+	float currentPixelsPerUnit() {
+		GLfloat modelview[16], projection[16];
+		GLint viewport[4];
+		glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+		glGetFloatv(GL_PROJECTION_MATRIX, projection);
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		//Where the unit x vector ends up in clip space (fgr only uses orthographic projections)
+		float ex = projection[0] * modelview[0] + projection[4] * modelview[1];
+		float ey = projection[1] * modelview[0] + projection[5] * modelview[1];
+		return sqrtf(powf(ex * viewport[2] * 0.5f, 2.0f) + powf(ey * viewport[3] * 0.5f, 2.0f));
+	}
+
+	//Fingerprint of one frame of art, to find its baked copies by
+	std::size_t frameKey(const graphic& art) {
+		std::size_t hash = fingerprint(FINGERPRINT_SEED, float(art.size()));
+		for (graphic::const_iterator shp = art.begin(); shp != art.end(); ++shp)
+			hash = fingerprint(*shp, hash);
+		return hash;
+	}
+
+	/* Every frame baked at one scale, packed into pages. Pages are premultiplied RGBA, so
+	 * filtering never darkens the edges of art, and they're only uploaded to OpenGL when
+	 * something new has been packed into them (and then only the rows that changed). */
+	class textureatlas {
+	public:
+		//The page of frames with nothing to bake, or too big to: draw their vectors instead
+		static const std::size_t NO_PAGE = std::size_t(-1);
+
+		// CONSTRUCTORS
+		//Line widths and point sizes are multiplied by pixelScale, just as when exporting
+		textureatlas(float pixelsPerUnit = 1.0f, float pixelScale = 1.0f, int pageSize = 1024, int padding = 2) {
+			scale = pixelsPerUnit;
+			this->pixelScale = pixelScale;
+			this->pageSize = pageSize;
+			this->padding = padding;
+		}
+
+		// FUNCTIONS
+		//The scale frames are baked at, in pixels per unit
+		float pixelsPerUnit() const {
+			return scale;
+		}
+		//A frame that's already been baked (NULL if it hasn't)
+		const atlasregion* find(std::size_t key) const {
+			std::map<std::size_t, atlasregion>::const_iterator found = regions.find(key);
+			return found == regions.end() ? NULL : &found->second;
+		}
+		//Rasterize one frame at this atlas's scale. Touches nothing shared, so any thread can call it.
+		bakedimage rasterizeFrame(const graphic& art) const {
+			bakedimage rets;
+			rets.w = rets.h = 0;
+			segment bounds = vertexBounds(art);
+			if (!(bounds.p2.x() >= bounds.p1.x()) || !(bounds.p2.y() >= bounds.p1.y()))
+				return rets;
+			//Leave room for thick lines and big points to spill over the vertices
+			float spill = 1.0f;
+			for (graphic::const_iterator shp = art.begin(); shp != art.end(); ++shp)
+				spill = std::max(spill, std::max(shp->lineThickness, shp->pointSize) * pixelScale * 0.5f + 1.0f);
+			rets.w = int(ceilf(bounds.width() * scale + 2.0f * spill));
+			rets.h = int(ceilf(bounds.height() * scale + 2.0f * spill));
+			if (rets.w > MAX_PAGE || rets.h > MAX_PAGE) {
+				rets.w = rets.h = -1;
+				return rets;
+			}
+			//Keep pixels square, centered on the art
+			float cx = (bounds.p1.x() + bounds.p2.x()) * 0.5f, cy = (bounds.p1.y() + bounds.p2.y()) * 0.5f;
+			float hw = rets.w * 0.5f / scale, hh = rets.h * 0.5f / scale;
+			rets.world = segment(cx - hw, cy - hh, cx + hw, cy + hh);
+			rasterreport report;
+			rasterize(art, rets.world, rets.w, rets.h, pixelScale, fcolor(0.0f, 0.0f, 0.0f, 0.0f), rets.rgba, report, false);
+			return rets;
+		}
+		//Pack a rasterized frame into a page, and remember it by its key
+		const atlasregion& add(std::size_t key, const bakedimage& image) {
+			atlasregion where;
+			where.page = NO_PAGE;
+			where.x = where.y = where.w = where.h = 0;
+			where.world = image.world;
+			if (image.w > 0 && image.h > 0) {
+				where.w = image.w;
+				where.h = image.h;
+				int w = image.w + 2 * padding, h = image.h + 2 * padding;
+				for (std::size_t p = 0; p < pages.size() && where.page == NO_PAGE; ++p) {
+					if (pages[p]->packer.place(w, h, where.x, where.y))
+						where.page = p;
+				}
+				if (where.page == NO_PAGE) {
+					//Anything bigger than a page gets a page of its own
+					int size = pageSize;
+					while (size < w || size < h)
+						size *= 2;
+					pages.push_back(std::make_shared<page>(size));
+					pages.back()->packer.place(w, h, where.x, where.y);
+					where.page = pages.size() - 1;
+				}
+				where.x += padding;
+				where.y += padding;
+				pages[where.page]->blit(image, where.x, where.y);
+			}
+			return regions[key] = where;
+		}
+		//Bake one frame, unless it already has been
+		const atlasregion& bake(std::size_t key, const graphic& art) {
+			const atlasregion* found = find(key);
+			if (found)
+				return *found;
+			return add(key, rasterizeFrame(art));
+		}
+		//Bake many frames at once, rasterizing on every core (packing still happens in order)
+		void bakeAll(const std::vector<std::size_t>& keys, const std::vector<const graphic*>& art) {
+			std::vector<std::size_t> todo;
+			std::map<std::size_t, bool> queued;
+			for (std::size_t i = 0; i < keys.size() && i < art.size(); ++i) {
+				if (!find(keys[i]) && !queued[keys[i]]) {
+					queued[keys[i]] = true;
+					todo.push_back(i);
+				}
+			}
+			std::vector<bakedimage> images(todo.size());
+			parallel::forChunks(0, todo.size(), [&](std::size_t first, std::size_t last, unsigned int) {
+				for (std::size_t i = first; i < last; ++i)
+					images[i] = rasterizeFrame(*art[todo[i]]);
+			});
+			for (std::size_t i = 0; i < todo.size(); ++i)
+				add(keys[todo[i]], images[i]);
+		}
+		//Draw a baked frame as one textured quad, in the current matrix. Returns false if it has no pixels.
+		bool draw(const atlasregion& where) {
+			if (where.page >= pages.size())
+				return false;
+			page& sheet = *pages[where.page];
+			glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT | GL_CURRENT_BIT);
+			glEnable(GL_TEXTURE_2D);
+			sheet.bind();
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+			glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+			float s = 1.0f / sheet.size;
+			float u0 = where.x * s, u1 = (where.x + where.w) * s;
+			//Pages are stored top row first, so the top of the art is at the smaller v
+			float v0 = where.y * s, v1 = (where.y + where.h) * s;
+			glBegin(GL_QUADS);
+				glTexCoord2f(u0, v1); glVertex2f(where.world.p1.x(), where.world.p1.y());
+				glTexCoord2f(u1, v1); glVertex2f(where.world.p2.x(), where.world.p1.y());
+				glTexCoord2f(u1, v0); glVertex2f(where.world.p2.x(), where.world.p2.y());
+				glTexCoord2f(u0, v0); glVertex2f(where.world.p1.x(), where.world.p2.y());
+			glEnd();
+			++primitivesDrawn;
+			verticesDrawn += 4;
+			glPopAttrib();
+			return true;
+		}
+
+		// STATISTICS
+		std::size_t pageCount() const {
+			return pages.size();
+		}
+		std::size_t frameCount() const {
+			return regions.size();
+		}
+		//How much memory the pages take up, in bytes (the same again is on the GPU once they're drawn)
+		std::size_t bytes() const {
+			std::size_t total = sizeof(*this) + regions.size() * (sizeof(atlasregion) + 4 * sizeof(void*));
+			for (std::size_t p = 0; p < pages.size(); ++p)
+				total += pages[p]->rgba.size();
+			return total;
+		}
+		//The fraction of every page's pixels that's been given out
+		float occupancy() const {
+			float area = 0.0f, used = 0.0f;
+			for (std::size_t p = 0; p < pages.size(); ++p) {
+				float a = float(pages[p]->size) * float(pages[p]->size);
+				area += a;
+				used += pages[p]->packer.occupancy() * a;
+			}
+			return area > 0.0f ? used / area : 0.0f;
+		}
+		//A copy of one page, straight alpha and top row first, to look at or export
+		std::vector<unsigned char> pageImage(std::size_t p, int& size) const {
+			std::vector<unsigned char> rgba;
+			size = 0;
+			if (p >= pages.size())
+				return rgba;
+			size = pages[p]->size;
+			rgba = pages[p]->rgba;
+			for (std::size_t i = 0; i < rgba.size(); i += 4) {
+				unsigned int a = rgba[i + 3];
+				for (int k = 0; k < 3; ++k)
+					rgba[i + k] = a ? (unsigned char)std::min(255u, (rgba[i + k] * 255u + a / 2) / a) : 0;
+			}
+			return rgba;
+		}
+
+		// SAVING AND LOADING
+		void save(FILE* stream) const {
+			float header[2] = { scale, pixelScale };
+			fwrite(header, sizeof(float), 2, stream);
+			std::int32_t sizes[3] = { pageSize, padding, std::int32_t(pages.size()) };
+			fwrite(sizes, sizeof(std::int32_t), 3, stream);
+			for (std::size_t p = 0; p < pages.size(); ++p) {
+				pages[p]->packer.save(stream);
+				fwrite(&pages[p]->rgba[0], 1, pages[p]->rgba.size(), stream);
+			}
+			std::uint64_t count = regions.size();
+			fwrite(&count, sizeof(count), 1, stream);
+			for (std::map<std::size_t, atlasregion>::const_iterator itr = regions.begin(); itr != regions.end(); ++itr) {
+				std::uint64_t ids[2] = { std::uint64_t(itr->first), itr->second.page == NO_PAGE ? ~std::uint64_t(0) : std::uint64_t(itr->second.page) };
+				fwrite(ids, sizeof(std::uint64_t), 2, stream);
+				std::int32_t box[4] = { itr->second.x, itr->second.y, itr->second.w, itr->second.h };
+				fwrite(box, sizeof(std::int32_t), 4, stream);
+				float world[4] = { itr->second.world.p1.x(), itr->second.world.p1.y(), itr->second.world.p2.x(), itr->second.world.p2.y() };
+				fwrite(world, sizeof(float), 4, stream);
+			}
+		}
+		bool load(FILE* stream) {
+			float header[2];
+			std::int32_t sizes[3];
+			if (fread(header, sizeof(float), 2, stream) != 2 || fread(sizes, sizeof(std::int32_t), 3, stream) != 3
+				|| sizes[0] <= 0 || sizes[0] > MAX_PAGE || sizes[2] < 0)
+				return false;
+			scale = header[0];
+			pixelScale = header[1];
+			pageSize = sizes[0];
+			padding = sizes[1];
+			pages.clear();
+			regions.clear();
+			for (std::int32_t p = 0; p < sizes[2]; ++p) {
+				rectpacker packer;
+				if (!packer.load(stream))
+					return false;
+				int size = packer.sheetWidth();
+				if (size <= 0 || size > MAX_PAGE || packer.sheetHeight() != size)
+					return false;
+				pages.push_back(std::make_shared<page>(size));
+				pages.back()->packer = packer;
+				if (fread(&pages.back()->rgba[0], 1, pages.back()->rgba.size(), stream) != pages.back()->rgba.size())
+					return false;
+			}
+			std::uint64_t count;
+			if (fread(&count, sizeof(count), 1, stream) != 1)
+				return false;
+			for (std::uint64_t i = 0; i < count; ++i) {
+				std::uint64_t ids[2];
+				std::int32_t box[4];
+				float world[4];
+				if (fread(ids, sizeof(std::uint64_t), 2, stream) != 2 || fread(box, sizeof(std::int32_t), 4, stream) != 4
+					|| fread(world, sizeof(float), 4, stream) != 4)
+					return false;
+				atlasregion& where = regions[std::size_t(ids[0])];
+				where.page = ids[1] == ~std::uint64_t(0) ? NO_PAGE : std::size_t(ids[1]);
+				if (where.page != NO_PAGE && where.page >= pages.size())
+					return false;
+				where.x = box[0];
+				where.y = box[1];
+				where.w = box[2];
+				where.h = box[3];
+				where.world = segment(world[0], world[1], world[2], world[3]);
+			}
+			return true;
+		}
+
+	private:
+		//The biggest page there can be (what every OpenGL implementation worth using can take)
+		static const int MAX_PAGE = 4096;
+
+		//One square sheet of baked frames
+		class page {
+		public:
+			int size;
+			std::vector<unsigned char> rgba;
+			rectpacker packer;
+			GLuint texture;
+			//Which rows have changed since the last upload
+			int dirtyTop, dirtyBottom;
+			page(int size) : rgba(std::size_t(size) * size * 4, 0), packer(size, size) {
+				this->size = size;
+				texture = 0;
+				dirtyTop = 0;
+				dirtyBottom = size;
+			}
+			//Copy a frame in (premultiplying it) at some pixel
+			void blit(const bakedimage& image, int x, int y) {
+				for (int row = 0; row < image.h; ++row) {
+					const unsigned char* from = &image.rgba[std::size_t(row) * image.w * 4];
+					unsigned char* to = &rgba[(std::size_t(y + row) * size + x) * 4];
+					for (int col = 0; col < image.w; ++col) {
+						unsigned int a = from[col * 4 + 3];
+						for (int k = 0; k < 3; ++k)
+							to[col * 4 + k] = (unsigned char)((from[col * 4 + k] * a + 127u) / 255u);
+						to[col * 4 + 3] = (unsigned char)a;
+					}
+				}
+				dirtyTop = std::min(dirtyTop, y);
+				dirtyBottom = std::max(dirtyBottom, y + image.h);
+			}
+			//Bind the page's texture, uploading whatever changed first
+			void bind() {
+				if (!texture) {
+					glGenTextures(1, &texture);
+					glBindTexture(GL_TEXTURE_2D, texture);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+					glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, &rgba[0]);
+					dirtyTop = size;
+					dirtyBottom = 0;
+					return;
+				}
+				glBindTexture(GL_TEXTURE_2D, texture);
+				if (dirtyTop < dirtyBottom) {
+					glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirtyTop, size, dirtyBottom - dirtyTop, GL_RGBA, GL_UNSIGNED_BYTE,
+						&rgba[std::size_t(dirtyTop) * size * 4]);
+					dirtyTop = size;
+					dirtyBottom = 0;
+				}
+			}
+			~page() {
+				if (texture)
+					glDeleteTextures(1, &texture);
+			}
+		private:
+			//Not copyable, since it owns a texture
+			page(const page&);
+			page& operator=(const page&);
+		};
+
+		std::vector<std::shared_ptr<page> > pages;
+		std::map<std::size_t, atlasregion> regions;
+		float scale;
+		float pixelScale;
+		int pageSize;
+		int padding;
+
+		//Not copyable, since its pages own textures
+		textureatlas(const textureatlas&);
+		textureatlas& operator=(const textureatlas&);
+	};
+
+	/* Texture atlases for every zoom bucket art has been drawn at. Frames are baked the first
+	 * time they're drawn at a bucket, or ahead of time with bake(), and the whole cache can be
+	 * saved to and loaded from a file. */
+	class atlascache {
+	public:
+		// CONSTRUCTORS
+		atlascache(float pixelScale = 1.0f, int pageSize = 1024) {
+			this->pixelScale = pixelScale;
+			this->pageSize = pageSize;
+		}
+
+		// FUNCTIONS
+		//The atlas for a zoom bucket (made empty if there isn't one yet)
+		textureatlas& bucket(int zoom) {
+			std::shared_ptr<textureatlas>& atlas = buckets[zoom];
+			if (!atlas)
+				atlas = std::make_shared<textureatlas>(bucketScale(zoom), pixelScale, pageSize);
+			return *atlas;
+		}
+		//Where a frame is baked for drawing at some scale, baking it if it hasn't been yet
+		const atlasregion& region(std::size_t key, const graphic& art, float pixelsPerUnit) {
+			return bucket(zoomBucket(pixelsPerUnit)).bake(key, art);
+		}
+		//Draw a frame from the atlas for the scale it's being drawn at, baking it if need be.
+		//Returns false if it couldn't be (too big, or empty), so the vectors should be drawn instead.
+		bool draw(std::size_t key, const graphic& art, float pixelsPerUnit) {
+			textureatlas& atlas = bucket(zoomBucket(pixelsPerUnit));
+			return atlas.draw(atlas.bake(key, art));
+		}
+		//Bake every frame of an animation at some scales ahead of time
+		void bake(const animation& art, const std::vector<float>& pixelsPerUnit) {
+			std::vector<std::size_t> keys;
+			std::vector<const graphic*> frames;
+			for (animation::const_iterator itr = art.begin(); itr != art.end(); ++itr) {
+				keys.push_back(frameKey(*itr));
+				frames.push_back(&*itr);
+			}
+			for (std::size_t z = 0; z < pixelsPerUnit.size(); ++z)
+				bucket(zoomBucket(pixelsPerUnit[z])).bakeAll(keys, frames);
+		}
+		//Forget everything that's been baked
+		void clear() {
+			buckets.clear();
+		}
+
+		// STATISTICS
+		std::size_t bytes() const {
+			std::size_t total = sizeof(*this);
+			for (std::map<int, std::shared_ptr<textureatlas> >::const_iterator itr = buckets.begin(); itr != buckets.end(); ++itr)
+				total += itr->second->bytes();
+			return total;
+		}
+		const std::map<int, std::shared_ptr<textureatlas> >& atlases() const {
+			return buckets;
+		}
+
+		// SAVING AND LOADING
+		//Write every atlas to a file, returns false if it couldn't be written
+		bool save(const std::string& path) const {
+			FILE* stream = NULL;
+			fopen_s(&stream, path.c_str(), "wb");
+			if (!stream)
+				return false;
+			fwrite(MAGIC, 1, 8, stream);
+			std::int32_t header[3] = { VERSION, std::int32_t(buckets.size()), pageSize };
+			fwrite(header, sizeof(std::int32_t), 3, stream);
+			fwrite(&pixelScale, sizeof(float), 1, stream);
+			for (std::map<int, std::shared_ptr<textureatlas> >::const_iterator itr = buckets.begin(); itr != buckets.end(); ++itr) {
+				std::int32_t zoom = itr->first;
+				fwrite(&zoom, sizeof(zoom), 1, stream);
+				itr->second->save(stream);
+			}
+			bool ok = !ferror(stream);
+			fclose(stream);
+			return ok;
+		}
+		//Read atlases back from a file (replacing any there are), returns false if it couldn't be read
+		bool load(const std::string& path) {
+			FILE* stream = NULL;
+			fopen_s(&stream, path.c_str(), "rb");
+			if (!stream)
+				return false;
+			char magic[8];
+			std::int32_t header[3];
+			float scale;
+			bool ok = fread(magic, 1, 8, stream) == 8 && !memcmp(magic, MAGIC, 8)
+				&& fread(header, sizeof(std::int32_t), 3, stream) == 3 && header[0] == VERSION && header[1] >= 0
+				&& fread(&scale, sizeof(float), 1, stream) == 1;
+			std::map<int, std::shared_ptr<textureatlas> > loaded;
+			for (std::int32_t i = 0; ok && i < header[1]; ++i) {
+				std::int32_t zoom;
+				std::shared_ptr<textureatlas> atlas = std::make_shared<textureatlas>();
+				ok = fread(&zoom, sizeof(zoom), 1, stream) == 1 && atlas->load(stream);
+				loaded[zoom] = atlas;
+			}
+			fclose(stream);
+			if (!ok)
+				return false;
+			buckets.swap(loaded);
+			pageSize = header[2];
+			pixelScale = scale;
+			return true;
+		}
+
+	private:
+		static const char MAGIC[8];
+		static const std::int32_t VERSION = 1;
+		std::map<int, std::shared_ptr<textureatlas> > buckets;
+		float pixelScale;
+		int pageSize;
+	};
+
+	const char atlascache::MAGIC[8] = { 'F', 'G', 'R', 'A', 'T', 'L', 'A', 'S' };
+
+}
+
+#endif
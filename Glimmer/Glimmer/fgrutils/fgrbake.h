@@ -0,0 +1,181 @@
+/* This header file defines methods for 'baking' a fractal into an ordinary graphic.
+ * The fractal's transforms are expanded breadth-first, one level at a time, until a
+ * vertex budget is used up. Every copy of the art is then merged into a single shape,
+ * so the result is as cheap to draw and save as any other graphic. */
+#pragma once
+
+#ifndef __FGR_BAKE_H__
+#define __FGR_BAKE_H__
+
+#include "fgrdrawing.h"
+#include "fgrparallel.h"
+
+#include <vector>
+#include <chrono>
+
+namespace fgr {
+
+	//Statistics about a finished bake
+	class bakereport {
+	public:
+		//How many copies of the art ended up in the graphic
+		unsigned long copies;
+		//How many levels of the fractal were (at least partly) expanded
+		int levels;
+		//How many vertices ended up in the graphic
+		unsigned long vertices;
+		//How many shapes ended up in the graphic
+		std::size_t shapes;
+		//How long the bake took, in milliseconds
+		float milliseconds;
+		//Default constructor
+		bakereport() {
+			copies = 0;
+			levels = 0;
+			vertices = 0;
+			shapes = 0;
+			milliseconds = 0.0f;
+		}
+	};
+
+	/* Rewrite a glyph as independent primitives (points, lines, triangles or quads) that draw the
+	 * same thing. Unlike strips, loops and fans, any number of these can be merged into one glyph.
+	 * Beziers are evaluated at the current BEZIER_RESOLUTION first. */
+	glyph separable(const glyph& obj) {
+		glyph art = obj.bezier ? evaluateBezier(obj, BEZIER_RESOLUTION) : obj;
+		std::vector<point> v(art.begin(), art.end());
+		std::size_t n = v.size();
+		glyph retg(glLines, glyphContainer());
+		switch (art.mode) {
+		case glPoints:
+			retg.mode = glPoints;
+			retg.insert(retg.end(), v.begin(), v.end());
+			break;
+		case glLines:
+			retg.insert(retg.end(), v.begin(), v.begin() + (n - n % 2));
+			break;
+		case glTriangles:
+			retg.mode = glTriangles;
+			retg.insert(retg.end(), v.begin(), v.begin() + (n - n % 3));
+			break;
+		case glQuads:
+			retg.mode = glQuads;
+			retg.insert(retg.end(), v.begin(), v.begin() + (n - n % 4));
+			break;
+		case glTriangleStrip:
+			//Every other triangle in a strip is wound the other way
+			retg.mode = glTriangles;
+			for (std::size_t i = 0; i + 2 < n; ++i) {
+				retg.push_back(v[i % 2 ? i + 1 : i]);
+				retg.push_back(v[i % 2 ? i : i + 1]);
+				retg.push_back(v[i + 2]);
+			}
+			break;
+		case glTriangleFan:
+		case glPolygon:
+			retg.mode = glTriangles;
+			for (std::size_t i = 1; i + 1 < n; ++i) {
+				retg.push_back(v[0]);
+				retg.push_back(v[i]);
+				retg.push_back(v[i + 1]);
+			}
+			break;
+		case glQuadStrip:
+			retg.mode = glQuads;
+			for (std::size_t i = 0; i + 3 < n; i += 2) {
+				retg.push_back(v[i]);
+				retg.push_back(v[i + 1]);
+				retg.push_back(v[i + 3]);
+				retg.push_back(v[i + 2]);
+			}
+			break;
+		case glLineLoop:
+		case glLineStrip:
+		default:
+			for (std::size_t i = 0; i + 1 < n; ++i) {
+				retg.push_back(v[i]);
+				retg.push_back(v[i + 1]);
+			}
+			//Close the loop
+			if (art.mode == glLineLoop && n > 2) {
+				retg.push_back(v[n - 1]);
+				retg.push_back(v[0]);
+			}
+			break;
+		}
+		return retg;
+	}
+
+	/* Bake a fractal into a graphic holding no more than maxVertices vertices. Levels are expanded
+	 * breadth-first (so the last level may only be partly there), with each level's transforms and
+	 * the final vertices generated in parallel. All copies share one merged shape. */
+	graphic bake(const fractal& pattern, unsigned long maxVertices, bakereport& report) {
+		std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+		report = bakereport();
+		//The art, flattened so copies can be merged
+		glyph unit = separable(pattern);
+		std::vector<float> xs, ys;
+		for (glyph::const_iterator itr = unit.begin(); itr != unit.end(); ++itr) {
+			xs.push_back(itr->x());
+			ys.push_back(itr->y());
+		}
+		std::size_t perCopy = xs.size();
+		graphic retg(shape(glyph(unit.mode, glyphContainer()), pattern.color, pattern.lineThickness, pattern.pointSize));
+		report.shapes = 1;
+		if (!perCopy || maxVertices < perCopy) {
+			report.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started).count();
+			return retg;
+		}
+		std::size_t copyBudget = maxVertices / perCopy;
+		std::vector<affine> maps;
+		for (std::size_t i = 0; i < pattern.branchPoints.size(); ++i) {
+			maps.push_back(pattern.branchPoints[i].transform());
+		}
+		//Expand the tree one level at a time; each child is its parent's transform followed by one branch
+		std::vector<affine> nodes(1, affine());
+		std::size_t levelStart = 0;
+		std::size_t levelEnd = 1;
+		report.levels = 1;
+		while (!maps.empty() && nodes.size() < copyBudget) {
+			std::size_t parents = levelEnd - levelStart;
+			std::size_t room = copyBudget - nodes.size();
+			std::size_t children = room;
+			if (parents <= room / maps.size())
+				children = parents * maps.size();
+			std::size_t base = nodes.size();
+			nodes.resize(base + children);
+			parallel::forChunks(0, children, [&](std::size_t first, std::size_t last, unsigned int) {
+				for (std::size_t j = first; j < last; ++j) {
+					nodes[base + j] = nodes[levelStart + j / maps.size()] * maps[j % maps.size()];
+				}
+			});
+			levelStart = base;
+			levelEnd = base + children;
+			++report.levels;
+		}
+		//Generate every copy's vertices, each worker into its own list, then splice them in order
+		std::vector<glyphContainer> pieces(parallel::workerCount());
+		parallel::forChunks(0, nodes.size(), [&](std::size_t first, std::size_t last, unsigned int worker) {
+			glyphContainer& piece = pieces[worker];
+			for (std::size_t n = first; n < last; ++n) {
+				const affine& f = nodes[n];
+				for (std::size_t i = 0; i < perCopy; ++i) {
+					float x = xs[i], y = ys[i];
+					f.apply(x, y);
+					piece.push_back(point(x, y));
+				}
+			}
+		});
+		shape& merged = retg.front();
+		for (std::size_t w = 0; w < pieces.size(); ++w) {
+			merged.splice(merged.end(), pieces[w]);
+		}
+		report.copies = (unsigned long)nodes.size();
+		report.vertices = (unsigned long)merged.size();
+		report.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started).count();
+		return retg;
+	}
+
+}
+
+#endif
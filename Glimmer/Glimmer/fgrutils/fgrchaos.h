@@ -0,0 +1,309 @@
+/* This header file implements the 'chaos game' method of rendering a fractal.
+ * Rather than recursively drawing every copy of the art (which costs
+ * branches^depth draw calls), random points on the art are pushed through random
+ * chains of the fractal's transforms and counted in a density buffer. The buffer
+ * is then tone-mapped and shown as a single texture. */
+#pragma once
+
+#ifndef __FGR_CHAOS_H__
+#define __FGR_CHAOS_H__
+
+#include "fgrdrawing.h"
+#include "fgrparallel.h"
+
+#include <vector>
+#include <utility>
+#include <chrono>
+#include <cstdint>
+
+namespace fgr {
+
+	//A tone-mapped density image of a point cloud, covering a rectangle of the plane
+	class pointcloud {
+	public:
+		// REPRESENTATION
+		//The area of the plane this cloud covers (p1 is bottom-left, p2 is top-right)
+		segment bounds;
+		//Resolution of the density buffer, in cells
+		int width;
+		int height;
+		//How many points landed in each cell, row by row from the bottom
+		std::vector<unsigned int> density;
+		//The most points that landed in any one cell
+		unsigned int peak;
+		//How many points were plotted into this cloud
+		unsigned long pointCount;
+		//How long it took to generate this cloud, in milliseconds
+		float milliseconds;
+		//GL texture holding the tone-mapped image (0 until first drawn)
+		mutable GLuint texture;
+		//True if the density buffer has changed since the texture was uploaded
+		mutable bool textureStale;
+
+		//Default constructor
+		pointcloud() {
+			width = 0;
+			height = 0;
+			peak = 0;
+			pointCount = 0;
+			milliseconds = 0.0f;
+			texture = 0;
+			textureStale = true;
+		}
+		//Copy constructor (the copy gets its own texture when it is first drawn)
+		pointcloud(const pointcloud& other) : bounds(other.bounds), density(other.density) {
+			width = other.width;
+			height = other.height;
+			peak = other.peak;
+			pointCount = other.pointCount;
+			milliseconds = other.milliseconds;
+			texture = 0;
+			textureStale = true;
+		}
+		//Assignment operator
+		pointcloud& operator= (const pointcloud& other) {
+			bounds = other.bounds;
+			density = other.density;
+			width = other.width;
+			height = other.height;
+			peak = other.peak;
+			pointCount = other.pointCount;
+			milliseconds = other.milliseconds;
+			textureStale = true;
+			return *this;
+		}
+		//Points generated per second in the last run, in millions
+		float megapointsPerSecond() const {
+			if (milliseconds <= 0.0f)
+				return 0.0f;
+			return float(pointCount) / (milliseconds * 1000.0f);
+		}
+		//Trade contents with another cloud, texture and all (nothing is copied or uploaded again)
+		void swap(pointcloud& other) {
+			std::swap(bounds, other.bounds);
+			density.swap(other.density);
+			std::swap(width, other.width);
+			std::swap(height, other.height);
+			std::swap(peak, other.peak);
+			std::swap(pointCount, other.pointCount);
+			std::swap(milliseconds, other.milliseconds);
+			std::swap(texture, other.texture);
+			std::swap(textureStale, other.textureStale);
+		}
+		//Free the GPU space taken up by this cloud
+		void cleanup() {
+			if (texture) {
+				glDeleteTextures(1, &texture);
+				texture = 0;
+			}
+			textureStale = true;
+		}
+		//DESTRUCTOR
+		~pointcloud() {
+			cleanup();
+		}
+	};
+
+	namespace chaos {
+
+		//A small, fast random number generator; each worker owns one
+		struct xorshift {
+			std::uint32_t state;
+			xorshift(std::uint32_t seed) {
+				state = seed ? seed : 0x9E3779B9u;
+			}
+			std::uint32_t next() {
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				return state;
+			}
+			//Uniform float on [0, 1)
+			float unit() {
+				return float(next() >> 8) * (1.0f / 16777216.0f);
+			}
+		};
+
+		//A flattened copy of a fractal's art that can be sampled uniformly along its length
+		struct sampler {
+			std::vector<float> xs;
+			std::vector<float> ys;
+			//Running length of the outline up to (and including) each edge
+			std::vector<float> lengths;
+			//True if only the vertices should be sampled
+			bool pointsOnly;
+
+			sampler(const glyph& art) {
+				for (glyph::const_iterator itr = art.begin(); itr != art.end(); ++itr) {
+					xs.push_back(itr->x());
+					ys.push_back(itr->y());
+				}
+				pointsOnly = art.mode == glPoints || xs.size() < 2;
+				//Closed modes also get the edge from the last vertex back to the first
+				bool closed = art.mode == glLineLoop || art.mode == glPolygon
+					|| art.mode == glTriangles || art.mode == glTriangleFan || art.mode == glQuads;
+				if (closed && xs.size() > 2) {
+					xs.push_back(xs.front());
+					ys.push_back(ys.front());
+				}
+				float total = 0.0f;
+				for (std::size_t i = 1; i < xs.size(); ++i) {
+					total += pyth(xs[i] - xs[i - 1], ys[i] - ys[i - 1]);
+					lengths.push_back(total);
+				}
+				//Degenerate outlines (every vertex in one spot) are sampled as points
+				if (total <= 0.0f)
+					pointsOnly = true;
+			}
+			//Pick a random spot on the art
+			void sample(xorshift& rng, float& x, float& y) const {
+				if (pointsOnly) {
+					std::size_t i = rng.next() % xs.size();
+					x = xs[i];
+					y = ys[i];
+					return;
+				}
+				float where = rng.unit() * lengths.back();
+				std::size_t edge = std::upper_bound(lengths.begin(), lengths.end(), where) - lengths.begin();
+				if (edge >= lengths.size())
+					edge = lengths.size() - 1;
+				float start = edge ? lengths[edge - 1] : 0.0f;
+				float span = lengths[edge] - start;
+				float t = span > 0.0f ? (where - start) / span : 0.0f;
+				x = xs[edge] + (xs[edge + 1] - xs[edge]) * t;
+				y = ys[edge] + (ys[edge + 1] - ys[edge]) * t;
+			}
+		};
+
+		//Cheap fingerprint of a fractal, used to decide whether a cached cloud is still valid
+		std::size_t signature(const fractal& pattern) {
+			std::size_t hash = fingerprint((const shape&)pattern);
+			for (std::size_t i = 0; i < pattern.branchPoints.size(); ++i) {
+				hash = fingerprint(hash, pattern.branchPoints[i].location.x());
+				hash = fingerprint(hash, pattern.branchPoints[i].location.y());
+				hash = fingerprint(hash, pattern.branchPoints[i].rotation);
+				hash = fingerprint(hash, pattern.branchPoints[i].scale);
+			}
+			return hash;
+		}
+
+	}
+
+	/* Play the chaos game: plot 'budget' points of the fractal into the cloud, using every core.
+	 * Each walk starts at a random spot on the art and applies up to depth - 1 random transforms,
+	 * plotting as it goes, so it covers exactly the copies draw(pattern, depth) would.
+	 * The cloud's bounds, width and height must be set beforehand. */
+	void chaosgame(const fractal& pattern, int depth, unsigned long budget, pointcloud& cloud) {
+		std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+		std::size_t cells = std::size_t(cloud.width > 0 ? cloud.width : 0) * std::size_t(cloud.height > 0 ? cloud.height : 0);
+		cloud.density.assign(cells, 0u);
+		cloud.peak = 0;
+		cloud.pointCount = 0;
+		cloud.textureStale = true;
+		if (!cells || !pattern.size() || depth <= 0 || !budget
+			|| cloud.bounds.width() <= 0.0f || cloud.bounds.height() <= 0.0f)
+			return;
+		//Flatten everything the workers will need
+		const chaos::sampler art(pattern.bezier ? evaluateBezier(pattern, BEZIER_RESOLUTION) : glyph(pattern));
+		if (art.xs.empty())
+			return;
+		std::vector<affine> maps;
+		for (std::size_t i = 0; i < pattern.branchPoints.size(); ++i) {
+			maps.push_back(pattern.branchPoints[i].transform());
+		}
+		const float left = cloud.bounds.p1.x();
+		const float bottom = cloud.bounds.p1.y();
+		const float xcells = float(cloud.width) / cloud.bounds.width();
+		const float ycells = float(cloud.height) / cloud.bounds.height();
+		const int width = cloud.width;
+		const int height = cloud.height;
+		//Every worker gets its own buffer so nobody fights over cache lines
+		std::vector<std::vector<unsigned int> > buffers(parallel::workerCount());
+		parallel::forChunks(0, budget, [&](std::size_t first, std::size_t last, unsigned int worker) {
+			std::vector<unsigned int>& buffer = buffers[worker];
+			buffer.assign(cells, 0u);
+			chaos::xorshift rng(0x2545F491u * (worker + 1));
+			float x = 0.0f, y = 0.0f;
+			int step = depth;
+			for (std::size_t n = first; n < last; ++n) {
+				//Start a new walk once this one is as deep as the recursion would go
+				if (step >= depth || maps.empty()) {
+					art.sample(rng, x, y);
+					step = 1;
+				}
+				else {
+					maps[rng.next() % maps.size()].apply(x, y);
+					++step;
+				}
+				int cx = int((x - left) * xcells);
+				int cy = int((y - bottom) * ycells);
+				if (cx >= 0 && cx < width && cy >= 0 && cy < height)
+					++buffer[std::size_t(cy) * width + cx];
+			}
+		});
+		//Sum the worker buffers together, again spread across every core
+		parallel::forChunks(0, cells, [&](std::size_t first, std::size_t last, unsigned int) {
+			for (std::size_t b = 0; b < buffers.size(); ++b) {
+				if (buffers[b].size() != cells)
+					continue;
+				for (std::size_t i = first; i < last; ++i) {
+					cloud.density[i] += buffers[b][i];
+				}
+			}
+		});
+		for (std::size_t i = 0; i < cells; ++i) {
+			if (cloud.density[i] > cloud.peak)
+				cloud.peak = cloud.density[i];
+		}
+		cloud.pointCount = budget;
+		cloud.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started).count();
+	}
+
+	//Use openGL to render a point cloud, tone-mapped logarithmically and tinted by a color
+	void draw(const pointcloud& obj, const fcolor& tint) {
+		if (!obj.width || !obj.height || obj.density.empty())
+			return;
+		if (!obj.texture) {
+			glGenTextures(1, &obj.texture);
+			obj.textureStale = true;
+		}
+		glBindTexture(GL_TEXTURE_2D, obj.texture);
+		if (obj.textureStale) {
+			//Dense cells approach the tint; sparse cells fade into the background
+			std::vector<unsigned char> pixels(obj.density.size() * 4);
+			float normal = obj.peak ? 1.0f / logf(1.0f + float(obj.peak)) : 0.0f;
+			unsigned char r = (unsigned char)(tint.getLevel('r') * 255.0f);
+			unsigned char g = (unsigned char)(tint.getLevel('g') * 255.0f);
+			unsigned char b = (unsigned char)(tint.getLevel('b') * 255.0f);
+			float a = tint.getLevel('a') * 255.0f;
+			for (std::size_t i = 0; i < obj.density.size(); ++i) {
+				pixels[i * 4 + 0] = r;
+				pixels[i * 4 + 1] = g;
+				pixels[i * 4 + 2] = b;
+				pixels[i * 4 + 3] = (unsigned char)(a * logf(1.0f + float(obj.density[i])) * normal);
+			}
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, obj.width, obj.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+			obj.textureStale = false;
+		}
+		glEnable(GL_TEXTURE_2D);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+		glBegin(GL_QUADS);
+			glTexCoord2f(0.0f, 0.0f); glVertex2f(obj.bounds.p1.x(), obj.bounds.p1.y());
+			glTexCoord2f(1.0f, 0.0f); glVertex2f(obj.bounds.p2.x(), obj.bounds.p1.y());
+			glTexCoord2f(1.0f, 1.0f); glVertex2f(obj.bounds.p2.x(), obj.bounds.p2.y());
+			glTexCoord2f(0.0f, 1.0f); glVertex2f(obj.bounds.p1.x(), obj.bounds.p2.y());
+		glEnd();
+		++primitivesDrawn;
+		verticesDrawn += 4;
+		glDisable(GL_BLEND);
+		glDisable(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+}
+
+#endif
@@ -14,6 +14,9 @@ user-friendly fgr manipulation*/
 #include <map>
 #include <cassert>
 #include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
 
 namespace fgr {
 	// Enumerate glModes to make it easy to remember
@@ -312,11 +315,11 @@ namespace fgr {
 			}
 		}
 		//Get this graphic's bounding box
-		const segment bounds() {
+		const segment bounds() const {
 			//Declare the segment to be returned
 			segment rets = front().bounds();
 			//Use each shape's bounding box to find this shape's bounding box!
-			for (iterator itr = begin(); itr != end(); itr++) {
+			for (const_iterator itr = begin(); itr != end(); itr++) {
 				//This way we don't have to keep calling 'bounds'
 				const segment checker = itr->bounds();
 				//Check rightbounds
@@ -666,6 +669,11 @@ namespace fgr {
 	typedef std::string spriteIndex;
 	typedef std::map<spriteIndex, std::string> spritePathLibrary;
 	typedef std::map<spriteIndex, animation> spriteLibrary;
+	//A number no costume has been given before (see spritesheet::wearingSerial())
+	std::size_t newCostumeSerial() {
+		static std::atomic<std::size_t> count(0);
+		return ++count;
+	}
 	//To be included as a member in animated objects, this class stores loaded sprite data and
 	//takes on the form of just one member when drawn.
 	class spritesheet {
@@ -677,10 +685,28 @@ namespace fgr {
 		spriteLibrary contents;
 		//The sprite currently being 'worn' by this spritesheet
 		spriteLibrary::const_iterator costume;
+		//Tells the costume apart from every other, wherever in memory it is (a copy keeps it)
+		std::size_t costumeSerial;
 	public:
 		//Default constructor
 		spritesheet() {
 			costume = contents.begin();
+			costumeSerial = 0;
+		}
+		//Copy constructor (the costume has to point into our own copy of the sprites)
+		spritesheet(const spritesheet& other) : library(other.library), contents(other.contents) {
+			costume = other.costume == other.contents.end() ? contents.end() : contents.find(other.costume->first);
+			costumeSerial = other.costumeSerial;
+		}
+		//Assignment operator
+		spritesheet& operator=(const spritesheet& other) {
+			if (this != &other) {
+				library = other.library;
+				contents = other.contents;
+				costume = other.costume == other.contents.end() ? contents.end() : contents.find(other.costume->first);
+				costumeSerial = other.costumeSerial;
+			}
+			return *this;
 		}
 		//Load in a sprite from the library, returns true only if it loads it in
 		bool load(const spriteIndex& sprite_ID) {
@@ -706,6 +732,30 @@ namespace fgr {
 		bool add_new_sprite(const animation& obj, const spriteIndex& sprite_ID, const std::string& path) {
 
 		}
+		//Put an animation straight into the loaded sprites (replacing any with the same name)
+		void keep(const spriteIndex& sprite_ID, const animation& obj) {
+			contents.erase(sprite_ID);
+			costume = contents.insert(std::make_pair(sprite_ID, obj)).first;
+			costumeSerial = newCostumeSerial();
+		}
+		//Start wearing a loaded sprite, returns true only if it's loaded
+		bool wear(const spriteIndex& sprite_ID) {
+			spriteLibrary::const_iterator lookup = contents.find(sprite_ID);
+			if (lookup == contents.end())
+				return false;
+			costume = lookup;
+			costumeSerial = newCostumeSerial();
+			return true;
+		}
+		//The sprite currently being worn (NULL if there isn't one)
+		const animation* wearing() const {
+			return costume == contents.end() ? NULL : &costume->second;
+		}
+		//A number that's the same only while the same sprite is worn (and for copies of this
+		//spritesheet), unlike the sprite's address, which another can take once it's gone
+		std::size_t wearingSerial() const {
+			return costumeSerial;
+		}
 	};
 
 }
@@ -713,6 +763,123 @@ namespace fgr {
 // OTHER CLASSES
 
 namespace fgr {
+	//Fold one more value into a running fingerprint (FNV-1a over the value's bits)
+	std::size_t fingerprint(std::size_t hash, float value) {
+		std::uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return (hash ^ bits) * std::size_t(1099511628211ull);
+	}
+
+	//The value every fingerprint starts from
+	const std::size_t FINGERPRINT_SEED = std::size_t(14695981039346656037ull);
+
+	//Cheap fingerprint of a glyph's form, used to tell whether a cached rendering of it is still valid
+	std::size_t fingerprint(const glyph& obj, std::size_t hash = FINGERPRINT_SEED) {
+		hash = fingerprint(hash, float(obj.mode));
+		hash = fingerprint(hash, float(obj.bezier));
+		hash = fingerprint(hash, float(obj.size()));
+		for (glyph::const_iterator itr = obj.begin(); itr != obj.end(); ++itr) {
+			hash = fingerprint(hash, itr->x());
+			hash = fingerprint(hash, itr->y());
+		}
+		return hash;
+	}
+
+	//Cheap fingerprint of a shape's form and drawing parameters
+	std::size_t fingerprint(const shape& obj, std::size_t hash = FINGERPRINT_SEED) {
+		hash = fingerprint(hash, obj.color.getLevel('r'));
+		hash = fingerprint(hash, obj.color.getLevel('g'));
+		hash = fingerprint(hash, obj.color.getLevel('b'));
+		hash = fingerprint(hash, obj.color.getLevel('a'));
+		hash = fingerprint(hash, obj.lineThickness);
+		hash = fingerprint(hash, obj.pointSize);
+		return fingerprint((const glyph&)obj, hash);
+	}
+
+	//Cheap fingerprint of every frame of an animation, with their timing
+	std::size_t fingerprint(const animation& obj, std::size_t hash = FINGERPRINT_SEED) {
+		hash = fingerprint(hash, float(obj.cycle));
+		hash = fingerprint(hash, float(obj.size()));
+		for (animation::const_iterator frm = obj.begin(); frm != obj.end(); ++frm) {
+			hash = fingerprint(hash, float(frm->delay));
+			hash = fingerprint(hash, float(frm->size()));
+			for (graphic::const_iterator shp = frm->begin(); shp != frm->end(); ++shp)
+				hash = fingerprint(*shp, hash);
+		}
+		return hash;
+	}
+
+	//Whether two glyphs have the same form (two fingerprints can match when the glyphs don't)
+	bool sameArt(const glyph& a, const glyph& b) {
+		if (a.mode != b.mode || a.bezier != b.bezier || a.size() != b.size())
+			return false;
+		for (glyph::const_iterator p = a.begin(), q = b.begin(); p != a.end(); ++p, ++q) {
+			if (p->x() != q->x() || p->y() != q->y())
+				return false;
+		}
+		return true;
+	}
+
+	//Whether two shapes have the same form and drawing parameters
+	bool sameArt(const shape& a, const shape& b) {
+		return a.color.getLevel('r') == b.color.getLevel('r') && a.color.getLevel('g') == b.color.getLevel('g')
+			&& a.color.getLevel('b') == b.color.getLevel('b') && a.color.getLevel('a') == b.color.getLevel('a')
+			&& a.lineThickness == b.lineThickness && a.pointSize == b.pointSize
+			&& sameArt((const glyph&)a, (const glyph&)b);
+	}
+
+	//Whether two animations have the same frames, with the same timing
+	bool sameArt(const animation& a, const animation& b) {
+		if (a.cycle != b.cycle || a.size() != b.size())
+			return false;
+		for (animation::const_iterator p = a.begin(), q = b.begin(); p != a.end(); ++p, ++q) {
+			if (p->delay != q->delay || p->size() != q->size())
+				return false;
+			for (graphic::const_iterator s = p->begin(), t = q->begin(); s != p->end(); ++s, ++t) {
+				if (!sameArt(*s, *t))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	//A flattened 2D transformation: p' = (a b; c d) * p + (tx, ty)
+	class affine {
+	public:
+		float a, b, c, d;
+		float tx, ty;
+		//Default constructor (the identity)
+		affine() {
+			a = d = 1.0f;
+			b = c = 0.0f;
+			tx = ty = 0.0f;
+		}
+		//Know-it-all constructor
+		affine(float a_, float b_, float c_, float d_, float tx_, float ty_) {
+			a = a_; b = b_;
+			c = c_; d = d_;
+			tx = tx_; ty = ty_;
+		}
+		//Transform a co-ordinate pair in place
+		void apply(float& x, float& y) const {
+			float nx = tx + a * x + b * y;
+			y = ty + c * x + d * y;
+			x = nx;
+		}
+		//Transform a point
+		point operator() (const point& dot) const {
+			float x = dot.x(), y = dot.y();
+			apply(x, y);
+			return point(x, y);
+		}
+		//The transformation that applies 'inner' first, and then this one
+		affine operator* (const affine& inner) const {
+			return affine(a * inner.a + b * inner.c, a * inner.b + b * inner.d,
+				c * inner.a + d * inner.c, c * inner.b + d * inner.d,
+				a * inner.tx + b * inner.ty + tx, c * inner.tx + d * inner.ty + ty);
+		}
+	};
+
 	//Structures information about a given fractal recall
 	class fractal_mantle {
 	public:
@@ -729,6 +896,12 @@ namespace fgr {
 			location = loc_;
 			scale = scl_;
 		}
+		//The same transformation fractalTransform() applies, flattened (translate, scale, then rotate)
+		affine transform() const {
+			float cosine = cosf(rotation) * scale;
+			float sine = sinf(rotation) * scale;
+			return affine(cosine, -sine, sine, cosine, location.x(), location.y());
+		}
 	};
 	//Structures information needed to draw a simple fractal
 	typedef shape fractalArt;
@@ -747,6 +920,33 @@ namespace fgr {
 			}
 		}
 	};
+
+	//Evaluate a bezier glyph into the plain glyph drawBezier() would render, at a given resolution
+	glyph evaluateBezier(const glyph& obj, unsigned int resolution) {
+		glyph retg(obj.mode, glyphContainer());
+		if (!obj.size())
+			return retg;
+		std::vector<float> xs, ys;
+		for (glyph::const_iterator itr = obj.begin(); itr != obj.end(); ++itr) {
+			xs.push_back(itr->x());
+			ys.push_back(itr->y());
+		}
+		std::vector<float> bx(xs.size()), by(ys.size());
+		for (unsigned int i = 0; i < resolution; ++i) {
+			//de Casteljau's algorithm
+			float t = float(i) / float(resolution);
+			bx = xs;
+			by = ys;
+			for (std::size_t level = bx.size() - 1; level > 0; --level) {
+				for (std::size_t j = 0; j < level; ++j) {
+					bx[j] += (bx[j + 1] - bx[j]) * t;
+					by[j] += (by[j + 1] - by[j]) * t;
+				}
+			}
+			retg.push_back(point(bx[0], by[0]));
+		}
+		return retg;
+	}
 }
 
 
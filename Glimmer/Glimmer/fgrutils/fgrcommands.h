@@ -0,0 +1,233 @@
+/* This header file defines render command lists. A command list is a renderer that draws
+ * nothing: the fgr::draw overloads record into it, flattening every primitive through the
+ * matrix stack into independent points, lines, triangles or quads tagged with the state they
+ * need. A list can then be optimized (batching draws that share state, wherever that can't
+ * change what's seen) and replayed onto any renderer, OpenGL or the software rasterizer,
+ * setting only the state that actually changes. Recording touches no OpenGL, so lists for
+ * static art can be recorded once, on any thread, and replayed as often as needed. */
+#pragma once
+
+#ifndef __FGR_COMMANDS_H__
+#define __FGR_COMMANDS_H__
+
+#include "fgrrender.h"
+#include "fgrbake.h"
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+namespace fgr {
+
+	//One recorded primitive: which vertices it draws, how, and with what state
+	struct drawcommand {
+		GLmode mode;
+		fcolor color;
+		float lineWidth;
+		float pointSize;
+		std::size_t first;
+		std::size_t count;
+		//The box around its vertices, for telling whether two draws can trade places
+		drawbox box;
+	};
+
+	//What replaying a command list cost
+	class replayreport {
+	public:
+		//How many primitives were started (begin/end pairs)
+		std::size_t draws;
+		//How many colors, line widths and point sizes were set
+		std::size_t stateChanges;
+		replayreport() {
+			draws = 0;
+			stateChanges = 0;
+		}
+	};
+
+	//Records fgr::draw calls so they can be optimized and replayed onto any renderer
+	class commandlist : public renderer {
+	public:
+		// CONSTRUCTORS
+		commandlist() {
+			clear();
+		}
+
+		// RECORDING
+		void color(const fcolor& col) { ink = col; }
+		void lineWidth(float width) { widthOfLines = width; }
+		void pointSize(float size) { sizeOfPoints = size; }
+		void begin(GLmode mode) {
+			pending = glyph(mode, glyphContainer());
+		}
+		void vertex(float x, float y) {
+			matrices.top().apply(x, y);
+			pending.push_back(point(x, y));
+		}
+		void end() {
+			glyph flat = separable(pending);
+			pending.clear();
+			if (!flat.size())
+				return;
+			drawcommand cmd;
+			cmd.mode = flat.mode;
+			cmd.color = ink;
+			//Only the state a primitive uses is kept, so what it doesn't use never splits a batch
+			cmd.lineWidth = flat.mode == glLines ? widthOfLines : 0.0f;
+			cmd.pointSize = flat.mode == glPoints ? sizeOfPoints : 0.0f;
+			cmd.first = vertices.size();
+			cmd.count = flat.size();
+			cmd.box = drawbox::none();
+			for (glyph::const_iterator itr = flat.begin(); itr != flat.end(); ++itr) {
+				vertices.push_back(*itr);
+				cmd.box.add(itr->x(), itr->y(), itr->x(), itr->y());
+			}
+			//Thick lines and big points spill past their vertices (by at most this much, in the plane)
+			float spill = fmaxf(cmd.lineWidth, cmd.pointSize) * 0.5f;
+			spill = spill <= 0.0f ? 0.0f : spillPerPixel < 0.0f ? 1e30f : (spill + 1.0f) * spillPerPixel;
+			cmd.box.add(cmd.box.left - spill, cmd.box.bottom - spill, cmd.box.right + spill, cmd.box.top + spill);
+			commands.push_back(cmd);
+		}
+		void pushMatrix() { matrices.push(); }
+		void popMatrix() { matrices.pop(); }
+		void translate(float x, float y) { matrices.translate(x, y); }
+		void rotate(float angle) { matrices.rotate(angle); }
+		void scale(float factor) { matrices.scale(factor); }
+
+		// FUNCTIONS
+		//Forget everything recorded, and go back to the default state (white, one pixel wide)
+		void clear() {
+			commands.clear();
+			vertices.clear();
+			matrices.reset();
+			pending = glyph(glPoints, glyphContainer());
+			ink = fcolor(1.0f, 1.0f, 1.0f, 1.0f);
+			widthOfLines = 1.0f;
+			sizeOfPoints = 1.0f;
+			spillPerPixel = -1.0f;
+		}
+		/* How far one pixel of line width or point size reaches in the plane, when replayed. Lines
+		 * and points are measured in pixels, so their size in the plane depends on where the list
+		 * ends up, and optimize() needs an upper bound to tell what they might overlap. Until
+		 * it's given one, lines and points never trade places with anything. */
+		void setPixelSize(float unitsPerPixel) {
+			spillPerPixel = unitsPerPixel;
+		}
+		//Add everything another list recorded onto the end of this one (for joining lists recorded on other threads)
+		void append(const commandlist& other) {
+			std::size_t offset = vertices.size();
+			vertices.insert(vertices.end(), other.vertices.begin(), other.vertices.end());
+			for (std::size_t i = 0; i < other.commands.size(); ++i) {
+				commands.push_back(other.commands[i]);
+				commands.back().first += offset;
+			}
+		}
+		/* Group draws that share state, then join each group into as few primitives as possible.
+		 * A draw only moves earlier, to join the last group with its state, if nothing it would
+		 * jump over overlaps it, so the result always looks exactly the same. Looking further
+		 * back finds more to batch, at a cost that grows with it. */
+		void optimize(std::size_t lookback = 32) {
+			//The draws in each group, in order
+			std::vector<std::vector<std::size_t> > groups;
+			drawgrouper grouper(lookback);
+			for (std::size_t i = 0; i < commands.size(); ++i) {
+				const drawcommand& cmd = commands[i];
+				std::size_t into = grouper.place(cmd.box, [&](std::size_t g) {
+					return sameState(commands[groups[g].front()], cmd);
+				});
+				if (into == groups.size())
+					groups.push_back(std::vector<std::size_t>());
+				groups[into].push_back(i);
+			}
+			//Lay the vertices out again, group by group, one primitive per group
+			std::vector<point> laid;
+			std::vector<drawcommand> joined;
+			laid.reserve(vertices.size());
+			joined.reserve(groups.size());
+			for (std::size_t g = 0; g < groups.size(); ++g) {
+				drawcommand cmd = commands[groups[g].front()];
+				cmd.first = laid.size();
+				cmd.count = 0;
+				cmd.box = grouper.box(g);
+				for (std::size_t m = 0; m < groups[g].size(); ++m) {
+					const drawcommand& member = commands[groups[g][m]];
+					laid.insert(laid.end(), vertices.begin() + member.first, vertices.begin() + member.first + member.count);
+					cmd.count += member.count;
+				}
+				joined.push_back(cmd);
+			}
+			vertices.swap(laid);
+			commands.swap(joined);
+		}
+
+		// REPLAYING
+		//Draw everything recorded onto a renderer, under its current matrix, setting only the state that changes
+		replayreport replay(renderer& target) const {
+			replayreport report;
+			bool haveColor = false, haveWidth = false, haveSize = false;
+			fcolor lastColor;
+			float lastWidth = 0.0f, lastSize = 0.0f;
+			for (std::size_t i = 0; i < commands.size(); ++i) {
+				const drawcommand& cmd = commands[i];
+				if (!haveColor || !sameColor(lastColor, cmd.color)) {
+					target.color(cmd.color);
+					lastColor = cmd.color;
+					haveColor = true;
+					++report.stateChanges;
+				}
+				if (cmd.mode == glLines && (!haveWidth || lastWidth != cmd.lineWidth)) {
+					target.lineWidth(cmd.lineWidth);
+					lastWidth = cmd.lineWidth;
+					haveWidth = true;
+					++report.stateChanges;
+				}
+				if (cmd.mode == glPoints && (!haveSize || lastSize != cmd.pointSize)) {
+					target.pointSize(cmd.pointSize);
+					lastSize = cmd.pointSize;
+					haveSize = true;
+					++report.stateChanges;
+				}
+				target.begin(cmd.mode);
+				for (std::size_t v = cmd.first; v < cmd.first + cmd.count; ++v)
+					target.vertex(vertices[v].x(), vertices[v].y());
+				target.end();
+				++report.draws;
+			}
+			return report;
+		}
+
+		// STATISTICS
+		//How many primitives have been recorded (or are left, after optimizing)
+		std::size_t size() const {
+			return commands.size();
+		}
+		std::size_t vertexCount() const {
+			return vertices.size();
+		}
+		const std::vector<drawcommand>& recorded() const {
+			return commands;
+		}
+
+	private:
+		std::vector<drawcommand> commands;
+		//Every vertex, already through the matrix stack
+		std::vector<point> vertices;
+		matrixstack matrices;
+		//The primitive being recorded
+		glyph pending;
+		fcolor ink;
+		float widthOfLines;
+		float sizeOfPoints;
+		float spillPerPixel;
+
+		static bool sameColor(const fcolor& a, const fcolor& b) {
+			return a.getLevel('r') == b.getLevel('r') && a.getLevel('g') == b.getLevel('g')
+				&& a.getLevel('b') == b.getLevel('b') && a.getLevel('a') == b.getLevel('a');
+		}
+		static bool sameState(const drawcommand& a, const drawcommand& b) {
+			return a.mode == b.mode && a.lineWidth == b.lineWidth && a.pointSize == b.pointSize && sameColor(a.color, b.color);
+		}
+	};
+
+}
+
+#endif
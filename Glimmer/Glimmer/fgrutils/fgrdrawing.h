@@ -229,6 +229,11 @@ namespace  fgr {
 		return listHandle;
 	}
 
+	//How many primitives (from glBegin to glEnd, or one glDrawArrays) fgr has drawn, and with how
+	//many vertices, since these were last set back to 0 (for measuring what drawing costs)
+	unsigned long primitivesDrawn = 0;
+	unsigned long verticesDrawn = 0;
+
 	//Plot a bezier using a set of points at the specified resolution
 	void drawBezier(const fgr::glyph& obj, unsigned int resolution) {
 		if (!obj.size())
@@ -244,6 +249,8 @@ namespace  fgr {
 				glEvalCoord1f((GLfloat)i / denominator);
 			}
 		glEnd();
+		++primitivesDrawn;
+		verticesDrawn += resolution;
 		glDisable(GL_MAP1_VERTEX_3);
 		glDisable(GL_LINE_SMOOTH);
 		delete[] pointData;
@@ -262,6 +269,8 @@ namespace  fgr {
 		glBegin(obj.mode);
 			obj.applyToAll(glVertexPoint);
 		glEnd();
+		++primitivesDrawn;
+		verticesDrawn += obj.size();
 		return;
 	}
 
@@ -336,6 +345,7 @@ namespace  fgr {
 			glTranslatePoint(obj.position);
 			glRotatef(obj.rotation / PI * 180.0f, 0.0f, 0.0f, 1.0f);
 			glScalef(obj.scale, obj.scale, obj.scale);
+			draw((const animation&)obj);
 		glPopMatrix();
 	}
 
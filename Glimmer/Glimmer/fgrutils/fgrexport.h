@@ -0,0 +1,143 @@
+/* This header file exports whole animations. Frames are rasterized on every core at once,
+ * then handed to the PNG and GIF encoders strictly in order. Workers never run more than a
+ * couple of frames per core ahead of the writer, so even long animations export in a
+ * fixed amount of memory. */
+#pragma once
+
+#ifndef __FGR_EXPORT_H__
+#define __FGR_EXPORT_H__
+
+#include "fgrraster.h"
+#include "fgrgif.h"
+
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+
+namespace fgr {
+
+	//What an animation export did, and how long it took
+	class animreport {
+	public:
+		//How many distinct frames were rasterized
+		std::size_t frames;
+		//How many PNG files were written
+		std::size_t images;
+		//Wall-clock time for the whole export
+		float milliseconds;
+		animreport() {
+			frames = 0;
+			images = 0;
+			milliseconds = 0.0f;
+		}
+	};
+
+	//The name of the n-th image of a PNG sequence: <base>_0000.png, <base>_0001.png...
+	std::string sequenceName(const std::string& base, std::size_t n) {
+		char number[32];
+		snprintf(number, sizeof(number), "_%04u.png", unsigned(n));
+		return base + number;
+	}
+
+	/* Export an animation, anti-aliased, as a PNG sequence and/or an animated GIF. A frame is
+	 * shown for (delay + 1) ticks, just as the editor plays it, and there are ticksPerSecond
+	 * ticks in a second. The PNG sequence has one image per tick, so it can go straight into a
+	 * video encoder at that rate; the GIF has one image per frame, shown for as long as the
+	 * frame lasts. Either path may be empty to skip it. Every frame shares one view, fitted
+	 * (with a little padding) around the whole animation. Returns false if anything couldn't
+	 * be written. */
+	bool exportAnimation(const animation& anim, const std::string& pngBase, const std::string& gifPath,
+		int width, int height, float ticksPerSecond, float pixelScale, animreport& report) {
+		std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+		report = animreport();
+		if (width <= 0 || height <= 0 || !anim.size() || !(ticksPerSecond > 0.0f))
+			return false;
+		segment bounds(1e30f, 1e30f, -1e30f, -1e30f);
+		for (animation::const_iterator itr = anim.begin(); itr != anim.end(); ++itr) {
+			segment box = vertexBounds(*itr);
+			bounds = segment(fminf(bounds.p1.x(), box.p1.x()), fminf(bounds.p1.y(), box.p1.y()),
+				fmaxf(bounds.p2.x(), box.p2.x()), fmaxf(bounds.p2.y(), box.p2.y()));
+		}
+		segment view = fitView(bounds, width, height, 0.05f);
+		gifwriter gifOut;
+		if (!gifPath.empty() && !gifOut.open(gifPath, width, height))
+			return false;
+		//A frame that's been drawn and encoded, waiting its turn to be written
+		struct finished {
+			std::vector<unsigned char> png;
+			gif::encodedframe gif;
+		};
+		std::mutex lock;
+		std::condition_variable changed;
+		std::map<std::size_t, finished> ready;
+		std::size_t nextFrame = 0;
+		std::size_t nextToWrite = 0;
+		bool writing = false;
+		bool ok = true;
+		const std::size_t window = 2 * parallel::workerCount();
+		//Only whoever is writing touches these, so GIF delays can carry their rounding along
+		std::size_t ticksWritten = 0;
+		int centisecondsWritten = 0;
+		//Every core rasterizes whole frames by itself, rather than every core sharing each frame
+		parallel::forChunks(0, parallel::workerCount(), [&](std::size_t, std::size_t, unsigned int) {
+			std::vector<unsigned char> rgba;
+			rasterreport frameReport;
+			std::unique_lock<std::mutex> guard(lock);
+			for (;;) {
+				changed.wait(guard, [&]() { return nextFrame >= anim.size() || nextFrame < nextToWrite + window; });
+				if (nextFrame >= anim.size())
+					break;
+				std::size_t k = nextFrame++;
+				guard.unlock();
+				finished result;
+				rasterize(anim[k], view, width, height, pixelScale, fcolor(0.0f, 0.0f, 0.0f, 0.0f), rgba, frameReport, false);
+				if (!pngBase.empty())
+					result.png = encodePNG(width, height, &rgba[0]);
+				if (gifOut.isOpen())
+					result.gif = gif::encodeFrame(&rgba[0], width, height);
+				guard.lock();
+				ready[k] = std::move(result);
+				//Whoever finds the next frame waiting writes it (and any after it), while the others keep drawing
+				if (writing)
+					continue;
+				writing = true;
+				while (!ready.empty() && ready.begin()->first == nextToWrite) {
+					finished next = std::move(ready.begin()->second);
+					ready.erase(ready.begin());
+					std::size_t ticks = std::size_t(std::max(anim[nextToWrite].delay, 0)) + 1;
+					guard.unlock();
+					bool written = true;
+					if (!pngBase.empty()) {
+						for (std::size_t t = 0; t < ticks; ++t)
+							written = writeBytes(sequenceName(pngBase, ticksWritten + t), next.png) && written;
+					}
+					ticksWritten += ticks;
+					if (gifOut.isOpen()) {
+						int centiseconds = int(floorf(ticksWritten * 100.0f / ticksPerSecond + 0.5f));
+						gifOut.addFrame(next.gif, centiseconds - centisecondsWritten);
+						centisecondsWritten = centiseconds;
+					}
+					guard.lock();
+					ok = ok && written;
+					if (!pngBase.empty())
+						report.images += ticks;
+					++nextToWrite;
+					changed.notify_all();
+				}
+				writing = false;
+			}
+		});
+		report.frames = nextToWrite;
+		ok = gifOut.close() && ok;
+		report.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started).count();
+		return ok;
+	}
+
+}
+
+#endif
@@ -38,24 +38,37 @@ namespace fgr {
 	//	| GLmode GLMODE | BOOL BEZIER | STD::SIZE_T POINT_COUNT | FLOAT X_1 | FLOAT Y_1 | FLOAT X_2 | FLOAT Y_2 | ... | FLOAT X_N | FLOAT Y_N |
 	//
 
-	//Get a glyph from a file stream
-	glyph fgetglyph(FILE*& stream) {
+	//How many points are read or written at once
+	const std::size_t POINT_BATCH = 4096;
+
+	//Get a glyph from a file stream, into a glyph that's already there (it's emptied first)
+	void fgetglyph(glyph& into, FILE*& stream) {
 		//Read in the GLmode of this glyph
-		GLmode GLMODE;
-		fread(&GLMODE, sizeof(GLmode), 1, stream);
+		fread(&into.mode, sizeof(GLmode), 1, stream);
 		//Read in bezier status
-		bool BEZIER;
-		fread(&BEZIER, sizeof(bool), 1, stream);
+		fread(&into.bezier, sizeof(bool), 1, stream);
 		//Read in the number of points in the glyph
 		std::size_t POINTC;
 		fread(&POINTC, sizeof(std::size_t), 1, stream);
-		//Read in every point, one at a time
-		glyphContainer pointData;
-		for (std::size_t i = 0; i < POINTC; ++i) {
-			pointData.push_back(fgetpoint(stream));
+		//Read in the points a batch at a time, straight into the glyph
+		into.clear();
+		float buffer[POINT_BATCH * 2];
+		while (POINTC) {
+			std::size_t want = POINTC < POINT_BATCH ? POINTC : POINT_BATCH;
+			std::size_t got = fread(buffer, sizeof(float) * 2, want, stream);
+			for (std::size_t i = 0; i < got; ++i)
+				into.push_back(point(buffer[2 * i], buffer[2 * i + 1]));
+			if (got < want)
+				break;
+			POINTC -= got;
 		}
-		//Construct and return the glyph object
-		return glyph(GLMODE, BEZIER, pointData);
+	}
+
+	//Get a glyph from a file stream
+	glyph fgetglyph(FILE*& stream) {
+		glyph retg;
+		fgetglyph(retg, stream);
+		return retg;
 	}
 
 	//Put a glyph into a file stream
@@ -67,10 +80,18 @@ namespace fgr {
 		//Write in the number of points in the glyph
 		std::size_t POINTC = obj.size();
 		fwrite(&POINTC, sizeof(std::size_t), 1, stream);
-		//Write in every point, one at a time
+		//Write in the points a batch at a time
+		float buffer[POINT_BATCH * 2];
+		std::size_t held = 0;
 		for (glyphContainer::const_iterator itr = obj.begin(); itr != obj.end(); ++itr) {
-			fputpoint(*itr, stream);
+			buffer[2 * held] = itr->x();
+			buffer[2 * held + 1] = itr->y();
+			if (++held == POINT_BATCH) {
+				fwrite(buffer, sizeof(float) * 2, held, stream);
+				held = 0;
+			}
 		}
+		fwrite(buffer, sizeof(float) * 2, held, stream);
 		return;
 	}
 
@@ -104,17 +125,24 @@ namespace fgr {
 	//	| FCOLOR COLOR | FLOAT LINETHICKNESS | FLOAT POINTSIZE | <GLYPH> |
 	//
 
-	//Get a shape from a file stream
-	shape fgetshape(FILE*& stream) {
+	//Get a shape from a file stream, into a shape that's already there
+	void fgetshape(shape& into, FILE*& stream) {
 		//Read in the fcolor
-		fcolor color = fgetfcolor(stream);
+		into.color = fgetfcolor(stream);
 		//Read in the linethickness and pointsize
 		float weightdata[2];
 		fread(weightdata, sizeof(float), 2, stream);
+		into.lineThickness = weightdata[0];
+		into.pointSize = weightdata[1];
 		//Read in the point data
-		glyph pointdata = fgetglyph(stream);
-		//Construct and return the shape
-		return shape(pointdata, color, weightdata[0], weightdata[1]);
+		fgetglyph(into, stream);
+	}
+
+	//Get a shape from a file stream
+	shape fgetshape(FILE*& stream) {
+		shape rets;
+		fgetshape(rets, stream);
+		return rets;
 	}
 	
 	//Put a shape into a file stream
@@ -134,18 +162,24 @@ namespace fgr {
 	//	| STD::SIZE_T SHAPECOUNT | <SHAPES> |
 	//
 
-	//Get a shape from a file stream
-	graphic fgetgraphic(FILE*& stream) {
+	//Get a graphic from a file stream, into a graphic that's already there (it's emptied first)
+	void fgetgraphic(graphic& into, FILE*& stream) {
 		//Read in the size type
 		std::size_t shapecount;
 		fread(&shapecount, sizeof(std::size_t), 1, stream);
-		//Read in the shapes
-		graphicContainer shapedata;
-		for (std::size_t i = 0; i < shapecount; ++i) {
-			shapedata.push_back(fgetshape(stream));
+		//Read each shape in where it goes, rather than copying it there
+		into.clear();
+		for (std::size_t i = 0; i < shapecount && !feof(stream); ++i) {
+			into.push_back(shape());
+			fgetshape(into.back(), stream);
 		}
-		//Construct and return the graphic object
-		return graphic(shapedata);
+	}
+
+	//Get a graphic from a file stream
+	graphic fgetgraphic(FILE*& stream) {
+		graphic retg;
+		fgetgraphic(retg, stream);
+		return retg;
 	}
 
 	//Put a graphic into a file stream
@@ -167,13 +201,19 @@ namespace fgr {
 	//	| INT DELAY | <GRAPHIC> |
 	//
 
+	//Get a frame of an animtion from a file stream, into a frame that's already there
+	void fgetframe(frame& into, FILE*& stream) {
+		//Read in the delay
+		fread(&into.delay, sizeof(int), 1, stream);
+		//Read in the graphic
+		fgetgraphic(into, stream);
+	}
+
 	//Get a frame of an animtion from a file stream
 	frame fgetframe(FILE*& stream) {
-		//Read in the delay
-		int delay;
-		fread(&delay, sizeof(int), 1, stream);
-		//Read in the graphic, construct and return the frame
-		return frame(delay, fgetgraphic(stream));
+		frame retf;
+		fgetframe(retf, stream);
+		return retf;
 	}
 	
 	//Put a frame of an animtion into a file stream
@@ -199,12 +239,14 @@ namespace fgr {
 		//Read in the number of frames
 		std::size_t framec;
 		fread(&framec, sizeof(std::size_t), 1, stream);
-		//Read in all the frames
-		animationContainer frameData;
-		for (std::size_t i = 0; i < framec; ++i) {
-			frameData.push_back(fgetframe(stream));
+		//Read each frame in where it goes
+		animation reta(cycle, animationContainer());
+		for (std::size_t i = 0; i < framec && !feof(stream); ++i) {
+			reta.push_back(frame());
+			fgetframe(reta.back(), stream);
 		}
-		return animation(cycle, frameData);
+		reta.currentframe = reta.begin();
+		return reta;
 	}
 
 	//Put an animation into a file stream
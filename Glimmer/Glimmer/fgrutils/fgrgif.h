@@ -0,0 +1,413 @@
+/* This header file defines a small, dependency-free animated GIF writer. Every frame gets
+ * its own palette, chosen by median cut over a 15-bit color histogram, and is compressed
+ * with GIF's variable-width LZW. Flat vector art rarely has more than a few hundred
+ * distinct colors, so palettes are close to exact everywhere but anti-aliased edges. The
+ * LZW can be read back too, to check what's written. */
+#pragma once
+
+#ifndef __FGR_GIF_H__
+#define __FGR_GIF_H__
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+
+namespace fgr {
+
+	namespace gif {
+
+		//One frame, quantized and compressed, ready to be written in any order
+		struct encodedframe {
+			//The palette, three bytes per color, padded to a power of two
+			std::vector<unsigned char> palette;
+			//log2 of the palette's size
+			int paletteBits;
+			//Index of the transparent color, or -1 if every pixel is opaque
+			int transparent;
+			//The LZW code size, then the compressed image in sub-blocks, then the terminator
+			std::vector<unsigned char> data;
+			encodedframe() {
+				paletteBits = 1;
+				transparent = -1;
+			}
+		};
+
+		//The 15-bit histogram cell a color falls in
+		inline int cellOf(const unsigned char* rgba) {
+			return ((rgba[0] >> 3) << 10) | ((rgba[1] >> 3) << 5) | (rgba[2] >> 3);
+		}
+
+		//One channel (0 red, 1 green, 2 blue) of a histogram cell, 0-31
+		inline int channelOf(int cell, int channel) {
+			return (cell >> (10 - 5 * channel)) & 31;
+		}
+
+		/* Choose at most 'colors' colors for the opaque pixels of an image by median cut.
+		 * Fills the palette (three bytes per color) and, for every histogram cell that has
+		 * pixels in it, the index of the palette color it maps to. */
+		void quantize(const unsigned char* rgba, std::size_t pixels, int colors,
+			std::vector<unsigned char>& palette, std::vector<unsigned char>& lookup) {
+			std::vector<std::uint32_t> count(32768, 0);
+			std::vector<std::uint64_t> sums(32768 * 3, 0);
+			for (std::size_t i = 0; i < pixels; ++i) {
+				const unsigned char* p = rgba + i * 4;
+				if (p[3] < 128)
+					continue;
+				int cell = cellOf(p);
+				++count[cell];
+				for (int k = 0; k < 3; ++k)
+					sums[cell * 3 + k] += p[k];
+			}
+			std::vector<int> cells;
+			for (int cell = 0; cell < 32768; ++cell)
+				if (count[cell])
+					cells.push_back(cell);
+			//Boxes are ranges of 'cells'; keep splitting the biggest, widest one at its median
+			std::vector<std::pair<std::size_t, std::size_t> > boxes;
+			if (!cells.empty())
+				boxes.push_back(std::make_pair(std::size_t(0), cells.size()));
+			while (int(boxes.size()) < colors) {
+				int best = -1, bestChannel = 0;
+				std::uint64_t bestScore = 0;
+				for (std::size_t b = 0; b < boxes.size(); ++b) {
+					if (boxes[b].second - boxes[b].first < 2)
+						continue;
+					int low[3] = { 31, 31, 31 }, high[3] = { 0, 0, 0 };
+					std::uint64_t population = 0;
+					for (std::size_t i = boxes[b].first; i < boxes[b].second; ++i) {
+						population += count[cells[i]];
+						for (int k = 0; k < 3; ++k) {
+							low[k] = std::min(low[k], channelOf(cells[i], k));
+							high[k] = std::max(high[k], channelOf(cells[i], k));
+						}
+					}
+					int channel = 0;
+					for (int k = 1; k < 3; ++k)
+						if (high[k] - low[k] > high[channel] - low[channel])
+							channel = k;
+					std::uint64_t score = population * std::uint64_t(high[channel] - low[channel] + 1);
+					if (score > bestScore) {
+						bestScore = score;
+						best = int(b);
+						bestChannel = channel;
+					}
+				}
+				if (best < 0)
+					break;
+				std::size_t first = boxes[best].first, last = boxes[best].second;
+				std::sort(cells.begin() + first, cells.begin() + last, [&](int a, int b) {
+					return channelOf(a, bestChannel) < channelOf(b, bestChannel);
+				});
+				std::uint64_t population = 0;
+				for (std::size_t i = first; i < last; ++i)
+					population += count[cells[i]];
+				std::uint64_t running = 0;
+				std::size_t split = first + 1;
+				for (std::size_t i = first; i + 1 < last; ++i) {
+					running += count[cells[i]];
+					split = i + 1;
+					if (running * 2 >= population)
+						break;
+				}
+				boxes[best].second = split;
+				boxes.push_back(std::make_pair(split, last));
+			}
+			//Each color is the average of every pixel in its box
+			palette.clear();
+			lookup.assign(32768, 0);
+			for (std::size_t b = 0; b < boxes.size(); ++b) {
+				std::uint64_t population = 0, total[3] = { 0, 0, 0 };
+				for (std::size_t i = boxes[b].first; i < boxes[b].second; ++i) {
+					population += count[cells[i]];
+					for (int k = 0; k < 3; ++k)
+						total[k] += sums[cells[i] * 3 + k];
+					lookup[cells[i]] = (unsigned char)b;
+				}
+				for (int k = 0; k < 3; ++k)
+					palette.push_back((unsigned char)((total[k] + population / 2) / population));
+			}
+		}
+
+		//Packs LZW codes least-significant bit first into length-prefixed sub-blocks of at most 255 bytes
+		class codewriter {
+		public:
+			std::vector<unsigned char>& out;
+			codewriter(std::vector<unsigned char>& target) : out(target) {
+				buffer = 0;
+				count = 0;
+			}
+			void put(std::uint32_t code, int length) {
+				buffer |= code << count;
+				count += length;
+				while (count >= 8) {
+					block.push_back((unsigned char)(buffer & 0xFF));
+					buffer >>= 8;
+					count -= 8;
+					if (block.size() == 255)
+						flushBlock();
+				}
+			}
+			//Write out the last bits and the block terminator
+			void finish() {
+				if (count)
+					block.push_back((unsigned char)(buffer & 0xFF));
+				buffer = 0;
+				count = 0;
+				flushBlock();
+				out.push_back(0);
+			}
+		private:
+			std::vector<unsigned char> block;
+			std::uint32_t buffer;
+			int count;
+			void flushBlock() {
+				if (block.empty())
+					return;
+				out.push_back((unsigned char)block.size());
+				out.insert(out.end(), block.begin(), block.end());
+				block.clear();
+			}
+		};
+
+		//Compress palette indices with GIF's LZW, appending the code size and the sub-blocks
+		void compress(const std::vector<unsigned char>& indices, int minCodeSize, std::vector<unsigned char>& out) {
+			out.push_back((unsigned char)minCodeSize);
+			codewriter codes(out);
+			const int clear = 1 << minCodeSize;
+			const int stop = clear + 1;
+			//The dictionary maps (prefix code, next index) to a code, in an open-addressed table
+			const int SLOT_BITS = 13;
+			const std::size_t SLOTS = std::size_t(1) << SLOT_BITS;
+			std::vector<std::int32_t> keys(SLOTS, -1);
+			std::vector<std::uint16_t> values(SLOTS, 0);
+			int codeSize = minCodeSize + 1;
+			int maxCode = stop;
+			codes.put(clear, codeSize);
+			int current = -1;
+			for (std::size_t i = 0; i < indices.size(); ++i) {
+				int next = indices[i];
+				if (current < 0) {
+					current = next;
+					continue;
+				}
+				std::int32_t key = (current << 8) | next;
+				std::size_t slot = (std::uint32_t(key) * 2654435761u) >> (32 - SLOT_BITS);
+				while (keys[slot] != -1 && keys[slot] != key)
+					slot = (slot + 1) & (SLOTS - 1);
+				if (keys[slot] == key) {
+					current = values[slot];
+					continue;
+				}
+				codes.put(current, codeSize);
+				keys[slot] = key;
+				values[slot] = (std::uint16_t)++maxCode;
+				if (maxCode >= (1 << codeSize))
+					++codeSize;
+				//The table is full: start again
+				if (maxCode == 4095) {
+					codes.put(clear, codeSize);
+					std::fill(keys.begin(), keys.end(), -1);
+					codeSize = minCodeSize + 1;
+					maxCode = stop;
+				}
+				current = next;
+			}
+			if (current >= 0) {
+				codes.put(current, codeSize);
+				//A reader adds to its table on this code as well, and may widen its codes before the stop code
+				if (maxCode + 1 == (1 << codeSize) && codeSize < 12)
+					++codeSize;
+			}
+			codes.put(stop, codeSize);
+			codes.finish();
+		}
+
+		//Decompress what compress() appended back into palette indices, as a GIF reader would.
+		//Returns false if the data isn't well-formed or doesn't end with a stop code.
+		bool decompress(const std::vector<unsigned char>& in, std::vector<unsigned char>& indices) {
+			indices.clear();
+			if (in.empty() || in[0] < 2 || in[0] > 8)
+				return false;
+			const int minCodeSize = in[0];
+			//Join the sub-blocks back together
+			std::vector<unsigned char> bytes;
+			std::size_t at = 1;
+			while (at < in.size() && in[at]) {
+				std::size_t length = in[at++];
+				if (at + length > in.size())
+					return false;
+				bytes.insert(bytes.end(), in.begin() + at, in.begin() + at + length);
+				at += length;
+			}
+			const int clear = 1 << minCodeSize;
+			const int stop = clear + 1;
+			std::vector<std::uint16_t> prefix(4096, 0);
+			std::vector<unsigned char> suffix(4096, 0);
+			for (int c = 0; c < clear; ++c)
+				suffix[c] = (unsigned char)c;
+			std::vector<unsigned char> string;
+			//Write out the indices a code stands for, returning the first of them
+			auto expand = [&](int code) {
+				string.clear();
+				while (code > stop) {
+					string.push_back(suffix[code]);
+					code = prefix[code];
+				}
+				string.push_back((unsigned char)code);
+				indices.insert(indices.end(), string.rbegin(), string.rend());
+				return string.back();
+			};
+			int codeSize = minCodeSize + 1;
+			int next = stop + 1;
+			int previous = -1;
+			//A code spans at most three bytes; padding lets the last one be read like the rest
+			const std::size_t bits = bytes.size() * 8;
+			bytes.resize(bytes.size() + 2, 0);
+			std::size_t bit = 0;
+			while (bit + codeSize <= bits) {
+				std::uint32_t window = bytes[bit >> 3] | (bytes[(bit >> 3) + 1] << 8) | (bytes[(bit >> 3) + 2] << 16);
+				int code = int((window >> (bit & 7)) & ((1u << codeSize) - 1));
+				bit += codeSize;
+				if (code == clear) {
+					codeSize = minCodeSize + 1;
+					next = stop + 1;
+					previous = -1;
+					continue;
+				}
+				if (code == stop)
+					return true;
+				if (previous < 0) {
+					if (code > clear)
+						return false;
+					expand(code);
+					previous = code;
+					continue;
+				}
+				unsigned char first;
+				if (code < next) {
+					first = expand(code);
+				}
+				else if (code == next) {
+					first = expand(previous);
+					indices.push_back(first);
+				}
+				else {
+					return false;
+				}
+				if (next < 4096) {
+					prefix[next] = (std::uint16_t)previous;
+					suffix[next] = first;
+					++next;
+					if (next == (1 << codeSize) && codeSize < 12)
+						++codeSize;
+				}
+				previous = code;
+			}
+			return false;
+		}
+
+		/* Quantize and compress an RGBA image (straight alpha, top row first). Pixels less than
+		 * half opaque become transparent; everything else is drawn fully opaque. */
+		encodedframe encodeFrame(const unsigned char* rgba, int width, int height) {
+			encodedframe retv;
+			std::size_t pixels = std::size_t(std::max(width, 0)) * std::size_t(std::max(height, 0));
+			bool anyTransparent = false;
+			for (std::size_t i = 0; i < pixels && !anyTransparent; ++i)
+				anyTransparent = rgba[i * 4 + 3] < 128;
+			std::vector<unsigned char> lookup;
+			quantize(rgba, pixels, anyTransparent ? 255 : 256, retv.palette, lookup);
+			int colors = int(retv.palette.size() / 3);
+			if (anyTransparent) {
+				retv.transparent = colors++;
+				retv.palette.insert(retv.palette.end(), 3, 0);
+			}
+			while ((1 << retv.paletteBits) < colors)
+				++retv.paletteBits;
+			retv.palette.resize(std::size_t(3) << retv.paletteBits, 0);
+			std::vector<unsigned char> indices(pixels);
+			for (std::size_t i = 0; i < pixels; ++i) {
+				const unsigned char* p = rgba + i * 4;
+				indices[i] = p[3] < 128 ? (unsigned char)retv.transparent : lookup[cellOf(p)];
+			}
+			compress(indices, std::max(2, retv.paletteBits), retv.data);
+			return retv;
+		}
+
+	}
+
+	//Writes frames into an animated GIF that loops forever
+	class gifwriter {
+	public:
+		gifwriter() {
+			stream = NULL;
+		}
+		//Start a new GIF of some size. Returns false if the file couldn't be opened.
+		bool open(const std::string& path, int width, int height) {
+			close();
+			fopen_s(&stream, path.c_str(), "wb");
+			if (!stream)
+				return false;
+			unsigned char screen[13] = { 'G', 'I', 'F', '8', '9', 'a',
+				(unsigned char)(width & 0xFF), (unsigned char)(width >> 8),
+				(unsigned char)(height & 0xFF), (unsigned char)(height >> 8),
+				0, 0, 0 };
+			fwrite(screen, 1, sizeof(screen), stream);
+			//The NETSCAPE2.0 extension, set to loop forever
+			static const unsigned char looping[19] = { 0x21, 0xFF, 11, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E',
+				'2', '.', '0', 3, 1, 0, 0, 0 };
+			fwrite(looping, 1, sizeof(looping), stream);
+			this->width = width;
+			this->height = height;
+			return true;
+		}
+		bool isOpen() const {
+			return stream != NULL;
+		}
+		//Append a frame, shown for some hundredths of a second
+		void addFrame(const gif::encodedframe& frame, int centiseconds) {
+			if (!stream)
+				return;
+			centiseconds = std::max(0, std::min(centiseconds, 65535));
+			//Transparent frames clear what they cover before the next one, so frames don't smear
+			int disposal = frame.transparent >= 0 ? 2 : 1;
+			unsigned char control[8] = { 0x21, 0xF9, 4,
+				(unsigned char)((disposal << 2) | (frame.transparent >= 0 ? 1 : 0)),
+				(unsigned char)(centiseconds & 0xFF), (unsigned char)(centiseconds >> 8),
+				(unsigned char)(frame.transparent >= 0 ? frame.transparent : 0), 0 };
+			fwrite(control, 1, sizeof(control), stream);
+			unsigned char descriptor[10] = { 0x2C, 0, 0, 0, 0,
+				(unsigned char)(width & 0xFF), (unsigned char)(width >> 8),
+				(unsigned char)(height & 0xFF), (unsigned char)(height >> 8),
+				(unsigned char)(0x80 | (frame.paletteBits - 1)) };
+			fwrite(descriptor, 1, sizeof(descriptor), stream);
+			fwrite(&frame.palette[0], 1, frame.palette.size(), stream);
+			fwrite(&frame.data[0], 1, frame.data.size(), stream);
+		}
+		//Finish the file. Returns false if anything failed to write.
+		bool close() {
+			if (!stream)
+				return true;
+			fputc(0x3B, stream);
+			bool ok = !ferror(stream);
+			fclose(stream);
+			stream = NULL;
+			return ok;
+		}
+		//DESTRUCTOR
+		~gifwriter() {
+			close();
+		}
+	private:
+		FILE* stream;
+		int width;
+		int height;
+		//Not copyable
+		gifwriter(const gifwriter&);
+		gifwriter& operator=(const gifwriter&);
+	};
+
+}
+
+#endif
@@ -0,0 +1,99 @@
+/* This header file looks up the few OpenGL functions newer than 1.1 that fgr uses (buffer
+ * objects, and timer queries for measuring how long the GPU takes). Windows only exports OpenGL 1.1 directly, so anything newer has to be
+ * asked of the driver once a context exists. Everything that uses these functions has a
+ * plain OpenGL 1.1 fallback for when they aren't there. */
+#pragma once
+
+#ifndef __FGR_GLEXT_H__
+#define __FGR_GLEXT_H__
+
+#include <cstddef>
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW 0x88E4
+#endif
+#ifndef GL_DYNAMIC_DRAW
+#define GL_DYNAMIC_DRAW 0x88E8
+#endif
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
+namespace fgr {
+
+	namespace glext {
+
+		typedef void (APIENTRY* genBuffersFunction)(GLsizei count, GLuint* buffers);
+		typedef void (APIENTRY* deleteBuffersFunction)(GLsizei count, const GLuint* buffers);
+		typedef void (APIENTRY* bindBufferFunction)(GLenum target, GLuint buffer);
+		typedef void (APIENTRY* bufferDataFunction)(GLenum target, std::ptrdiff_t size, const void* data, GLenum usage);
+		typedef void (APIENTRY* bufferSubDataFunction)(GLenum target, std::ptrdiff_t offset, std::ptrdiff_t size, const void* data);
+
+		genBuffersFunction genBuffers = NULL;
+		deleteBuffersFunction deleteBuffers = NULL;
+		bindBufferFunction bindBuffer = NULL;
+		bufferDataFunction bufferData = NULL;
+		bufferSubDataFunction bufferSubData = NULL;
+
+		typedef void (APIENTRY* genQueriesFunction)(GLsizei count, GLuint* queries);
+		typedef void (APIENTRY* deleteQueriesFunction)(GLsizei count, const GLuint* queries);
+		typedef void (APIENTRY* beginQueryFunction)(GLenum target, GLuint query);
+		typedef void (APIENTRY* endQueryFunction)(GLenum target);
+		typedef void (APIENTRY* getQueryObjectivFunction)(GLuint query, GLenum name, GLint* value);
+		typedef void (APIENTRY* getQueryObjectui64vFunction)(GLuint query, GLenum name, unsigned long long* value);
+
+		genQueriesFunction genQueries = NULL;
+		deleteQueriesFunction deleteQueries = NULL;
+		beginQueryFunction beginQuery = NULL;
+		endQueryFunction endQuery = NULL;
+		getQueryObjectivFunction getQueryObjectiv = NULL;
+		getQueryObjectui64vFunction getQueryObjectui64v = NULL;
+
+		//Look up the buffer object functions, if that hasn't been done yet. Needs a current context.
+		//Returns true if buffer objects can be used.
+		bool loadBuffers() {
+			static bool tried = false;
+			if (!tried) {
+				tried = true;
+				genBuffers = (genBuffersFunction)wglGetProcAddress("glGenBuffers");
+				deleteBuffers = (deleteBuffersFunction)wglGetProcAddress("glDeleteBuffers");
+				bindBuffer = (bindBufferFunction)wglGetProcAddress("glBindBuffer");
+				bufferData = (bufferDataFunction)wglGetProcAddress("glBufferData");
+				bufferSubData = (bufferSubDataFunction)wglGetProcAddress("glBufferSubData");
+			}
+			return genBuffers && deleteBuffers && bindBuffer && bufferData && bufferSubData;
+		}
+
+		//Look up the query object functions, if that hasn't been done yet. Needs a current context.
+		//Returns true if the time the GPU takes can be measured (OpenGL 3.3 or ARB_timer_query).
+		bool loadQueries() {
+			static bool tried = false;
+			if (!tried) {
+				tried = true;
+				genQueries = (genQueriesFunction)wglGetProcAddress("glGenQueries");
+				deleteQueries = (deleteQueriesFunction)wglGetProcAddress("glDeleteQueries");
+				beginQuery = (beginQueryFunction)wglGetProcAddress("glBeginQuery");
+				endQuery = (endQueryFunction)wglGetProcAddress("glEndQuery");
+				getQueryObjectiv = (getQueryObjectivFunction)wglGetProcAddress("glGetQueryObjectiv");
+				getQueryObjectui64v = (getQueryObjectui64vFunction)wglGetProcAddress("glGetQueryObjectui64v");
+			}
+			return genQueries && deleteQueries && beginQuery && endQuery && getQueryObjectiv && getQueryObjectui64v;
+		}
+
+	}
+
+}
+
+#endif
@@ -0,0 +1,343 @@
+/* This header file defines the pieces for drawing many copies of fgr art with very few
+ * draw calls. Art is flattened once into colored vertices grouped into runs (a run is
+ * drawn with one glDrawArrays), then every copy is placed by an affine worked out on the
+ * CPU and streamed into one vertex buffer. Runs that draw the same way are merged, even
+ * across other copies as long as nothing they'd jump ahead of overlaps them, so a whole
+ * painting usually takes a handful of calls and still looks as it does in painter's order. Only OpenGL 1.1 vertex arrays are needed; buffer objects are used when
+ * the driver has them. */
+#pragma once
+
+#ifndef __FGR_INSTANCE_H__
+#define __FGR_INSTANCE_H__
+
+#include "fgrbake.h"
+#include "fgrsoftware.h"
+#include "fgrglext.h"
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+
+namespace fgr {
+
+	//One vertex of flattened art: where it is, and its color as four bytes
+	struct colorvertex {
+		GLfloat x, y;
+		GLubyte rgba[4];
+	};
+
+	//A run of vertices drawn with one call
+	struct vertexrun {
+		GLenum mode;
+		GLint first;
+		GLsizei count;
+		GLfloat lineWidth;
+		GLfloat pointSize;
+	};
+
+	//Which runs make up one frame of some art
+	struct vertexframe {
+		std::size_t firstRun;
+		std::size_t runs;
+	};
+
+	//Whether two runs can be drawn as one (every run holds independent primitives, so they can)
+	inline bool mergeable(const vertexrun& before, const vertexrun& after) {
+		return before.mode == after.mode
+			&& (after.mode != GL_LINES || before.lineWidth == after.lineWidth)
+			&& (after.mode != GL_POINTS || before.pointSize == after.pointSize);
+	}
+
+	/* Append a shape to a list of vertices and runs, transformed by 'where'. It joins the last
+	 * run if that draws the same way, unless the last run is before 'firstMergeable'. */
+	void appendShape(const shape& art, const affine& where, std::vector<colorvertex>& vertices,
+		std::vector<vertexrun>& runs, std::size_t firstMergeable = 0) {
+		glyph flat = separable(art);
+		if (!flat.size())
+			return;
+		vertexrun run;
+		run.mode = flat.mode;
+		run.first = GLint(vertices.size());
+		run.count = 0;
+		run.lineWidth = art.lineThickness;
+		run.pointSize = art.pointSize;
+		if (runs.size() <= firstMergeable || !mergeable(runs.back(), run))
+			runs.push_back(run);
+		std::uint32_t packed = packRGBA(art.color);
+		colorvertex v;
+		memcpy(v.rgba, &packed, sizeof(v.rgba));
+		for (glyph::const_iterator itr = flat.begin(); itr != flat.end(); ++itr) {
+			v.x = itr->x();
+			v.y = itr->y();
+			where.apply(v.x, v.y);
+			vertices.push_back(v);
+		}
+		runs.back().count += GLsizei(flat.size());
+	}
+
+	//Every frame of an animation, flattened into runs of colored vertices (all frames in one list)
+	class vertexart {
+	public:
+		// REPRESENTATION
+		std::vector<colorvertex> vertices;
+		std::vector<vertexrun> runs;
+		std::vector<vertexframe> frames;
+		//How many vertices there are in all (kept even if the list is let go of)
+		std::size_t vertexCount;
+
+		//Flatten every frame of an animation
+		vertexart(const animation& art) {
+			for (animation::const_iterator itr = art.begin(); itr != art.end(); ++itr) {
+				vertexframe f;
+				f.firstRun = runs.size();
+				for (graphic::const_iterator shp = itr->begin(); shp != itr->end(); ++shp)
+					appendShape(*shp, affine(), vertices, runs, f.firstRun);
+				f.runs = runs.size() - f.firstRun;
+				frames.push_back(f);
+			}
+			vertexCount = vertices.size();
+		}
+		//How much memory this takes up, in bytes
+		std::size_t bytes() const {
+			return sizeof(*this) + vertexCount * sizeof(colorvertex)
+				+ runs.capacity() * sizeof(vertexrun) + frames.capacity() * sizeof(vertexframe);
+		}
+		//Append a copy of one frame, transformed by 'where', merging runs with what's already there
+		void appendInstance(std::size_t frame, const affine& where,
+			std::vector<colorvertex>& out, std::vector<vertexrun>& outRuns) const {
+			if (frame >= frames.size() || vertices.empty())
+				return;
+			const vertexframe& f = frames[frame];
+			for (std::size_t r = f.firstRun; r < f.firstRun + f.runs; ++r) {
+				vertexrun run = runs[r];
+				run.first = GLint(out.size());
+				if (!outRuns.empty() && mergeable(outRuns.back(), run))
+					outRuns.back().count += run.count;
+				else
+					outRuns.push_back(run);
+				for (GLint v = runs[r].first; v < runs[r].first + runs[r].count; ++v) {
+					colorvertex moved = vertices[v];
+					where.apply(moved.x, moved.y);
+					out.push_back(moved);
+				}
+			}
+		}
+		virtual ~vertexart() {}
+	};
+
+	/* Gathers copies of art, then lays their runs out so that runs which draw the same way share
+	 * a call, even when other art comes between them. A run only ever moves ahead of runs it
+	 * doesn't overlap, so the result looks just as it would drawn in painter's order. */
+	class instancebatch {
+	public:
+		// CONSTRUCTORS
+		instancebatch() : grouper(LOOKBACK) {
+			pixel = 0.0f;
+		}
+
+		// FUNCTIONS
+		//Forget everything gathered. 'unitsPerPixel' is how big a pixel is where the vertices are
+		//(0 if unknown), since lines and points reach that far past their vertices.
+		void clear(float unitsPerPixel = 0.0f) {
+			staged.clear();
+			pieces.clear();
+			pixel = unitsPerPixel;
+		}
+		//Gather a copy of one frame of some art, transformed by 'where'
+		void append(const vertexart& art, std::size_t frame, const affine& where) {
+			if (frame >= art.frames.size() || art.vertices.empty())
+				return;
+			const vertexframe& f = art.frames[frame];
+			for (std::size_t r = f.firstRun; r < f.firstRun + f.runs; ++r) {
+				piece p;
+				p.run = art.runs[r];
+				p.run.first = GLint(staged.size());
+				p.box = drawbox::none();
+				for (GLint v = art.runs[r].first; v < art.runs[r].first + art.runs[r].count; ++v) {
+					colorvertex moved = art.vertices[v];
+					where.apply(moved.x, moved.y);
+					staged.push_back(moved);
+					p.box.add(moved.x, moved.y, moved.x, moved.y);
+				}
+				float reach = pixel * (1.0f + 0.5f * (p.run.mode == GL_POINTS ? p.run.pointSize
+					: p.run.mode == GL_LINES ? p.run.lineWidth : 0.0f));
+				p.box.add(p.box.left - reach, p.box.bottom - reach, p.box.right + reach, p.box.top + reach);
+				p.next = NO_PIECE;
+				pieces.push_back(p);
+			}
+		}
+		//Lay out everything gathered as vertices and the runs that draw them
+		void finish(std::vector<colorvertex>& vertices, std::vector<vertexrun>& runs) {
+			groups.clear();
+			grouper.clear();
+			for (std::size_t i = 0; i < pieces.size(); ++i) {
+				std::size_t joined = grouper.place(pieces[i].box, [&](std::size_t g) {
+					return mergeable(groups[g].run, pieces[i].run);
+				});
+				if (joined == groups.size()) {
+					group fresh;
+					fresh.run = pieces[i].run;
+					fresh.run.count = 0;
+					fresh.firstPiece = fresh.lastPiece = i;
+					groups.push_back(fresh);
+				}
+				else {
+					group& g = groups[joined];
+					pieces[g.lastPiece].next = i;
+					g.lastPiece = i;
+				}
+			}
+			vertices.clear();
+			runs.clear();
+			vertices.reserve(staged.size());
+			for (std::size_t g = 0; g < groups.size(); ++g) {
+				vertexrun run = groups[g].run;
+				run.first = GLint(vertices.size());
+				for (std::size_t i = groups[g].firstPiece; i != NO_PIECE; i = pieces[i].next)
+					vertices.insert(vertices.end(), staged.begin() + pieces[i].run.first,
+						staged.begin() + pieces[i].run.first + pieces[i].run.count);
+				run.count = GLsizei(vertices.size() - run.first);
+				runs.push_back(run);
+			}
+		}
+		//How many runs were gathered, which is how many calls drawing them one at a time would take
+		std::size_t gathered() const {
+			return pieces.size();
+		}
+		//How much memory this takes up, in bytes
+		std::size_t bytes() const {
+			return sizeof(*this) + staged.capacity() * sizeof(colorvertex) + pieces.capacity() * sizeof(piece)
+				+ groups.capacity() * sizeof(group) + grouper.capacity() * sizeof(drawbox);
+		}
+	private:
+		static const std::size_t NO_PIECE = std::size_t(-1);
+		//How many groups a run looks back through for one to join, so crowded art stays linear
+		static const std::size_t LOOKBACK = 64;
+		//One gathered run, with where it draws and the next run of its group
+		struct piece {
+			vertexrun run;
+			drawbox box;
+			std::size_t next;
+		};
+		//Runs that are drawn with one call, first to last
+		struct group {
+			vertexrun run;
+			std::size_t firstPiece;
+			std::size_t lastPiece;
+		};
+		std::vector<colorvertex> staged;
+		std::vector<piece> pieces;
+		std::vector<group> groups;
+		drawgrouper grouper;
+		float pixel;
+	};
+
+	/* Flatten the art of every component of a painting. Components whose animations are
+	 * identical share one copy. */
+	std::vector<std::shared_ptr<vertexart> > shareArt(const painting& art) {
+		std::vector<std::shared_ptr<vertexart> > retv;
+		//Every distinct animation so far, by fingerprint (which only suggests they match, so they're compared too)
+		typedef std::unordered_multimap<std::size_t, std::pair<const animation*, std::shared_ptr<vertexart> > > artmap;
+		artmap seen;
+		for (painting::const_iterator itr = art.begin(); itr != art.end(); ++itr) {
+			std::size_t key = fingerprint(*itr);
+			std::pair<artmap::iterator, artmap::iterator> candidates = seen.equal_range(key);
+			artmap::iterator found = candidates.first;
+			while (found != candidates.second && !sameArt(*found->second.first, *itr))
+				++found;
+			if (found == candidates.second)
+				found = seen.insert(std::make_pair(key, std::make_pair((const animation*)&*itr, std::make_shared<vertexart>(*itr))));
+			retv.push_back(found->second.second);
+		}
+		return retv;
+	}
+
+	//The angle, in radians, of an oscillation some seconds in. Frequencies too small to matter are
+	//still. Only the fractional part of the cycle count is kept, so precision holds up over time.
+	double oscillationPhase(float frequency, double seconds) {
+		if (fabsf(frequency) <= 0.001f)
+			return 0.0;
+		double cycles = double(frequency) * seconds;
+		return (cycles - floor(cycles)) * 2.0 * PI;
+	}
+
+	/* Where a painting component is some seconds in, in closed form: x swings on a cosine and
+	 * y on a sine about its position (a circle when they match), it spins rotfreq turns a
+	 * second from its rotation, and its scale pulses on a sine. */
+	affine pose(const component& art, double seconds) {
+		float x = art.position.x() + art.posamp.x() * float(cos(oscillationPhase(art.posfreq.x(), seconds)));
+		float y = art.position.y() + art.posamp.y() * float(sin(oscillationPhase(art.posfreq.y(), seconds)));
+		float angle = art.rotation + float(oscillationPhase(art.rotfreq, seconds));
+		float magnitude = art.scale + art.scaleamp * float(sin(oscillationPhase(art.scalefreq, seconds)));
+		float cosine = cosf(angle) * magnitude, sine = sinf(angle) * magnitude;
+		return affine(cosine, -sine, sine, cosine, x, y);
+	}
+
+	//Multiply the current OpenGL matrix by an affine
+	void multMatrix(const affine& f) {
+		GLfloat m[16] = { f.a, f.c, 0.0f, 0.0f,  f.b, f.d, 0.0f, 0.0f,  0.0f, 0.0f, 1.0f, 0.0f,  f.tx, f.ty, 0.0f, 1.0f };
+		glMultMatrixf(m);
+	}
+
+	//Draw runs of vertices. 'base' points at the first vertex, or is NULL if they're in the bound buffer.
+	void drawRuns(const colorvertex* base, const vertexrun* runs, std::size_t count) {
+		if (!count)
+			return;
+		const char* bytes = (const char*)base;
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_COLOR_ARRAY);
+		glVertexPointer(2, GL_FLOAT, sizeof(colorvertex), bytes + offsetof(colorvertex, x));
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(colorvertex), bytes + offsetof(colorvertex, rgba));
+		for (std::size_t r = 0; r < count; ++r) {
+			if (runs[r].mode == GL_LINES)
+				glLineWidth(runs[r].lineWidth);
+			else if (runs[r].mode == GL_POINTS)
+				glPointSize(runs[r].pointSize);
+			glDrawArrays(runs[r].mode, runs[r].first, runs[r].count);
+			++primitivesDrawn;
+			verticesDrawn += runs[r].count;
+		}
+		glDisableClientState(GL_COLOR_ARRAY);
+		glDisableClientState(GL_VERTEX_ARRAY);
+	}
+
+	//A vertex buffer that's refilled every time it's drawn, for vertices that change every frame
+	class vertexstream {
+	public:
+		vertexstream() {
+			buffer = 0;
+		}
+		//Upload some vertices and draw them
+		void draw(const std::vector<colorvertex>& vertices, const std::vector<vertexrun>& runs) {
+			if (vertices.empty() || runs.empty())
+				return;
+			if (!glext::loadBuffers()) {
+				drawRuns(&vertices[0], &runs[0], runs.size());
+				return;
+			}
+			if (!buffer)
+				glext::genBuffers(1, &buffer);
+			glext::bindBuffer(GL_ARRAY_BUFFER, buffer);
+			//Respecifying the whole buffer lets the driver hand over fresh memory instead of waiting on the last frame
+			glext::bufferData(GL_ARRAY_BUFFER, std::ptrdiff_t(vertices.size() * sizeof(colorvertex)), &vertices[0], GL_STREAM_DRAW);
+			drawRuns(NULL, &runs[0], runs.size());
+			glext::bindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+		//DESTRUCTOR
+		~vertexstream() {
+			if (buffer)
+				glext::deleteBuffers(1, &buffer);
+		}
+	private:
+		GLuint buffer;
+		//Not copyable, since it owns a buffer
+		vertexstream(const vertexstream&);
+		vertexstream& operator=(const vertexstream&);
+	};
+
+}
+
+#endif
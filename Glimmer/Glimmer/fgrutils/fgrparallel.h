@@ -0,0 +1,64 @@
+/* This header file defines some small helpers for spreading fgr work across every
+ * core on the machine. None of these touch OpenGL, so they are safe to call from
+ * anywhere. */
+#pragma once
+
+#ifndef __FGR_PARALLEL_H__
+#define __FGR_PARALLEL_H__
+
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+namespace fgr {
+
+	namespace parallel {
+
+		//How many worker threads we should use for CPU-heavy jobs (never less than one)
+		unsigned int workerCount() {
+			unsigned int cores = std::thread::hardware_concurrency();
+			if (!cores)
+				return 1;
+			return cores;
+		}
+
+		/* Split the range [first, last) into contiguous chunks and hand each one to a worker.
+		 * The job is called as job(chunkBegin, chunkEnd, workerIndex), and every worker
+		 * index is below workerCount(). Returns once every chunk is finished. */
+		template<class function>
+		void forChunks(std::size_t first, std::size_t last, function job) {
+			if (last <= first)
+				return;
+			std::size_t total = last - first;
+			std::size_t workers = workerCount();
+			if (workers > total)
+				workers = total;
+			//No sense in spinning up a thread for one chunk
+			if (workers == 1) {
+				job(first, last, 0u);
+				return;
+			}
+			std::vector<std::thread> crew;
+			crew.reserve(workers - 1);
+			std::size_t chunk = total / workers;
+			std::size_t leftover = total % workers;
+			std::size_t begin = first;
+			for (std::size_t w = 0; w < workers; ++w) {
+				std::size_t end = begin + chunk + (w < leftover ? 1 : 0);
+				//The calling thread takes the last chunk itself
+				if (w + 1 == workers)
+					job(begin, end, static_cast<unsigned int>(w));
+				else
+					crew.push_back(std::thread(job, begin, end, static_cast<unsigned int>(w)));
+				begin = end;
+			}
+			for (std::size_t w = 0; w < crew.size(); ++w) {
+				crew[w].join();
+			}
+		}
+
+	}
+
+}
+
+#endif
@@ -0,0 +1,291 @@
+/* This header file defines a small, dependency-free PNG writer. Rows are filtered the
+ * way libpng does by default (the cheapest of None, Sub, Up and Paeth for each row) and
+ * then compressed with a greedy LZ77 pass coded with deflate's fixed Huffman tables. That
+ * gets most of zlib's ratio on flat vector art, without needing zlib. */
+#pragma once
+
+#ifndef __FGR_PNG_H__
+#define __FGR_PNG_H__
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+
+namespace fgr {
+
+	namespace png {
+
+		//CRC-32 as used by PNG chunks
+		std::uint32_t crc32(const unsigned char* data, std::size_t length, std::uint32_t crc = 0) {
+			static std::uint32_t table[256];
+			static bool tableReady = false;
+			if (!tableReady) {
+				for (std::uint32_t n = 0; n < 256; ++n) {
+					std::uint32_t c = n;
+					for (int k = 0; k < 8; ++k)
+						c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+					table[n] = c;
+				}
+				tableReady = true;
+			}
+			crc = ~crc;
+			for (std::size_t i = 0; i < length; ++i)
+				crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+			return ~crc;
+		}
+
+		//Adler-32 as used by zlib streams
+		std::uint32_t adler32(const unsigned char* data, std::size_t length) {
+			std::uint32_t a = 1, b = 0;
+			while (length) {
+				//5552 is the most bytes that can be summed before the sums could overflow
+				std::size_t block = length < 5552 ? length : 5552;
+				length -= block;
+				while (block--) {
+					a += *data++;
+					b += a;
+				}
+				a %= 65521;
+				b %= 65521;
+			}
+			return (b << 16) | a;
+		}
+
+		//Writes bits least-significant first, as deflate expects
+		class bitwriter {
+		public:
+			std::vector<unsigned char>& out;
+			std::uint32_t buffer;
+			int count;
+			bitwriter(std::vector<unsigned char>& target) : out(target) {
+				buffer = 0;
+				count = 0;
+			}
+			void put(std::uint32_t bits, int length) {
+				buffer |= bits << count;
+				count += length;
+				while (count >= 8) {
+					out.push_back((unsigned char)(buffer & 0xFF));
+					buffer >>= 8;
+					count -= 8;
+				}
+			}
+			//Huffman codes are stored most-significant bit first
+			void putCode(std::uint32_t code, int length) {
+				std::uint32_t reversed = 0;
+				for (int i = 0; i < length; ++i)
+					reversed |= ((code >> i) & 1) << (length - 1 - i);
+				put(reversed, length);
+			}
+			void flush() {
+				if (count)
+					out.push_back((unsigned char)(buffer & 0xFF));
+				buffer = 0;
+				count = 0;
+			}
+		};
+
+		//Code a literal/length symbol with the fixed Huffman table
+		void putSymbol(bitwriter& bits, int symbol) {
+			if (symbol < 144)
+				bits.putCode(0x30 + symbol, 8);
+			else if (symbol < 256)
+				bits.putCode(0x190 + symbol - 144, 9);
+			else if (symbol < 280)
+				bits.putCode(symbol - 256, 7);
+			else
+				bits.putCode(0xC0 + symbol - 280, 8);
+		}
+
+		//Compress bytes into a zlib stream
+		std::vector<unsigned char> deflate(const std::vector<unsigned char>& data) {
+			static const int lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+				35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			static const int lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+				3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+			static const int distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+				257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+			static const int distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+				7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+			const std::size_t WINDOW = 32768;
+			const int HASH_BITS = 15;
+			std::vector<unsigned char> retv;
+			//zlib header: deflate, 32K window, fastest compression
+			retv.push_back(0x78);
+			retv.push_back(0x01);
+			bitwriter bits(retv);
+			//One final block using the fixed Huffman tables
+			bits.put(1, 1);
+			bits.put(1, 2);
+			std::vector<std::int64_t> recent(std::size_t(1) << HASH_BITS, -1);
+			std::size_t n = data.size();
+			std::size_t i = 0;
+			while (i < n) {
+				int bestLength = 0;
+				std::size_t bestDistance = 0;
+				if (i + 3 <= n) {
+					std::uint32_t hash = ((std::uint32_t(data[i]) << 16) | (std::uint32_t(data[i + 1]) << 8) | data[i + 2]) * 2654435761u;
+					hash >>= 32 - HASH_BITS;
+					std::int64_t candidate = recent[hash];
+					recent[hash] = std::int64_t(i);
+					if (candidate >= 0 && i - std::size_t(candidate) <= WINDOW) {
+						std::size_t c = std::size_t(candidate);
+						std::size_t most = n - i < 258 ? n - i : 258;
+						std::size_t length = 0;
+						while (length < most && data[c + length] == data[i + length])
+							++length;
+						if (length >= 3) {
+							bestLength = int(length);
+							bestDistance = i - c;
+						}
+					}
+				}
+				if (!bestLength) {
+					putSymbol(bits, data[i]);
+					++i;
+					continue;
+				}
+				int code = 28;
+				while (lengthBase[code] > bestLength)
+					--code;
+				putSymbol(bits, 257 + code);
+				bits.put(bestLength - lengthBase[code], lengthExtra[code]);
+				int dcode = 29;
+				while (distanceBase[dcode] > int(bestDistance))
+					--dcode;
+				bits.putCode(dcode, 5);
+				bits.put(std::uint32_t(bestDistance - distanceBase[dcode]), distanceExtra[dcode]);
+				//Remember where the skipped-over bytes were, so later matches can find them
+				for (std::size_t k = i + 1; k < i + bestLength && k + 3 <= n; ++k) {
+					std::uint32_t hash = ((std::uint32_t(data[k]) << 16) | (std::uint32_t(data[k + 1]) << 8) | data[k + 2]) * 2654435761u;
+					recent[hash >> (32 - HASH_BITS)] = std::int64_t(k);
+				}
+				i += bestLength;
+			}
+			//End of block
+			putSymbol(bits, 256);
+			bits.flush();
+			std::uint32_t check = adler32(data.empty() ? NULL : &data[0], data.size());
+			for (int shift = 24; shift >= 0; shift -= 8)
+				retv.push_back((unsigned char)(check >> shift));
+			return retv;
+		}
+
+		//The Paeth predictor from the PNG specification
+		int paeth(int a, int b, int c) {
+			int p = a + b - c;
+			int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+			if (pa <= pb && pa <= pc)
+				return a;
+			return pb <= pc ? b : c;
+		}
+
+		//Append a chunk (length, type, data, CRC) to a file in memory
+		void putChunk(std::vector<unsigned char>& file, const char* type, const std::vector<unsigned char>& data) {
+			unsigned char header[8];
+			std::uint32_t length = std::uint32_t(data.size());
+			for (int i = 0; i < 4; ++i)
+				header[i] = (unsigned char)(length >> (24 - 8 * i));
+			for (int i = 0; i < 4; ++i)
+				header[4 + i] = (unsigned char)type[i];
+			std::uint32_t crc = crc32(header + 4, 4);
+			if (!data.empty())
+				crc = crc32(&data[0], data.size(), crc);
+			unsigned char footer[4];
+			for (int i = 0; i < 4; ++i)
+				footer[i] = (unsigned char)(crc >> (24 - 8 * i));
+			file.insert(file.end(), header, header + 8);
+			file.insert(file.end(), data.begin(), data.end());
+			file.insert(file.end(), footer, footer + 4);
+		}
+
+	}
+
+	/* Encode an RGBA image (four bytes per pixel, straight alpha) as a complete PNG file in memory.
+	 * Rows are read top to bottom, unless bottomUp is set (as it is for glReadPixels-style images).
+	 * Returns nothing if the image is empty. */
+	std::vector<unsigned char> encodePNG(int width, int height, const unsigned char* rgba, bool bottomUp = false) {
+		std::vector<unsigned char> file;
+		if (width <= 0 || height <= 0 || !rgba)
+			return file;
+		std::size_t stride = std::size_t(width) * 4;
+		//Filter every row, choosing the filter with the smallest sum of absolute differences
+		std::vector<unsigned char> filtered;
+		filtered.reserve((stride + 1) * height);
+		std::vector<unsigned char> candidate[5];
+		for (int f = 0; f < 5; ++f)
+			candidate[f].resize(stride);
+		for (int y = 0; y < height; ++y) {
+			const unsigned char* row = rgba + stride * std::size_t(bottomUp ? height - 1 - y : y);
+			const unsigned char* above = y ? rgba + stride * std::size_t(bottomUp ? height - y : y - 1) : NULL;
+			int bestFilter = 0;
+			long bestScore = -1;
+			for (int f = 0; f < 5; ++f) {
+				//Average (3) is rarely the winner on flat art, so it isn't tried
+				if (f == 3)
+					continue;
+				long score = 0;
+				for (std::size_t i = 0; i < stride; ++i) {
+					int a = i >= 4 ? row[i - 4] : 0;
+					int b = above ? above[i] : 0;
+					int c = (above && i >= 4) ? above[i - 4] : 0;
+					int predicted = 0;
+					switch (f) {
+					case 1: predicted = a; break;
+					case 2: predicted = b; break;
+					case 4: predicted = png::paeth(a, b, c); break;
+					default: break;
+					}
+					unsigned char value = (unsigned char)(row[i] - predicted);
+					candidate[f][i] = value;
+					score += value < 128 ? value : 256 - value;
+				}
+				if (bestScore < 0 || score < bestScore) {
+					bestScore = score;
+					bestFilter = f;
+				}
+			}
+			filtered.push_back((unsigned char)bestFilter);
+			filtered.insert(filtered.end(), candidate[bestFilter].begin(), candidate[bestFilter].end());
+		}
+		static const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+		file.insert(file.end(), signature, signature + 8);
+		std::vector<unsigned char> header(13, 0);
+		for (int i = 0; i < 4; ++i) {
+			header[i] = (unsigned char)(std::uint32_t(width) >> (24 - 8 * i));
+			header[4 + i] = (unsigned char)(std::uint32_t(height) >> (24 - 8 * i));
+		}
+		header[8] = 8;	//Bit depth
+		header[9] = 6;	//Color type: RGBA
+		png::putChunk(file, "IHDR", header);
+		png::putChunk(file, "IDAT", png::deflate(filtered));
+		png::putChunk(file, "IEND", std::vector<unsigned char>());
+		return file;
+	}
+
+	//Write bytes to a file, replacing it. Returns false if the file couldn't be written.
+	bool writeBytes(const std::string& path, const std::vector<unsigned char>& bytes) {
+		FILE* stream = NULL;
+		fopen_s(&stream, path.c_str(), "wb");
+		if (!stream)
+			return false;
+		if (!bytes.empty())
+			fwrite(&bytes[0], 1, bytes.size(), stream);
+		bool ok = !ferror(stream);
+		fclose(stream);
+		return ok;
+	}
+
+	/* Write an RGBA image (four bytes per pixel, straight alpha) to a PNG file. Rows are read
+	 * top to bottom, unless bottomUp is set (as it is for glReadPixels-style images).
+	 * Returns false if the file couldn't be written. */
+	bool writePNG(const std::string& path, int width, int height, const unsigned char* rgba, bool bottomUp = false) {
+		std::vector<unsigned char> file = encodePNG(width, height, rgba, bottomUp);
+		return !file.empty() && writeBytes(path, file);
+	}
+
+}
+
+#endif
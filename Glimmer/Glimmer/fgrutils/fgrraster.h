@@ -0,0 +1,454 @@
+/* This header file defines the anti-aliased rasterizer used for exporting art as images.
+ * Every primitive is turned into a convex polygon in pixel space, and each polygon edge
+ * adds its exact (signed) area coverage into an accumulation buffer; a running sum along
+ * each row then gives every pixel's coverage. The image is cut into tiles that are
+ * rendered in parallel, and each shape is only visited by the tiles its bounds overlap. */
+#pragma once
+
+#ifndef __FGR_RASTER_H__
+#define __FGR_RASTER_H__
+
+#include "fgrbake.h"
+#include "fgrparallel.h"
+#include "fgrpng.h"
+
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+namespace fgr {
+
+	//Statistics about a finished rasterization
+	class rasterreport {
+	public:
+		//How many tiles the image was cut into
+		std::size_t tiles;
+		//How many (polygon, tile) pairs were rendered
+		std::size_t binned;
+		//How long rasterization took, in milliseconds
+		float milliseconds;
+		//Default constructor
+		rasterreport() {
+			tiles = 0;
+			binned = 0;
+			milliseconds = 0.0f;
+		}
+		//Pixels produced per second, in millions
+		float megapixelsPerSecond(int width, int height) const {
+			if (milliseconds <= 0.0f)
+				return 0.0f;
+			return float(width) * float(height) / (milliseconds * 1000.0f);
+		}
+	};
+
+	namespace raster {
+
+		//Side length of a tile, in pixels
+		const int TILE_SIZE = 64;
+
+		//A shape flattened into convex polygons, in pixel co-ordinates (y down)
+		struct flatshape {
+			//Premultiplied color
+			float r, g, b, a;
+			//Every polygon's vertices, back to back
+			std::vector<float> xs;
+			std::vector<float> ys;
+			//Where each polygon starts in xs/ys (with one extra entry marking the end)
+			std::vector<std::size_t> starts;
+			//Bounds of every polygon together
+			float left, top, right, bottom;
+
+			flatshape() {
+				r = g = b = a = 0.0f;
+				left = top = 1e30f;
+				right = bottom = -1e30f;
+				starts.push_back(0);
+			}
+			//Add a polygon from some points, wound counter-clockwise (on screen) so coverage always adds up
+			void addPolygon(const float* px, const float* py, std::size_t count) {
+				float area = 0.0f;
+				for (std::size_t i = 0; i < count; ++i) {
+					std::size_t j = (i + 1) % count;
+					area += px[i] * py[j] - px[j] * py[i];
+				}
+				if (area == 0.0f || area != area)
+					return;
+				for (std::size_t k = 0; k < count; ++k) {
+					std::size_t i = area > 0.0f ? k : count - 1 - k;
+					xs.push_back(px[i]);
+					ys.push_back(py[i]);
+					left = std::min(left, px[i]);
+					right = std::max(right, px[i]);
+					top = std::min(top, py[i]);
+					bottom = std::max(bottom, py[i]);
+				}
+				starts.push_back(xs.size());
+			}
+			//Add a line as a rectangle of some width (with square ends, like a wide GL line)
+			void addLine(float x0, float y0, float x1, float y1, float width) {
+				float dx = x1 - x0, dy = y1 - y0;
+				float length = sqrtf(dx * dx + dy * dy);
+				if (length <= 0.0f)
+					return;
+				float half = width / 2.0f;
+				float nx = -dy / length * half, ny = dx / length * half;
+				float px[4] = { x0 + nx, x1 + nx, x1 - nx, x0 - nx };
+				float py[4] = { y0 + ny, y1 + ny, y1 - ny, y0 - ny };
+				addPolygon(px, py, 4);
+			}
+			//Add a point as a square of some size
+			void addPoint(float x, float y, float size) {
+				float half = size / 2.0f;
+				float px[4] = { x - half, x + half, x + half, x - half };
+				float py[4] = { y - half, y - half, y + half, y + half };
+				addPolygon(px, py, 4);
+			}
+		};
+
+		//Flatten a shape into pixel space. Line widths and point sizes are multiplied by pixelScale.
+		flatshape flatten(const shape& obj, const affine& toPixels, float pixelScale) {
+			flatshape rets;
+			float alpha = obj.color.getLevel('a');
+			rets.r = obj.color.getLevel('r') * alpha;
+			rets.g = obj.color.getLevel('g') * alpha;
+			rets.b = obj.color.getLevel('b') * alpha;
+			rets.a = alpha;
+			glyph art = separable(obj);
+			std::vector<float> px, py;
+			for (glyph::const_iterator itr = art.begin(); itr != art.end(); ++itr) {
+				float x = itr->x(), y = itr->y();
+				toPixels.apply(x, y);
+				px.push_back(x);
+				py.push_back(y);
+			}
+			std::size_t n = px.size();
+			//Lines and points never get thinner than a pixel, just like on screen
+			float lineWidth = std::max(1.0f, obj.lineThickness * pixelScale);
+			float pointSize = std::max(1.0f, obj.pointSize * pixelScale);
+			switch (art.mode) {
+			case glPoints:
+				for (std::size_t i = 0; i < n; ++i)
+					rets.addPoint(px[i], py[i], pointSize);
+				break;
+			case glLines:
+				for (std::size_t i = 0; i + 1 < n; i += 2)
+					rets.addLine(px[i], py[i], px[i + 1], py[i + 1], lineWidth);
+				break;
+			case glTriangles:
+				for (std::size_t i = 0; i + 2 < n; i += 3)
+					rets.addPolygon(&px[i], &py[i], 3);
+				break;
+			case glQuads:
+				for (std::size_t i = 0; i + 3 < n; i += 4)
+					rets.addPolygon(&px[i], &py[i], 4);
+				break;
+			default:
+				break;
+			}
+			return rets;
+		}
+
+		//Coverage accumulated for one tile, plus the span of columns touched on each row
+		struct accumulator {
+			int size;
+			std::vector<float> acc;
+			std::vector<int> rowMin;
+			std::vector<int> rowMax;
+			//Tiles are 'side' pixels square; each row gets two spare columns for edges on the right side
+			accumulator(int side) : acc(std::size_t(side + 2) * side, 0.0f), rowMin(side, side + 2), rowMax(side, -1) {
+				size = side;
+			}
+			float* row(int y) {
+				return &acc[std::size_t(y) * (size + 2)];
+			}
+			void touch(int y, int first, int last) {
+				rowMin[y] = std::min(rowMin[y], first);
+				rowMax[y] = std::max(rowMax[y], last);
+			}
+		};
+
+		//Add one edge's exact area coverage to the accumulator, within a width x height corner of it.
+		//Parts of the edge left of that area land in column 0.
+		void accumulateEdge(accumulator& buffer, int width, int height, float x0, float y0, float x1, float y1) {
+			if (y0 == y1)
+				return;
+			float dir = 1.0f;
+			if (y0 > y1) {
+				std::swap(x0, x1);
+				std::swap(y0, y1);
+				dir = -1.0f;
+			}
+			if (y1 <= 0.0f || y0 >= float(height))
+				return;
+			float dxdy = (x1 - x0) / (y1 - y0);
+			//Clip to the buffer's rows
+			if (y0 < 0.0f) {
+				x0 -= y0 * dxdy;
+				y0 = 0.0f;
+			}
+			if (y1 > float(height)) {
+				x1 -= (y1 - float(height)) * dxdy;
+				y1 = float(height);
+			}
+			float right = float(width);
+			float x = x0;
+			for (int y = int(y0); y < height && float(y) < y1; ++y) {
+				float dy = std::min(float(y + 1), y1) - std::max(float(y), y0);
+				float xnext = x + dxdy * dy;
+				float d = dy * dir;
+				float* line = buffer.row(y);
+				//Clamp to the buffer's columns; what's left of it still covers everything to its right
+				float xa = std::min(std::max(std::min(x, xnext), 0.0f), right);
+				float xb = std::min(std::max(std::max(x, xnext), 0.0f), right);
+				float xafloor = floorf(xa);
+				int xai = int(xafloor);
+				int xbi = int(ceilf(xb));
+				if (xbi <= xai + 1) {
+					float xmf = 0.5f * (xa + xb) - xafloor;
+					line[xai] += d - d * xmf;
+					line[xai + 1] += d * xmf;
+					buffer.touch(y, xai, xai + 1);
+				}
+				else {
+					float s = 1.0f / (xb - xa);
+					float xaf = xa - xafloor;
+					float a0 = 0.5f * s * (1.0f - xaf) * (1.0f - xaf);
+					float xbf = xb - float(xbi) + 1.0f;
+					float am = 0.5f * s * xbf * xbf;
+					line[xai] += d * a0;
+					if (xbi == xai + 2) {
+						line[xai + 1] += d * (1.0f - a0 - am);
+					}
+					else {
+						float a1 = s * (1.5f - xaf);
+						line[xai + 1] += d * (a1 - a0);
+						for (int xi = xai + 2; xi < xbi - 1; ++xi)
+							line[xi] += d * s;
+						float a2 = a1 + float(xbi - xai - 3) * s;
+						line[xbi - 1] += d * (1.0f - a2 - am);
+					}
+					line[xbi] += d * am;
+					buffer.touch(y, xai, xbi);
+				}
+				x = xnext;
+			}
+		}
+
+		//Add one edge, cutting it where it crosses the left and right sides of the area
+		//so the clamped pieces stay straight
+		void accumulateClippedEdge(accumulator& buffer, int width, int height, float x0, float y0, float x1, float y1) {
+			float cuts[2] = { 0.0f, float(width) };
+			float ts[4] = { 0.0f, 1.0f, 1.0f, 1.0f };
+			int count = 1;
+			for (int c = 0; c < 2; ++c) {
+				if ((x0 - cuts[c]) * (x1 - cuts[c]) < 0.0f)
+					ts[count++] = (cuts[c] - x0) / (x1 - x0);
+			}
+			std::sort(ts, ts + count);
+			ts[count] = 1.0f;
+			for (int i = 0; i < count; ++i) {
+				accumulateEdge(buffer, width, height,
+					x0 + (x1 - x0) * ts[i], y0 + (y1 - y0) * ts[i],
+					x0 + (x1 - x0) * ts[i + 1], y0 + (y1 - y0) * ts[i + 1]);
+			}
+		}
+
+		//True if a convex polygon (wound as flatshape winds them) overlaps the square
+		//[left, left + side) x [top, top + side). Bounds have already been checked.
+		bool overlaps(const flatshape& s, std::size_t first, std::size_t last, float left, float top, float side) {
+			for (std::size_t v = first; v < last; ++v) {
+				std::size_t w = v + 1 < last ? v + 1 : first;
+				float ex = s.xs[w] - s.xs[v], ey = s.ys[w] - s.ys[v];
+				//The inside of every edge is where this cross product is positive; pick the square's
+				//corner that reaches furthest inside, and if even that is outside, they can't overlap
+				float cx = ey < 0.0f ? left + side : left;
+				float cy = ex > 0.0f ? top + side : top;
+				if (ex * (cy - s.ys[v]) - ey * (cx - s.xs[v]) < 0.0f)
+					return false;
+			}
+			return true;
+		}
+
+		//One polygon to draw in a tile
+		struct binentry {
+			std::size_t shape;
+			std::size_t polygon;
+		};
+
+	}
+
+	/* Rasterize a graphic, anti-aliased, into a width x height RGBA image (straight alpha, top row first)
+	 * showing the rectangle 'view' of the plane. The image starts out as 'background'. Line widths and
+	 * point sizes are multiplied by pixelScale, so exports can match what's seen on screen at any size.
+	 * Callers that are already running one rasterize per core can turn threading off. */
+	void rasterize(const graphic& art, const segment& view, int width, int height, float pixelScale,
+		const fcolor& background, std::vector<unsigned char>& rgba, rasterreport& report, bool threaded = true) {
+		std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+		report = rasterreport();
+		rgba.assign(std::size_t(std::max(width, 0)) * std::max(height, 0) * 4, 0);
+		if (width <= 0 || height <= 0 || view.width() == 0.0f || view.height() == 0.0f)
+			return;
+		float sx = float(width) / view.width();
+		float sy = float(height) / view.height();
+		//Pixel rows run downwards from the top of the view
+		affine toPixels(sx, 0.0f, 0.0f, -sy, -view.p1.x() * sx, view.p2.y() * sy);
+		std::vector<raster::flatshape> shapes(art.size());
+		auto flattenShapes = [&](std::size_t first, std::size_t last, unsigned int) {
+			for (std::size_t i = first; i < last; ++i)
+				shapes[i] = raster::flatten(art[i], toPixels, pixelScale);
+		};
+		if (threaded)
+			parallel::forChunks(0, art.size(), flattenShapes);
+		else
+			flattenShapes(0, art.size(), 0u);
+		//Bin every polygon into the tiles it really touches, keeping the drawing order
+		const int T = raster::TILE_SIZE;
+		int columns = (width + T - 1) / T;
+		int rows = (height + T - 1) / T;
+		std::vector<std::vector<raster::binentry> > bins(std::size_t(columns) * rows);
+		for (std::size_t i = 0; i < shapes.size(); ++i) {
+			const raster::flatshape& s = shapes[i];
+			if (s.a <= 0.0f)
+				continue;
+			for (std::size_t poly = 0; poly + 1 < s.starts.size(); ++poly) {
+				std::size_t first = s.starts[poly], last = s.starts[poly + 1];
+				float left = 1e30f, top = 1e30f, right = -1e30f, bottom = -1e30f;
+				for (std::size_t v = first; v < last; ++v) {
+					left = std::min(left, s.xs[v]);
+					right = std::max(right, s.xs[v]);
+					top = std::min(top, s.ys[v]);
+					bottom = std::max(bottom, s.ys[v]);
+				}
+				if (right < 0.0f || bottom < 0.0f || left >= width || top >= height)
+					continue;
+				int c0 = std::max(0, int(left) / T), c1 = std::min(columns - 1, int(right) / T);
+				int r0 = std::max(0, int(top) / T), r1 = std::min(rows - 1, int(bottom) / T);
+				bool small = c0 == c1 && r0 == r1;
+				raster::binentry entry = { i, poly };
+				for (int r = r0; r <= r1; ++r) {
+					for (int c = c0; c <= c1; ++c) {
+						if (small || raster::overlaps(s, first, last, float(c * T), float(r * T), float(T)))
+							bins[std::size_t(r) * columns + c].push_back(entry);
+					}
+				}
+			}
+		}
+		report.tiles = bins.size();
+		for (std::size_t b = 0; b < bins.size(); ++b)
+			report.binned += bins[b].size();
+		float bgAlpha = background.getLevel('a');
+		float bg[4] = { background.getLevel('r') * bgAlpha, background.getLevel('g') * bgAlpha,
+			background.getLevel('b') * bgAlpha, bgAlpha };
+		//Workers pull tiles off a shared counter, so busy tiles don't hold everyone else up
+		std::atomic<std::size_t> nextTile(0);
+		auto drawTiles = [&](std::size_t, std::size_t, unsigned int) {
+			raster::accumulator buffer(T);
+			std::vector<float> color(std::size_t(T) * T * 4);
+			for (std::size_t tile = nextTile++; tile < bins.size(); tile = nextTile++) {
+				int originX = int(tile % columns) * T;
+				int originY = int(tile / columns) * T;
+				int tw = std::min(T, width - originX);
+				int th = std::min(T, height - originY);
+				for (std::size_t p = 0; p < std::size_t(T) * T; ++p)
+					for (int k = 0; k < 4; ++k)
+						color[p * 4 + k] = bg[k];
+				const std::vector<raster::binentry>& bin = bins[tile];
+				for (std::size_t k = 0; k < bin.size(); ++k) {
+					const raster::flatshape& s = shapes[bin[k].shape];
+					std::size_t first = s.starts[bin[k].polygon], last = s.starts[bin[k].polygon + 1];
+					for (std::size_t v = first; v < last; ++v) {
+						std::size_t w = v + 1 < last ? v + 1 : first;
+						raster::accumulateClippedEdge(buffer, tw, th,
+							s.xs[v] - originX, s.ys[v] - originY, s.xs[w] - originX, s.ys[w] - originY);
+					}
+					//Every polygon of a shape is accumulated before the shape is blended, so shared edges leave no seams
+					if (k + 1 < bin.size() && bin[k + 1].shape == bin[k].shape)
+						continue;
+					//Sum along each touched row to turn edge areas into coverage, and blend the shape over the tile
+					for (int y = 0; y < th; ++y) {
+						if (buffer.rowMin[y] > buffer.rowMax[y])
+							continue;
+						float* line = buffer.row(y);
+						float* pixel = &color[std::size_t(y) * T * 4];
+						float sum = 0.0f;
+						for (int x = buffer.rowMin[y]; x <= buffer.rowMax[y]; ++x) {
+							sum += line[x];
+							line[x] = 0.0f;
+							float coverage = std::min(1.0f, fabsf(sum));
+							if (x >= tw || coverage <= 0.0f)
+								continue;
+							float keep = 1.0f - s.a * coverage;
+							pixel[x * 4 + 0] = s.r * coverage + pixel[x * 4 + 0] * keep;
+							pixel[x * 4 + 1] = s.g * coverage + pixel[x * 4 + 1] * keep;
+							pixel[x * 4 + 2] = s.b * coverage + pixel[x * 4 + 2] * keep;
+							pixel[x * 4 + 3] = s.a * coverage + pixel[x * 4 + 3] * keep;
+						}
+						buffer.rowMin[y] = T + 2;
+						buffer.rowMax[y] = -1;
+					}
+				}
+				//Un-premultiply into the image
+				for (int y = 0; y < th; ++y) {
+					unsigned char* out = &rgba[(std::size_t(originY + y) * width + originX) * 4];
+					const float* pixel = &color[std::size_t(y) * T * 4];
+					for (int x = 0; x < tw; ++x) {
+						float a = pixel[x * 4 + 3];
+						float inverse = a > 0.0f ? 1.0f / a : 0.0f;
+						for (int k = 0; k < 3; ++k)
+							out[x * 4 + k] = (unsigned char)(std::min(1.0f, pixel[x * 4 + k] * inverse) * 255.0f + 0.5f);
+						out[x * 4 + 3] = (unsigned char)(std::min(1.0f, a) * 255.0f + 0.5f);
+					}
+				}
+			}
+		};
+		if (threaded)
+			parallel::forChunks(0, parallel::workerCount(), drawTiles);
+		else
+			drawTiles(0, 1, 0u);
+		report.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started).count();
+	}
+
+	//Pad a box by some fraction of its size, then grow it to match an image's aspect ratio.
+	//Returns a unit box around the origin if there's nothing to fit.
+	segment fitView(segment box, int width, int height, float padding) {
+		if (!(box.width() > 0.0f) || !(box.height() > 0.0f) || width <= 0 || height <= 0)
+			box = segment(-1.0f, -1.0f, 1.0f, 1.0f);
+		float padX = box.width() * padding, padY = box.height() * padding;
+		box = segment(box.p1.x() - padX, box.p1.y() - padY, box.p2.x() + padX, box.p2.y() + padY);
+		float aspect = width > 0 && height > 0 ? float(width) / float(height) : 1.0f;
+		if (box.width() / box.height() < aspect) {
+			float grow = (box.height() * aspect - box.width()) / 2.0f;
+			return segment(box.p1.x() - grow, box.p1.y(), box.p2.x() + grow, box.p2.y());
+		}
+		float grow = (box.width() / aspect - box.height()) / 2.0f;
+		return segment(box.p1.x(), box.p1.y() - grow, box.p2.x(), box.p2.y() + grow);
+	}
+
+	//The box around every vertex of a graphic (inverted, p1 > p2, if it has none)
+	segment vertexBounds(const graphic& art) {
+		segment rets(1e30f, 1e30f, -1e30f, -1e30f);
+		for (graphic::const_iterator shp = art.begin(); shp != art.end(); ++shp) {
+			for (glyph::const_iterator itr = shp->begin(); itr != shp->end(); ++itr) {
+				rets.p1 = point(fminf(rets.p1.x(), itr->x()), fminf(rets.p1.y(), itr->y()));
+				rets.p2 = point(fmaxf(rets.p2.x(), itr->x()), fmaxf(rets.p2.y(), itr->y()));
+			}
+		}
+		return rets;
+	}
+
+	/* Export a graphic as an anti-aliased PNG, fitted (with a little padding) into width x height pixels
+	 * on a transparent background. Returns false if the file couldn't be written. */
+	bool exportPNG(const graphic& art, const std::string& path, int width, int height, float pixelScale, rasterreport& report) {
+		segment view = fitView(vertexBounds(art), width, height, 0.05f);
+		std::vector<unsigned char> rgba;
+		rasterize(art, view, width, height, pixelScale, fcolor(0.0f, 0.0f, 0.0f, 0.0f), rgba, report);
+		if (rgba.empty())
+			return false;
+		return writePNG(path, width, height, &rgba[0]);
+	}
+
+}
+
+#endif
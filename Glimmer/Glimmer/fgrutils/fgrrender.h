@@ -0,0 +1,226 @@
+/* This header file defines the render backend abstraction. A renderer accepts the small
+ * subset of fixed-function OpenGL that fgr art is drawn with (colors, line widths, point
+ * sizes, primitives and a 2D matrix stack), so the same fgr::draw calls can target the
+ * screen through OpenGL or an image in memory through the software rasterizer. */
+#pragma once
+
+#ifndef __FGR_RENDER_H__
+#define __FGR_RENDER_H__
+
+#include "fgrdrawing.h"
+
+#include <vector>
+#include <cstddef>
+#include <cmath>
+
+namespace fgr {
+
+	//Something fgr art can be drawn onto
+	class renderer {
+	public:
+		//Set the color used by following vertices
+		virtual void color(const fcolor& col) = 0;
+		//Set the width of following lines, in pixels
+		virtual void lineWidth(float width) = 0;
+		//Set the size of following points, in pixels
+		virtual void pointSize(float size) = 0;
+		//Start, feed and finish a primitive, just like glBegin/glVertex/glEnd
+		virtual void begin(GLmode mode) = 0;
+		virtual void vertex(float x, float y) = 0;
+		virtual void end() = 0;
+		//The 2D matrix stack, just like glPushMatrix/glPopMatrix/glTranslatef/glRotatef/glScalef
+		virtual void pushMatrix() = 0;
+		virtual void popMatrix() = 0;
+		virtual void translate(float x, float y) = 0;
+		//Rotate counter-clockwise, in radians
+		virtual void rotate(float angle) = 0;
+		virtual void scale(float factor) = 0;
+		//DESTRUCTOR
+		virtual ~renderer() {}
+	};
+
+	//The 2D matrix stack, for renderers that move vertices through it themselves
+	class matrixstack {
+	public:
+		matrixstack() {
+			reset();
+		}
+		//Go back to just the identity
+		void reset() {
+			stack.assign(1, affine());
+		}
+		void push() { stack.push_back(stack.back()); }
+		//The bottom matrix is never popped
+		void pop() {
+			if (stack.size() > 1)
+				stack.pop_back();
+		}
+		void translate(float x, float y) { stack.back() = stack.back() * affine(1.0f, 0.0f, 0.0f, 1.0f, x, y); }
+		//Rotate counter-clockwise, in radians
+		void rotate(float angle) {
+			float cosine = cosf(angle), sine = sinf(angle);
+			stack.back() = stack.back() * affine(cosine, -sine, sine, cosine, 0.0f, 0.0f);
+		}
+		void scale(float factor) { stack.back() = stack.back() * affine(factor, 0.0f, 0.0f, factor, 0.0f, 0.0f); }
+		//The matrix vertices are moved through now
+		const affine& top() const {
+			return stack.back();
+		}
+	private:
+		//Never empty
+		std::vector<affine> stack;
+	};
+
+	//Where a draw reaches, for telling whether two draws can trade places
+	struct drawbox {
+		float left, bottom, right, top;
+		//A box around nothing, which grows to fit whatever is added
+		static drawbox none() {
+			drawbox retv;
+			retv.left = retv.bottom = 1e30f;
+			retv.right = retv.top = -1e30f;
+			return retv;
+		}
+		void add(float l, float b, float r, float t) {
+			left = l < left ? l : left;
+			bottom = b < bottom ? b : bottom;
+			right = r > right ? r : right;
+			top = t > top ? t : top;
+		}
+		void add(const drawbox& other) {
+			add(other.left, other.bottom, other.right, other.top);
+		}
+		bool overlaps(const drawbox& other) const {
+			return left <= other.right && other.left <= right && bottom <= other.top && other.bottom <= top;
+		}
+	};
+
+	/* Sorts draws, in painter's order, into groups that can each be drawn with one call. A draw
+	 * joins the latest group that will take it, unless a group after that one overlaps it, so
+	 * drawing group by group always looks the same as drawing in order. Only the last 'lookback'
+	 * groups are searched, so crowded art stays linear. */
+	class drawgrouper {
+	public:
+		explicit drawgrouper(std::size_t lookback) : lookback(lookback) {}
+		void clear() {
+			boxes.clear();
+		}
+		/* Place the next draw, returning its group. 'joins(g)' says whether it can share a call
+		 * with group g. A new group is the next index, size() - 1 afterwards. */
+		template<class Joins>
+		std::size_t place(const drawbox& box, Joins joins) {
+			std::size_t stop = boxes.size() > lookback ? boxes.size() - lookback : 0;
+			for (std::size_t g = boxes.size(); g-- > stop;) {
+				if (joins(g)) {
+					boxes[g].add(box);
+					return g;
+				}
+				if (boxes[g].overlaps(box))
+					break;
+			}
+			boxes.push_back(box);
+			return boxes.size() - 1;
+		}
+		//How many groups there are
+		std::size_t size() const {
+			return boxes.size();
+		}
+		//Where a group's draws reach
+		const drawbox& box(std::size_t group) const {
+			return boxes[group];
+		}
+		std::size_t capacity() const {
+			return boxes.capacity();
+		}
+	private:
+		std::size_t lookback;
+		std::vector<drawbox> boxes;
+	};
+
+	//Draws straight to the current OpenGL context
+	class glrenderer : public renderer {
+	public:
+		void color(const fcolor& col) { setcolor(col); }
+		void lineWidth(float width) { glLineWidth(width); }
+		void pointSize(float size) { glPointSize(size); }
+		void begin(GLmode mode) { glBegin(mode); }
+		void vertex(float x, float y) { glVertex2f(x, y); }
+		void end() { glEnd(); }
+		void pushMatrix() { glPushMatrix(); }
+		void popMatrix() { glPopMatrix(); }
+		void translate(float x, float y) { glTranslatef(x, y, 0.0f); }
+		void rotate(float angle) { glRotatef(angle / PI * 180.0f, 0.0f, 0.0f, 1.0f); }
+		void scale(float factor) { glScalef(factor, factor, factor); }
+	};
+
+	//Render a glyph onto a renderer, at the origin of its matrix
+	void draw(const fgr::glyph& obj, renderer& target) {
+		//Beziers are evaluated on the CPU, so every backend plots the same curve
+		if (obj.bezier) {
+			draw(evaluateBezier(obj, BEZIER_RESOLUTION), target);
+			return;
+		}
+		target.begin(obj.mode);
+		for (glyph::const_iterator itr = obj.begin(); itr != obj.end(); ++itr) {
+			target.vertex(itr->x(), itr->y());
+		}
+		target.end();
+	}
+
+	//Render a shape onto a renderer
+	void draw(const fgr::shape& obj, renderer& target) {
+		target.color(obj.color);
+		target.lineWidth(obj.lineThickness);
+		target.pointSize(obj.pointSize);
+		draw((const glyph&)obj, target);
+	}
+
+	//Render a graphic onto a renderer
+	void draw(const fgr::graphic& obj, renderer& target) {
+		for (graphic::const_iterator itr = obj.begin(); itr != obj.end(); ++itr) {
+			draw(*itr, target);
+		}
+	}
+
+	//Render an animation's current frame onto a renderer
+	void draw(const fgr::animation& obj, renderer& target) {
+		if (obj.size())
+			draw(*(obj.currentframe), target);
+	}
+
+	//Render a painting component's current frame onto a renderer, in place
+	void draw(const fgr::component& obj, renderer& target) {
+		target.pushMatrix();
+			target.translate(obj.position.x(), obj.position.y());
+			target.rotate(obj.rotation);
+			target.scale(obj.scale);
+			draw((const animation&)obj, target);
+		target.popMatrix();
+	}
+
+	//Render every component of a painting onto a renderer
+	void draw(const fgr::painting& obj, renderer& target) {
+		for (painting::const_iterator itr = obj.begin(); itr != obj.end(); ++itr) {
+			draw(*itr, target);
+		}
+	}
+
+	//Render a fractal to some depth onto a renderer
+	void draw(const fgr::fractal& pattern, int depth, renderer& target) {
+		if (depth <= 0)
+			return;
+		draw((const shape&)pattern, target);
+		for (std::size_t i = 0; i < pattern.branchPoints.size(); ++i) {
+			const fractal_mantle& instructions = pattern.branchPoints[i];
+			target.pushMatrix();
+				target.translate(instructions.location.x(), instructions.location.y());
+				target.scale(instructions.scale);
+				target.rotate(instructions.rotation);
+				draw(pattern, depth - 1, target);
+			target.popMatrix();
+		}
+	}
+
+}
+
+#endif
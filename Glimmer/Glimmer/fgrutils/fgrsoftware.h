@@ -0,0 +1,245 @@
+/* This header file defines a pure-CPU renderer that rasterizes fgr art into an image in
+ * memory. It follows OpenGL's (non anti-aliased) rules closely enough that a graphic
+ * looks the same as it does on screen, but needs no window or GL context at all, so art
+ * can be drawn, tested and benchmarked headless. */
+#pragma once
+
+#ifndef __FGR_SOFTWARE_H__
+#define __FGR_SOFTWARE_H__
+
+#include "fgrrender.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace fgr {
+
+	//Pack a color into the four bytes R, G, B, A (in that order in memory)
+	std::uint32_t packRGBA(const fcolor& col) {
+		unsigned char bytes[4];
+		bytes[0] = (unsigned char)(col.getLevel('r') * 255.0f + 0.5f);
+		bytes[1] = (unsigned char)(col.getLevel('g') * 255.0f + 0.5f);
+		bytes[2] = (unsigned char)(col.getLevel('b') * 255.0f + 0.5f);
+		bytes[3] = (unsigned char)(col.getLevel('a') * 255.0f + 0.5f);
+		std::uint32_t packed;
+		memcpy(&packed, bytes, sizeof(packed));
+		return packed;
+	}
+
+	//Rasterizes into an RGBA image in memory
+	class softrenderer : public renderer {
+	public:
+		// REPRESENTATION
+		//Size of the image, in pixels
+		int width;
+		int height;
+		//Every pixel (see packRGBA), row by row from the bottom, just like glReadPixels
+		std::vector<std::uint32_t> pixels;
+		//How many pixels have been written since the last clear
+		unsigned long fragments;
+		//How many primitives have been drawn since the last clear
+		unsigned long primitives;
+
+		//Construct an image of some size that shows a rectangle of the plane
+		//(view.p1 is bottom-left, view.p2 is top-right), just like glOrtho
+		softrenderer(int w, int h, const segment& view) : pixels(std::size_t(std::max(w, 0)) * std::size_t(std::max(h, 0)), 0u) {
+			width = std::max(w, 0);
+			height = std::max(h, 0);
+			fragments = 0;
+			primitives = 0;
+			float sx = view.width() ? float(width) / view.width() : 0.0f;
+			float sy = view.height() ? float(height) / view.height() : 0.0f;
+			projection = affine(sx, 0.0f, 0.0f, sy, -view.p1.x() * sx, -view.p1.y() * sy);
+			ink = packRGBA(fcolor(1.0f, 1.0f, 1.0f, 1.0f));
+			widthOfLines = 1.0f;
+			sizeOfPoints = 1.0f;
+			mode = glPoints;
+		}
+		//Fill the whole image with one color
+		void clear(const fcolor& col) {
+			std::fill(pixels.begin(), pixels.end(), packRGBA(col));
+			fragments = 0;
+			primitives = 0;
+		}
+		//The color of a pixel (0, 0 is bottom-left)
+		std::uint32_t pixel(int x, int y) const {
+			return pixels[std::size_t(y) * width + x];
+		}
+
+		// RENDERER
+		void color(const fcolor& col) { ink = packRGBA(col); }
+		void lineWidth(float w) { widthOfLines = w; }
+		void pointSize(float size) { sizeOfPoints = size; }
+		void begin(GLmode newMode) {
+			mode = newMode;
+			xs.clear();
+			ys.clear();
+		}
+		void vertex(float x, float y) {
+			(projection * matrices.top()).apply(x, y);
+			xs.push_back(x);
+			ys.push_back(y);
+		}
+		void end() {
+			std::size_t n = xs.size();
+			switch (mode) {
+			case glPoints:
+				for (std::size_t i = 0; i < n; ++i)
+					fillPoint(xs[i], ys[i]);
+				break;
+			case glLines:
+				for (std::size_t i = 0; i + 1 < n; i += 2)
+					fillLine(i, i + 1);
+				break;
+			case glLineStrip:
+			case glLineLoop:
+				for (std::size_t i = 0; i + 1 < n; ++i)
+					fillLine(i, i + 1);
+				if (mode == glLineLoop && n > 2)
+					fillLine(n - 1, 0);
+				break;
+			case glTriangles:
+				for (std::size_t i = 0; i + 2 < n; i += 3)
+					fillTriangle(xs[i], ys[i], xs[i + 1], ys[i + 1], xs[i + 2], ys[i + 2]);
+				break;
+			case glTriangleStrip:
+				for (std::size_t i = 0; i + 2 < n; ++i)
+					fillTriangle(xs[i], ys[i], xs[i + 1], ys[i + 1], xs[i + 2], ys[i + 2]);
+				break;
+			//Polygons are convex as far as OpenGL is concerned, so they fill just like fans
+			case glTriangleFan:
+			case glPolygon:
+				for (std::size_t i = 1; i + 1 < n; ++i)
+					fillTriangle(xs[0], ys[0], xs[i], ys[i], xs[i + 1], ys[i + 1]);
+				break;
+			case glQuads:
+				for (std::size_t i = 0; i + 3 < n; i += 4) {
+					fillTriangle(xs[i], ys[i], xs[i + 1], ys[i + 1], xs[i + 2], ys[i + 2]);
+					fillTriangle(xs[i], ys[i], xs[i + 2], ys[i + 2], xs[i + 3], ys[i + 3]);
+				}
+				break;
+			case glQuadStrip:
+				for (std::size_t i = 0; i + 3 < n; i += 2) {
+					fillTriangle(xs[i], ys[i], xs[i + 1], ys[i + 1], xs[i + 3], ys[i + 3]);
+					fillTriangle(xs[i], ys[i], xs[i + 3], ys[i + 3], xs[i + 2], ys[i + 2]);
+				}
+				break;
+			default:
+				break;
+			}
+			xs.clear();
+			ys.clear();
+		}
+		void pushMatrix() { matrices.push(); }
+		void popMatrix() { matrices.pop(); }
+		void translate(float x, float y) { matrices.translate(x, y); }
+		void rotate(float angle) { matrices.rotate(angle); }
+		void scale(float factor) { matrices.scale(factor); }
+
+	private:
+		//Maps the plane onto pixels
+		affine projection;
+		matrixstack matrices;
+		//Current drawing state
+		std::uint32_t ink;
+		float widthOfLines;
+		float sizeOfPoints;
+		GLmode mode;
+		//The current primitive's vertices, already in pixels
+		std::vector<float> xs;
+		std::vector<float> ys;
+
+		//Fill pixels [x0, x1] of row y
+		void span(int y, int x0, int x1) {
+			if (y < 0 || y >= height)
+				return;
+			x0 = std::max(x0, 0);
+			x1 = std::min(x1, width - 1);
+			if (x0 > x1)
+				return;
+			std::fill(pixels.begin() + (std::size_t(y) * width + x0), pixels.begin() + (std::size_t(y) * width + x1 + 1), ink);
+			fragments += x1 - x0 + 1;
+		}
+		//Draw one triangle
+		void fillTriangle(float x0, float y0, float x1, float y1, float x2, float y2) {
+			++primitives;
+			rasterTriangle(x0, y0, x1, y1, x2, y2);
+		}
+		//Fill every pixel whose centre is inside a triangle (shared edges are only filled once)
+		void rasterTriangle(float x0, float y0, float x1, float y1, float x2, float y2) {
+			float area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+			if (area == 0.0f || area != area)
+				return;
+			//Wind counter-clockwise so the inside is to the left of every edge
+			if (area < 0.0f) {
+				std::swap(x1, x2);
+				std::swap(y1, y2);
+			}
+			float ex[3] = { x0, x1, x2 };
+			float ey[3] = { y0, y1, y2 };
+			int bottom = std::max(0, int(floorf(std::min(y0, std::min(y1, y2)))));
+			int top = std::min(height - 1, int(ceilf(std::max(y0, std::max(y1, y2)))));
+			for (int row = bottom; row <= top; ++row) {
+				float py = row + 0.5f;
+				float lo = -1.0f, hi = float(width);
+				bool empty = false;
+				for (int e = 0; e < 3 && !empty; ++e) {
+					float ax = ex[e], ay = ey[e];
+					float bx = ex[(e + 1) % 3], by = ey[(e + 1) % 3];
+					//Inside where slope * px + offset >= 0 (or > 0 on edges that aren't top-left)
+					float slope = ay - by;
+					float offset = (bx - ax) * (py - ay) - slope * ax;
+					bool inclusive = (by < ay) || (by == ay && bx < ax);
+					if (slope == 0.0f) {
+						if (offset < 0.0f || (offset == 0.0f && !inclusive))
+							empty = true;
+						continue;
+					}
+					//Convert the crossing into a bound on pixel index (pixel i has its centre at i + 0.5)
+					float cross = -offset / slope - 0.5f;
+					if (slope > 0.0f) {
+						float bound = inclusive ? ceilf(cross) : floorf(cross) + 1.0f;
+						lo = std::max(lo, bound);
+					}
+					else {
+						float bound = inclusive ? floorf(cross) : ceilf(cross) - 1.0f;
+						hi = std::min(hi, bound);
+					}
+				}
+				if (!empty && lo <= hi)
+					span(row, int(std::max(lo, -1.0f)), int(std::min(hi, float(width))));
+			}
+		}
+		//Fill a wide line between two vertices the way OpenGL does: as a parallelogram
+		//stretched along the minor axis
+		void fillLine(std::size_t from, std::size_t to) {
+			++primitives;
+			float half = std::max(1.0f, floorf(widthOfLines + 0.5f)) / 2.0f;
+			float x0 = xs[from], y0 = ys[from], x1 = xs[to], y1 = ys[to];
+			if (fabsf(x1 - x0) >= fabsf(y1 - y0)) {
+				rasterTriangle(x0, y0 - half, x1, y1 - half, x1, y1 + half);
+				rasterTriangle(x0, y0 - half, x1, y1 + half, x0, y0 + half);
+			}
+			else {
+				rasterTriangle(x0 - half, y0, x1 - half, y1, x1 + half, y1);
+				rasterTriangle(x0 - half, y0, x1 + half, y1, x0 + half, y0);
+			}
+		}
+		//Fill a square point, centred on the vertex
+		void fillPoint(float x, float y) {
+			++primitives;
+			float size = std::max(1.0f, floorf(sizeOfPoints + 0.5f));
+			int left = int(ceilf(x - size / 2.0f - 0.5f));
+			int bottom = int(ceilf(y - size / 2.0f - 0.5f));
+			int side = int(size);
+			for (int row = bottom; row < bottom + side; ++row)
+				span(row, left, left + side - 1);
+		}
+	};
+
+}
+
+#endif
@@ -6,5 +6,14 @@
 #include "fgrclasses.h"
 #include "fgrdrawing.h"
 #include "fgrmenu.h"
+#include "fgrchaos.h"
+#include "fgrbake.h"
+#include "fgrrender.h"
+#include "fgrsoftware.h"
+#include "fgrcommands.h"
+#include "fgrraster.h"
+#include "fgrexport.h"
+#include "fgratlas.h"
+#include "fgrinstance.h"
 
 #endif
\ No newline at end of file
@@ -6,9 +6,11 @@
 
 #include "fgrcolor.h"
 
-//Global variables to help keep track of window size
-GLsizei windowHeight;
-GLsizei windowWidth;
+#include <atomic>
+
+//Global variables to help keep track of window size (read by the render thread, too)
+std::atomic<GLsizei> windowHeight(0);
+std::atomic<GLsizei> windowWidth(0);
 
 
 //Clears the screen
@@ -11,6 +11,9 @@
 
 #include <Windows.h>
 #include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
 
 namespace glut32 {
 	//Converts a c-style string to a long-pointer-character-wide-string object, making a 
@@ -62,6 +65,78 @@ namespace glut32 {
 	void maximizeWindow(const char* windowName) {
 		ShowWindow(getWindowHandle(windowName), SW_SHOWMAXIMIZED);
 	}
+
+	//Set how many vertical blanks glutSwapBuffers waits for on the current window (0 turns vsync off).
+	//Returns false if the driver doesn't support changing it.
+	bool setSwapInterval(int interval) {
+		typedef BOOL(WINAPI* swapIntervalFunction)(int);
+		swapIntervalFunction wglSwapIntervalEXT = (swapIntervalFunction)wglGetProcAddress("wglSwapIntervalEXT");
+		if (!wglSwapIntervalEXT)
+			return false;
+		return wglSwapIntervalEXT(interval) != FALSE;
+	}
+
+	//Get the device context of the window whose OpenGL context is current on this thread
+	HDC currentDevice() {
+		return wglGetCurrentDC();
+	}
+
+	//Make a second OpenGL context for the current window, sharing textures and buffers with the
+	//current one, so that another thread can draw into the window. Returns NULL if it can't.
+	HGLRC createSharedContext() {
+		HDC device = wglGetCurrentDC();
+		HGLRC current = wglGetCurrentContext();
+		if (!device || !current)
+			return NULL;
+		HGLRC shared = wglCreateContext(device);
+		if (!shared)
+			return NULL;
+		if (!wglShareLists(current, shared)) {
+			wglDeleteContext(shared);
+			return NULL;
+		}
+		return shared;
+	}
+
+	//Make a context current on the calling thread (pass NULLs to let go of the current one)
+	bool makeCurrent(HDC device, HGLRC context) {
+		return wglMakeCurrent(device, context) != FALSE;
+	}
+
+	//Show what's been drawn into the back buffer of a window, from whichever thread drew it
+	void swapBuffers(HDC device) {
+		SwapBuffers(device);
+	}
+
+	//Delete a context made by createSharedContext (it mustn't be current anywhere)
+	void deleteContext(HGLRC context) {
+		if (context)
+			wglDeleteContext(context);
+	}
+
+	//Find every file matched by a path with wildcards (* and ?) in its last part, sorted by name.
+	//A path without wildcards is given back as it is, whether or not there's a file there.
+	std::vector<std::string> matchFiles(const std::string& pattern) {
+		std::vector<std::string> found;
+		if (pattern.find_first_of("*?") == std::string::npos) {
+			found.push_back(pattern);
+			return found;
+		}
+		//The search only gives back names, so the folder is put back in front of them
+		std::size_t slash = pattern.find_last_of("\\/");
+		std::string folder = slash == std::string::npos ? std::string() : pattern.substr(0, slash + 1);
+		WIN32_FIND_DATAA entry;
+		HANDLE search = FindFirstFileA(pattern.c_str(), &entry);
+		if (search == INVALID_HANDLE_VALUE)
+			return found;
+		do {
+			if (!(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+				found.push_back(folder + entry.cFileName);
+		} while (FindNextFileA(search, &entry));
+		FindClose(search);
+		std::sort(found.begin(), found.end());
+		return found;
+	}
 }
 
 
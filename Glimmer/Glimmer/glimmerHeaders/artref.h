@@ -0,0 +1,67 @@
+/* This header file defines the handles editors hold their art through. Copying a handle
+ * doesn't copy the art: every copy shares it, and it's only copied once one of them is about
+ * to change it while the others still hold it (copy-on-write). So opening a file in another
+ * tab, converting it, or taking a snapshot of a tab to draw or save costs nothing until the
+ * art is actually edited. The reference count is thread-safe, so a snapshot can be read on
+ * another thread while the tab it came from carries on (it copies before changing anything). */
+#pragma once
+
+#ifndef __artref_h__
+#define __artref_h__
+
+#include <memory>
+
+template <class T>
+class artref {
+public:
+	// CONSTRUCTORS
+	//An empty handle
+	artref() {}
+	//Take charge of some art made with new
+	explicit artref(T* art) : held(art) {}
+
+	// FUNCTIONS
+	//True if this handle holds any art
+	explicit operator bool() const {
+		return bool(held);
+	}
+	//Read the art; never copies it
+	const T& operator*() const {
+		return *held;
+	}
+	const T* operator->() const {
+		return held.get();
+	}
+	//The art, to be changed. It's copied first if another handle shares it.
+	T& write() {
+		unshare();
+		return *held;
+	}
+	//The art, without copying it even if it's shared. Only for keeping iterators into it:
+	//nothing may be changed through this without calling unshare() first.
+	T* get() const {
+		return held.get();
+	}
+	//True if another handle shares this art
+	bool shared() const {
+		return held && held.use_count() > 1;
+	}
+	//Make sure no other handle shares this art, copying it if one does
+	void unshare() {
+		if (shared())
+			held = std::make_shared<T>(*held);
+	}
+	//Let go of the art (it's deleted once no handle holds it)
+	void reset() {
+		held.reset();
+	}
+	//Start holding some other art, made with new
+	void reset(T* art) {
+		held.reset(art);
+	}
+
+private:
+	std::shared_ptr<T> held;
+};
+
+#endif
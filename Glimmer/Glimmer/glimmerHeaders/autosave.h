@@ -0,0 +1,187 @@
+/* This header file keeps copies of unsaved work beside the files being edited, so a crash
+ * doesn't lose it. Every so often, each tab changed since it was last copied is copied (which
+ * costs next to nothing, since the copy shares the tab's art until the tab changes it again),
+ * and the copies are written out by a thread of their own, so the window never waits on the
+ * disk. A file's copy has ".recover" on the end of its name, and is deleted once the file is
+ * saved or its tab is closed; one that's still there when the file is opened holds changes
+ * from a session that ended without saving them. */
+#pragma once
+
+#ifndef __autosave_h__
+#define __autosave_h__
+
+#include "editor.h"
+#include "joiningthread.h"
+
+#include <string>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+
+namespace autosave {
+	//How often changed tabs are copied, in seconds (0 turns autosaving off; set with :autosave)
+	int interval = 30;
+
+	//Where the copy of a file's unsaved work goes
+	std::string recoveryPath(const std::string& filepath) {
+		return filepath + ".recover";
+	}
+
+	//True if there's a copy of unsaved work for a file
+	bool recoverable(const std::string& filepath) {
+		FILE* found = NULL;
+		fopen_s(&found, recoveryPath(filepath).c_str(), "rb");
+		if (!found)
+			return false;
+		std::fclose(found);
+		return true;
+	}
+
+	//Something for the writer to do: write a copy of a tab's art, or delete a file's copy
+	class job {
+	public:
+		//The file whose copy this is
+		std::string target;
+		//The copy to write (NULL to delete the file's copy instead)
+		std::unique_ptr<editor> snapshot;
+	};
+
+	//What's left for the writer to do, oldest first
+	std::deque<job> jobs;
+	//Guards the jobs, 'stopping' and the two counts below
+	std::mutex lock;
+	std::condition_variable wakeWriter;
+	//True once the writer should finish what's left and stop
+	bool stopping = false;
+	//How many copies have been written, and how many couldn't be
+	unsigned long written = 0;
+	unsigned long failed = 0;
+	void stop();
+	joiningthread writer(stop);
+	//True while a timer is waiting to copy the tabs
+	bool ticking = false;
+
+	//Do one job. Returns false if a copy couldn't be written.
+	bool carryOut(job& work) {
+		std::string path = recoveryPath(work.target);
+		if (!work.snapshot) {
+			std::remove(path.c_str());
+			return true;
+		}
+		//A vertex previewed while the button is held isn't part of the work (taking it out of the
+		//copy copies the art, so it's done here rather than on the window's thread)
+		work.snapshot->cancelInsertPreview();
+		//Written under another name first, so a crash part way through doesn't spoil the last copy
+		std::string partial = path + ".part";
+		if (!work.snapshot->saveCopy(partial)) {
+			std::remove(partial.c_str());
+			return false;
+		}
+		std::remove(path.c_str());
+		return std::rename(partial.c_str(), path.c_str()) == 0;
+	}
+
+	//What the writer does: take the oldest job and do it, until it's told to stop and there's nothing left
+	void run() {
+		std::unique_lock<std::mutex> hold(lock);
+		for (;;) {
+			wakeWriter.wait(hold, []() { return stopping || !jobs.empty(); });
+			if (jobs.empty())
+				return;
+			job work = std::move(jobs.front());
+			jobs.pop_front();
+			hold.unlock();
+			bool done = carryOut(work);
+			//The copy lets go of the art here, so the tab it came from stops sharing it
+			work.snapshot.reset();
+			hold.lock();
+			if (done)
+				++written;
+			else
+				++failed;
+		}
+	}
+
+	//Let the writer finish what's left and wait for it
+	void stop() {
+		{
+			std::lock_guard<std::mutex> hold(lock);
+			stopping = true;
+		}
+		wakeWriter.notify_all();
+		writer.join();
+	}
+
+	//Give the writer a job, starting it if it isn't running yet
+	void hand(job&& work) {
+		if (!writer.joinable())
+			writer.start(run);
+		{
+			std::lock_guard<std::mutex> hold(lock);
+			jobs.push_back(std::move(work));
+		}
+		wakeWriter.notify_one();
+	}
+
+	//Copy a tab if it's changed since it was last copied, and hand the copy to the writer. Tabs
+	//that are put away (they were copied just before) and blank tabs nobody will miss are left alone.
+	void capture(editor& tab) {
+		if (interval <= 0 || !tab.resident() || !tab.unsavedChanges || tab.blankFile || tab.revision == tab.autosavedRevision)
+			return;
+		job work;
+		work.target = tab.filepath;
+		work.snapshot.reset(new editor(tab));
+		//A copy starts at the first shape and knows nothing of a previewed vertex; it shares the
+		//art, so the tab's own iterators point into it, and the writer can take the preview out
+		if (tab.insertPreviewActive) {
+			work.snapshot->subGraphicShape = tab.subGraphicShape;
+			work.snapshot->insertPreviewVertex = tab.insertPreviewVertex;
+			work.snapshot->insertPreviewActive = true;
+		}
+		tab.autosavedRevision = tab.revision;
+		hand(std::move(work));
+	}
+
+	//Copy every tab changed since it was last copied
+	void capture() {
+		for (tabContainerType::iterator itr = tabs.begin(); itr != tabs.end(); ++itr)
+			capture(*itr);
+	}
+
+	//Delete a file's copy of unsaved work (after anything already handed to the writer for it)
+	void forget(const std::string& filepath) {
+		job work;
+		work.target = filepath;
+		hand(std::move(work));
+	}
+
+	//How many copies have been written so far, and how many couldn't be
+	void tally(unsigned long& wrote, unsigned long& couldnt) {
+		std::lock_guard<std::mutex> hold(lock);
+		wrote = written;
+		couldnt = failed;
+	}
+
+	void schedule();
+
+	//Called back every 'interval' seconds to copy the changed tabs
+	void tick(int) {
+		ticking = false;
+		if (interval <= 0)
+			return;
+		capture();
+		schedule();
+	}
+
+	//Wait 'interval' seconds, then copy the changed tabs (unless a timer is already waiting, or it's off)
+	void schedule() {
+		if (ticking || interval <= 0)
+			return;
+		ticking = true;
+		glutTimerFunc(interval * 1000, tick, 0);
+	}
+}
+
+#endif
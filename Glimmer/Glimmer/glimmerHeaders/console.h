@@ -4,8 +4,10 @@
 #define __console_h__
 
 #include <vector>
+#include <algorithm>
 #include <string>
 #include <sstream>
+#include <cstdlib>
 #include <map>
 #include <unordered_map>
 
@@ -133,8 +135,12 @@ namespace cli {
 	}
 	//Draw the console
 	void draw();
+	//Draw some text as the console of a particular tab
+	void drawField(const editor& tab, const std::string& field);
 	//Send a warning message that there are unsaved changes to the current tab
 	void warnUnsaved();
+	//Let the user know if a file being opened has unsaved changes left over from a session that ended early
+	void offerRecovery(const std::string& filepath);
 }
 
 //Exit the program
@@ -148,6 +154,13 @@ void cli::warnUnsaved() {
 	send_message("No write since last change (use ! to force)", uWarning);
 }
 
+//Let the user know if a file being opened has unsaved changes left over from a session that ended early
+void cli::offerRecovery(const std::string& filepath) {
+	if (autosave::recoverable(filepath))
+		send_message("Found unsaved changes to '" + splitPath(filepath).second
+			+ "' from a session that ended early (:recover to bring them back, :recover discard to delete them)", uWarning);
+}
+
 //Interpret and execute the commands from the input
 uCode cli::digest(const std::string& token) {
 	if (!token.size())
@@ -203,11 +216,69 @@ uCode cli::digest(const std::string& token) {
 	}
 	//Delete the shape currently being worked on
 	if (command == "dshape") {
-		//This causes a segmentation fault by setting subgraphicshape to currentgraphic()->end()
-		currentTab->subGraphicShape = currentTab->currentGraphic().erase(currentTab->subGraphicShape);
+		currentTab->eraseShape(currentTab->currentPlace().shape);
+		currentTab->makechange();
+		return uSuccess;
+	}
+	//Pick out every vertex, or none
+	if (command == "sel" || command == "select") {
+		if (input >> command) {
+			if (command == "all") {
+				currentTab->selectAll();
+				send_message(std::to_string(currentTab->selected.size()) + " vertices selected");
+				return uSuccess;
+			}
+			if (command == "none") {
+				currentTab->clearSelection();
+				return uSuccess;
+			}
+		}
+		send_message("Usage is :select <all/none>", uIncorrectUsage);
+		return uIncorrectUsage;
+	}
+	//Delete the selected vertices
+	if (command == "dsel") {
+		if (currentTab->selected.empty()) {
+			send_message("No vertices selected", uWarning);
+			return uWarning;
+		}
+		std::size_t count = currentTab->selected.size();
+		currentTab->eraseSelection();
+		currentTab->makechange();
+		send_message("Deleted " + std::to_string(count) + " vertices");
+		return uSuccess;
+	}
+	//Move, scale or rotate the selected vertices (scaling and rotating are about the middle of their box)
+	if (command == "move" || command == "scale" || command == "rotate") {
+		if (currentTab->selected.empty()) {
+			send_message("No vertices selected", uWarning);
+			return uWarning;
+		}
+		fgr::point centre = currentTab->selectionCentre();
+		float cx = centre.x(), cy = centre.y();
+		fgr::affine how;
+		float first, second;
+		if (command == "move" && input >> first >> second) {
+			how = fgr::affine(1.0f, 0.0f, 0.0f, 1.0f, first, second);
+		}
+		else if (command == "scale" && input >> first) {
+			if (!(input >> second))
+				second = first;
+			how = fgr::affine(first, 0.0f, 0.0f, second, cx - first * cx, cy - second * cy);
+		}
+		else if (command == "rotate" && input >> first) {
+			float turn = first / 180.0f * fgr::PI;
+			float cosine = cosf(turn), sine = sinf(turn);
+			how = fgr::affine(cosine, -sine, sine, cosine, cx - (cosine * cx - sine * cy), cy - (sine * cx + cosine * cy));
+		}
+		else {
+			send_message(command == "move" ? "Usage is :move <X> <Y>" : command == "scale"
+				? "Usage is :scale <Factor> <Y factor(optional)>" : "Usage is :rotate <Degrees>", uIncorrectUsage);
+			return uIncorrectUsage;
+		}
+		currentTab->transformSelection(how);
 		currentTab->makechange();
-		if (currentTab->subGraphicShape == currentTab->currentGraphic().end())
-			--currentTab->subGraphicShape;
+		return uSuccess;
 	}
 	//Force the mouse to warp within the window
 	if (command == "warp" || command == "warpcursor") {
@@ -235,7 +306,9 @@ uCode cli::digest(const std::string& token) {
 				send_message("No changes since last write");
 				return uSuccess;
 			}
+			std::string written = currentTab->filepath;
 			if (currentTab->save(command)) {
+				autosave::forget(written);
 				currentTab->unsavedChanges = false;
 				currentTab->updateWindowName();
 				send_message("'" + command + "' written successfully");
@@ -251,6 +324,7 @@ uCode cli::digest(const std::string& token) {
 			return uSuccess;
 		}
 		if (currentTab->save()) {
+			autosave::forget(currentTab->filepath);
 			currentTab->unsavedChanges = false;
 			currentTab->updateWindowName();
 			send_message("'" + currentTab->getFileName() + "' written successfully");
@@ -261,6 +335,40 @@ uCode cli::digest(const std::string& token) {
 			return uError;
 		}
 	}
+	//Write every tab with unsaved changes, all at once
+	if (command == "wa" || command == "wall") {
+		std::vector<tabContainerType::iterator> dirty;
+		for (tabContainerType::iterator itr = tabs.begin(); itr != tabs.end(); ++itr) {
+			if (itr->unsavedChanges && !itr->blankFile)
+				dirty.push_back(itr);
+		}
+		if (dirty.empty()) {
+			send_message("No changes since last write");
+			return uSuccess;
+		}
+		int written = 0;
+		int failed = 0;
+		acrossTabs(dirty, [](editor& copy) {
+			//Art that's put away is brought back into the copy only; the tab itself stays put away
+			return copy.wake() && copy.save(copy.filepath);
+		}, [&](tabContainerType::iterator tab, const editor&, bool worked) {
+			if (!worked) {
+				send_message("Error writing to '" + tab->getFileName() + '\'', uError);
+				++failed;
+				return;
+			}
+			autosave::forget(tab->filepath);
+			tab->unsavedChanges = false;
+			++written;
+		});
+		currentTab->updateWindowName();
+		if (failed) {
+			send_message(std::to_string(written) + " files written, " + std::to_string(failed) + " could not be", uError);
+			return uError;
+		}
+		send_message(std::to_string(written) + " files written successfully");
+		return uSuccess;
+	}
 	//Source
 	if (command == "source") {
 		//Ensure a filename was provided
@@ -289,6 +397,7 @@ uCode cli::digest(const std::string& token) {
 			//Try to load an existing file with the given name
 			if (currentTab->loadFile(command)) {
 				send_message("Editing file '" + command + '\'', uSuccess);
+				offerRecovery(command);
 				currentTab->updateWindowName();
 				return uSuccess;
 			}
@@ -315,6 +424,147 @@ uCode cli::digest(const std::string& token) {
 			return uWarning;
 		}
 	}
+	//Open a file in a new tab after this one
+	if (command == "tabe" || command == "tabedit") {
+		if (!(input >> command)) {
+			send_message("Usage is :tabedit <filename>", uIncorrectUsage);
+			return uIncorrectUsage;
+		}
+		editor opened;
+		//A tab that has the file open, unchanged, shares its art rather than reading it again
+		tabContainerType::iterator same = std::find_if(tabs.begin(), tabs.end(), [&](const editor& tab) {
+			return tab.filepath == command && tab.resident() && !tab.unsavedChanges && !tab.blankFile;
+		});
+		if (same != tabs.end())
+			opened.openShared(*same);
+		else if (!opened.openLater(command)) {
+			send_message("Unrecognized file extention - '." + getExtention(command) + '\'', uError);
+			return uError;
+		}
+		tabContainerType::iterator placed = tabs.insert(std::next(currentTab), std::move(opened));
+		if (switchTab(placed)) {
+			send_message("Editing file '" + command + "' in a new tab", uSuccess);
+			offerRecovery(command);
+			return uSuccess;
+		}
+		//Make a new file if there isn't one by that name
+		currentTab->newFile(currentTab->format);
+		currentTab->filepath = command;
+		currentTab->updateWindowName();
+		send_message("Editing new file '" + command + "' in a new tab", uSuccess);
+		return uSuccess;
+	}
+	//Run a command in every tab, from the first to the last, then come back to this one
+	if (command == "tabdo") {
+		std::string each;
+		std::getline(input, each);
+		each.erase(0, each.find_first_not_of(" :"));
+		std::stringstream words(each);
+		std::string verb;
+		if (!(words >> verb)) {
+			send_message("Usage is :tabdo <command>", uIncorrectUsage);
+			return uIncorrectUsage;
+		}
+		//The tabs are gone through as they were at the start, so none may be opened or closed along the way
+		if (verb == "q" || verb == "q!" || verb == "quit" || verb == "tabe" || verb == "tabedit" || verb == "tabdo") {
+			send_message("Can't open or close tabs with :tabdo", uError);
+			return uError;
+		}
+		std::vector<tabContainerType::iterator> every;
+		for (tabContainerType::iterator itr = tabs.begin(); itr != tabs.end(); ++itr)
+			every.push_back(itr);
+		tabContainerType::iterator viewing = currentTab;
+		int failed = 0;
+		for (std::size_t i = 0; i < every.size(); ++i) {
+			switchTab(every[i]);
+			uCode result = digest(each);
+			if (result != uSuccess)
+				++failed;
+		}
+		switchTab(viewing);
+		send_message("Ran ':" + each + "' in " + std::to_string(every.size()) + " tabs"
+			+ (failed ? " (" + std::to_string(failed) + " did not succeed)" : std::string()), failed ? uWarning : uSuccess);
+		return failed ? uWarning : uSuccess;
+	}
+	//Move to the next tab (going back around to the first after the last)
+	if (command == "tabn" || command == "tabnext") {
+		tabContainerType::iterator next = std::next(currentTab);
+		switchTab(next == tabs.end() ? tabs.begin() : next);
+		return uSuccess;
+	}
+	//Move to the previous tab (going back around to the last before the first)
+	if (command == "tabp" || command == "tabprevious") {
+		switchTab(std::prev(currentTab == tabs.begin() ? tabs.end() : currentTab));
+		return uSuccess;
+	}
+	//Limit how much memory the art of the tabs not being viewed may take up
+	if (command == "tabmemory" || command == "tabmem") {
+		float megabytes;
+		if (input >> megabytes && megabytes >= 0.0f) {
+			tabMemoryBudget = std::size_t(megabytes * 1024.0f * 1024.0f);
+			fitTabBudget();
+			send_message("Tabs not being viewed limited to " + std::to_string(megabytes) + " MB of art");
+			return uSuccess;
+		}
+		std::size_t used = 0;
+		int resident = 0;
+		for (tabContainerType::iterator itr = tabs.begin(); itr != tabs.end(); ++itr) {
+			if (itr == currentTab || !itr->resident())
+				continue;
+			used += itr->artBytes();
+			++resident;
+		}
+		send_message(std::to_string(resident) + " of " + std::to_string(tabs.size() - 1) + " other tabs in memory, using "
+			+ std::to_string(used / 1024) + " of " + std::to_string(tabMemoryBudget / 1024) + " KB", uSuccess);
+		return uSuccess;
+	}
+	//Bring back the unsaved changes to this tab's file left over from a session that ended early
+	if (command == "recover" || command == "recover!") {
+		std::string recovered = autosave::recoveryPath(currentTab->filepath);
+		if (input >> command) {
+			if (command != "discard") {
+				send_message("Usage is :recover[!] [discard]", uIncorrectUsage);
+				return uIncorrectUsage;
+			}
+			autosave::forget(currentTab->filepath);
+			send_message("Deleted '" + splitPath(recovered).second + '\'');
+			return uSuccess;
+		}
+		if (!autosave::recoverable(currentTab->filepath)) {
+			send_message("No unsaved changes to recover for '" + currentTab->getFileName() + '\'', uError);
+			return uError;
+		}
+		if (command != "recover!" && currentTab->unsavedChanges && !currentTab->blankFile) {
+			warnUnsaved();
+			return uWarning;
+		}
+		if (!currentTab->recover(recovered)) {
+			send_message("Error reading '" + splitPath(recovered).second + '\'', uError);
+			return uError;
+		}
+		currentTab->updateWindowName();
+		send_message("Recovered unsaved changes to '" + currentTab->getFileName() + "' (write to keep them)", uSuccess);
+		return uSuccess;
+	}
+	//Set how often copies of unsaved work are kept, in seconds (0 turns it off)
+	if (command == "autosave") {
+		int seconds;
+		if (input >> seconds && seconds >= 0) {
+			autosave::interval = seconds;
+			autosave::schedule();
+			if (seconds)
+				send_message("Unsaved work copied every " + std::to_string(seconds) + " seconds");
+			else
+				send_message("Autosave turned off");
+			return uSuccess;
+		}
+		unsigned long wrote;
+		unsigned long couldnt;
+		autosave::tally(wrote, couldnt);
+		send_message((autosave::interval ? "Autosave every " + std::to_string(autosave::interval) + " seconds; " : std::string("Autosave off; "))
+			+ std::to_string(wrote) + " copies written, " + std::to_string(couldnt) + " failed", couldnt ? uWarning : uSuccess);
+		return uSuccess;
+	}
 	//Reset all transformations
 	if (command == "home" || command == "h") {
 		currentTab->zoom = 0.1f;
@@ -324,10 +574,13 @@ uCode cli::digest(const std::string& token) {
 	}
 	//Transform view to fit full graphic
 	if (command == "fit") {
-		if (currentTab->currentGlyph().size()) {
-			fgr::segment fitSeg = currentTab->currentGlyph().bounds();
+		//The art is only looked at (through a const tab), so art shared with another tab stays shared
+		const editor& tab = *currentTab;
+		const fgr::glyph& art = tab.currentGlyph();
+		if (art.size()) {
+			fgr::segment fitSeg = art.bounds();
 			currentTab->zoom = 1.0f / (fmaxf(fitSeg.width(), fitSeg.height() / currentTab->aspectRatio()));
-			currentTab->pan = currentTab->currentGlyph().bounds().midpoint() * currentTab->zoom;
+			currentTab->pan = fitSeg.midpoint() * currentTab->zoom;
 			return uSuccess;
 		}
 		return uSuccess;
@@ -335,7 +588,7 @@ uCode cli::digest(const std::string& token) {
 	//Clone the current shape to the next layer
 	if (command == "cshapen" || command == "cshape") {
 		//Make another shape
-		currentTab->subGraphicShape = currentTab->currentGraphic().insert(currentTab->subGraphicShape, currentTab->currentShape());
+		currentTab->insertShape(currentTab->currentPlace().shape, currentTab->currentShape());
 		currentTab->makechange();
 		send_message("Cloned shape to next layer");
 		return uSuccess;
@@ -343,7 +596,7 @@ uCode cli::digest(const std::string& token) {
 	//Clone the current shape to the previous layer
 	if (command == "cshapep") {
 		//Make another shape
-		currentTab->subGraphicShape = currentTab->currentGraphic().insert(currentTab->subGraphicShape, currentTab->currentShape());
+		currentTab->insertShape(currentTab->currentPlace().shape, currentTab->currentShape());
 		currentTab->makechange();
 		--currentTab->subGraphicShape;
 		send_message("Cloned shape to previous layer");
@@ -368,8 +621,9 @@ uCode cli::digest(const std::string& token) {
 	}
 	//Toggle bezier status of the current glyph
 	if (command == "bez" || command == "bezier") {
+		fgr::shape before = currentTab->currentStyle();
 		currentTab->currentGlyph().bezier = !currentTab->currentGlyph().bezier;
-		currentTab->makechange();
+		currentTab->restyled(before);
 		send_message("Current glyph's bezier status set to " + std::to_string(currentTab->currentGlyph().bezier));
 		return uSuccess;
 	}
@@ -379,8 +633,9 @@ uCode cli::digest(const std::string& token) {
 		if (input >> command) {
 			int interpretation = (std::stoi(command) % 11);
 			//For now, interpret as plan integer
+			fgr::shape before = currentTab->currentStyle();
 			currentTab->currentGlyph().mode = static_cast<fgr::GLmode>(interpretation);
-			currentTab->makechange();
+			currentTab->restyled(before);
 			send_message("Glyph GL Mode set to " + std::string(currentTab->currentGlyph().glModeString()), uSuccess);
 			return uSuccess;
 		}
@@ -391,7 +646,7 @@ uCode cli::digest(const std::string& token) {
 	}
 	//Clear the canvas on the current layer
 	if (command == "clear") {
-		currentTab->currentGlyph().clear();
+		currentTab->clearGlyph();
 		currentTab->makechange();
 		return uSuccess;
 	}
@@ -409,24 +664,20 @@ uCode cli::digest(const std::string& token) {
 		}
 	}
 	if (command == "shapen") {
-		++currentTab->subGraphicShape;
-		if (currentTab->subGraphicShape == currentTab->currentGraphic().end()) {
-			currentTab->subGraphicShape = currentTab->currentGraphic().begin();
-			return uSuccess;
-		}
+		currentTab->nextShape();
+		return uSuccess;
 	}
 	if (command == "nshapen" || command == "nshape") {
-		currentTab->subGraphicShape = currentTab->currentGraphic().insert(++currentTab->subGraphicShape, fgr::shape());
+		currentTab->insertShape(currentTab->currentPlace().shape + 1, fgr::shape());
 		currentTab->makechange();
 		return uSuccess;
 	}
 	if (command == "shapep") {
-		if (currentTab->subGraphicShape != currentTab->currentGraphic().begin())
-			--currentTab->subGraphicShape;
+		currentTab->previousShape();
 		return uSuccess;
 	}
 	if (command == "nshapep") {
-		currentTab->subGraphicShape = currentTab->currentGraphic().insert(currentTab->subGraphicShape, fgr::shape());
+		currentTab->insertShape(currentTab->currentPlace().shape, fgr::shape());
 		currentTab->makechange();
 		return uSuccess;
 	}
@@ -455,14 +706,15 @@ uCode cli::digest(const std::string& token) {
 			float newR, newG, newB;
 			if (input >> newR && input >> newG && input >> newB) {
 				float newA;
+				fgr::shape before = currentTab->currentStyle();
 				if (input >> newA) {
 					currentTab->currentShape().color = fgr::fcolor(newR, newG, newB, newA);
-					currentTab->makechange();
+					currentTab->restyled(before);
 					return uSuccess;
 				}
 				else {
 					currentTab->currentShape().color = fgr::fcolor(newR, newG, newB);
-					currentTab->makechange();
+					currentTab->restyled(before);
 					return uSuccess;
 				}
 			}
@@ -487,8 +739,9 @@ uCode cli::digest(const std::string& token) {
 			//If more arguments are supplied,
 			float newW;
 			if (input >> newW) {
+				fgr::shape before = currentTab->currentStyle();
 				currentTab->currentShape().lineThickness = newW;
-				currentTab->makechange();
+				currentTab->restyled(before);
 				return uSuccess;
 			}
 			//Otherwise, tell them what's what
@@ -508,7 +761,7 @@ uCode cli::digest(const std::string& token) {
 	if (command == "v" || command == "vertex") {
 		float vX, vY;
 		if (input >> vX && input >> vY) {
-			currentTab->currentGlyph().push_back(fgr::point(vX, vY));
+			currentTab->insertVertex(currentTab->currentGlyph().size(), fgr::point(vX, vY));
 			currentTab->makechange();
 			send_message("Vertex added at " + currentTab->currentGlyph().back().label(), uSuccess);
 			return uSuccess;
@@ -518,10 +771,38 @@ uCode cli::digest(const std::string& token) {
 			return uIncorrectUsage;
 		}
 	}
-	//Experimental undo
-	if (command == "undo") {
-		send_message("We're not there yet.", uError);
-		return uError;
+	//Take back the last change
+	if (command == "u" || command == "undo") {
+		if (!currentTab->undo()) {
+			send_message("Already at oldest change", uWarning);
+			return uWarning;
+		}
+		send_message(std::to_string(currentTab->history.undoSteps()) + " more changes to undo");
+		return uSuccess;
+	}
+	//Make the last change taken back again
+	if (command == "redo") {
+		if (!currentTab->redo()) {
+			send_message("Already at newest change", uWarning);
+			return uWarning;
+		}
+		send_message(std::to_string(currentTab->history.redoSteps()) + " more changes to redo");
+		return uSuccess;
+	}
+	//Limit how much memory each tab's undo history may take up
+	if (command == "undolimit") {
+		float megabytes;
+		if (input >> megabytes && megabytes >= 0.0f) {
+			undoMemoryLimit = std::size_t(megabytes * 1024.0f * 1024.0f);
+			for (tabContainerType::iterator itr = tabs.begin(); itr != tabs.end(); ++itr)
+				itr->history.setLimit(undoMemoryLimit);
+			send_message("Undo history limited to " + std::to_string(megabytes) + " MB per tab");
+			return uSuccess;
+		}
+		send_message("Undo history uses " + std::to_string(currentTab->history.bytes() / 1024) + " of "
+			+ std::to_string(currentTab->history.memoryLimit() / 1024) + " KB ("
+			+ std::to_string(currentTab->history.undoSteps()) + " changes)", uSuccess);
+		return uSuccess;
 	}
 	//Change current shape point size
 	if ( command == "ps" || command == "pointsize") {
@@ -529,8 +810,9 @@ uCode cli::digest(const std::string& token) {
 			//If more arguments are supplied,
 			float newP;
 			if (input >> newP) {
+				fgr::shape before = currentTab->currentStyle();
 				currentTab->currentShape().pointSize = newP;
-				currentTab->makechange();
+				currentTab->restyled(before);
 				send_message("Set point size to " + std::to_string(currentTab->currentShape().pointSize));
 				return uSuccess;
 			}
@@ -581,12 +863,292 @@ uCode cli::digest(const std::string& token) {
 			return uIncorrectUsage;
 		}
 	}
+	//Choose how redraws are paced
+	if (command == "pacing") {
+		if (input >> command) {
+			if (command == "vsync") {
+				redraw::setPolicy(redraw::pVsync);
+				send_message("Frame pacing set to vsync");
+				return uSuccess;
+			}
+			if (command == "uncapped") {
+				redraw::setPolicy(redraw::pUncapped);
+				send_message("Frame pacing set to uncapped");
+				return uSuccess;
+			}
+			if (command == "cap" || command == "capped") {
+				int cap = 0;
+				input >> cap;
+				redraw::setPolicy(redraw::pCapped, cap);
+				send_message("Frame pacing capped at " + std::to_string(redraw::frameCap) + " fps");
+				return uSuccess;
+			}
+		}
+		else {
+			send_message("Frame pacing is " + redraw::pacingName(redraw::policy), uSuccess);
+			return uSuccess;
+		}
+		send_message("Usage is :pacing <vsync/cap/uncapped> <fps(if capped)>", uIncorrectUsage);
+		return uIncorrectUsage;
+	}
+	//Snap added and dragged vertices to the grid, to other vertices, or to edges
+	if (command == "snap") {
+		if (input >> command) {
+			if (command == "off") {
+				snap::toGrid = snap::toVertices = snap::toEdges = false;
+				send_message("Snapping turned off");
+				return uSuccess;
+			}
+			if (command == "grid") {
+				float size;
+				if (input >> size) {
+					if (size <= 0.0f) {
+						send_message("The grid has to be bigger than 0", uIncorrectUsage);
+						return uIncorrectUsage;
+					}
+					snap::gridSize = size;
+					snap::toGrid = true;
+				}
+				else
+					snap::toGrid = !snap::toGrid;
+				send_message(snap::toGrid ? "Snapping to a grid of " + std::to_string(snap::gridSize) : "Not snapping to the grid");
+				return uSuccess;
+			}
+			if (command == "vertex" || command == "vertices") {
+				snap::toVertices = !snap::toVertices;
+				send_message(snap::toVertices ? "Snapping to vertices" : "Not snapping to vertices");
+				return uSuccess;
+			}
+			if (command == "edge" || command == "edges") {
+				snap::toEdges = !snap::toEdges;
+				send_message(snap::toEdges ? "Snapping to edges" : "Not snapping to edges");
+				return uSuccess;
+			}
+			if (command == "reach") {
+				float pixels;
+				if (input >> pixels && pixels > 0.0f) {
+					snap::reach = pixels;
+					send_message("Snapping to vertices and edges within " + std::to_string(snap::reach) + " pixels");
+					return uSuccess;
+				}
+			}
+		}
+		else {
+			if (!snap::any()) {
+				send_message("Snapping is off", uSuccess);
+				return uSuccess;
+			}
+			std::string to;
+			if (snap::toVertices)
+				to += " vertices,";
+			if (snap::toEdges)
+				to += " edges,";
+			if (snap::toGrid)
+				to += " a grid of " + std::to_string(snap::gridSize) + ",";
+			to.pop_back();
+			send_message("Snapping to" + to + " (within " + std::to_string(snap::reach) + " pixels)", uSuccess);
+			return uSuccess;
+		}
+		send_message("Usage is :snap <grid/vertex/edge/off/reach> <grid size or pixels(optional)>", uIncorrectUsage);
+		return uIncorrectUsage;
+	}
+	//Draw frames on a thread of their own, or in the display callback
+	if (command == "renderthread") {
+		if (input >> command) {
+			if (command == "on") {
+				if (!renderthread::start()) {
+					send_message("Couldn't make a second OpenGL context for the render thread", uError);
+					return uError;
+				}
+				send_message("Drawing on the render thread");
+				return uSuccess;
+			}
+			if (command == "off") {
+				renderthread::stop();
+				send_message("Drawing on the main thread");
+				return uSuccess;
+			}
+		}
+		else {
+			send_message(std::string("The render thread is ") + (renderthread::active() ? "on" : "off"), uSuccess);
+			return uSuccess;
+		}
+		send_message("Usage is :renderthread <on/off>", uIncorrectUsage);
+		return uIncorrectUsage;
+	}
+	//Show or hide what each frame costs over the central editor
+	if (command == "perf") {
+		if (input >> command) {
+			if (command != "on" && command != "off") {
+				send_message("Usage is :perf <on/off(optional)>", uIncorrectUsage);
+				return uIncorrectUsage;
+			}
+			perf::show(command == "on");
+		}
+		else {
+			perf::show(!perf::shown);
+		}
+		redraw::request();
+		send_message(std::string("Performance overlay ") + (perf::shown ? "on" : "off"));
+		return uSuccess;
+	}
 	//Toggle experimental fractal mode
 	if (command == "fractog") {
 		currentTab->experimentalFractalMode = !currentTab->experimentalFractalMode;
 		send_message("Fractal mode set to " + std::to_string(currentTab->experimentalFractalMode));
 		return uSuccess;
 	}
+	//Bake the experimental fractal into an ordinary graphic file
+	if (command == "fractalbake" || command == "fbake") {
+		unsigned long maxVertices;
+		if (!(input >> maxVertices)) {
+			send_message("Usage is :fractalbake <max-vertices> <filename(optional)>", uIncorrectUsage);
+			return uIncorrectUsage;
+		}
+		const editor& tab = *currentTab;
+		if (tab.format != eGraphic || tab.currentGraphic().size() < 2) {
+			send_message("Fractal baking needs a graphic with at least two shapes", uError);
+			return uError;
+		}
+		//By default, write next to the current file
+		std::string target;
+		if (!(input >> target)) {
+			target = currentTab->filepath;
+			std::size_t dot = target.rfind('.');
+			if (dot != std::string::npos)
+				target.erase(dot);
+			target += "_baked.fgr";
+		}
+		if (interpretExtention(getExtention(target)) != eGraphic) {
+			send_message("Baked fractals must be written to a graphic (.fgr) file", uError);
+			return uError;
+		}
+		fgr::bakereport report;
+		fgr::graphic baked = fgr::bake(fgr::fractal(tab.currentGraphic().front(), tab.currentGraphic().back()), maxVertices, report);
+		if (!fgr::graphicToFile(baked, target)) {
+			send_message("Error writing to '" + target + '\'', uError);
+			return uError;
+		}
+		send_message("Baked " + std::to_string(report.copies) + " copies over " + std::to_string(report.levels)
+			+ " levels into '" + target + "' - " + std::to_string(report.vertices) + " vertices in "
+			+ std::to_string(report.shapes) + " shape(s), " + std::to_string(report.milliseconds) + " ms");
+		return uSuccess;
+	}
+	//Export the current art as an image
+	if (command == "export") {
+		std::string kind;
+		int width = 0, height = 0;
+		if (!(input >> kind >> width >> height) || (kind != "png" && kind != "gif" && kind != "frames") || width <= 0 || height <= 0) {
+			send_message("Usage is :export <png/gif/frames> <width> <height> <ticks per second(gif/frames only, optional)> <filename(optional)>", uIncorrectUsage);
+			return uIncorrectUsage;
+		}
+		//Lines and points keep the thickness they have on screen, relative to the image's height
+		float pixelScale = currentTab->centralPane().height > 0 ? float(height) / currentTab->centralPane().height : 1.0f;
+		//Whole animations, as an animated GIF or a PNG per tick
+		if (kind != "png") {
+			if (currentTab->format != eAnimation) {
+				send_message("Only animations can be exported as " + kind, uError);
+				return uError;
+			}
+			float ticksPerSecond = 60.0f;
+			std::string target;
+			if (input >> target) {
+				char* rest = NULL;
+				float rate = strtof(target.c_str(), &rest);
+				if (rest && !*rest) {
+					if (!(rate > 0.0f)) {
+						send_message("Ticks per second must be positive", uIncorrectUsage);
+						return uIncorrectUsage;
+					}
+					ticksPerSecond = rate;
+					target.clear();
+					input >> target;
+				}
+			}
+			//By default, write next to the current file
+			if (target.empty()) {
+				target = currentTab->filepath;
+				std::size_t dot = target.rfind('.');
+				if (dot != std::string::npos)
+					target.erase(dot);
+				if (kind == "gif")
+					target += ".gif";
+			}
+			fgr::animreport report;
+			if (!fgr::exportAnimation(*currentTab->animArt, kind == "frames" ? target : std::string(),
+				kind == "gif" ? target : std::string(), width, height, ticksPerSecond, pixelScale, report)) {
+				send_message("Error writing to '" + target + '\'', uError);
+				return uError;
+			}
+			send_message("Exported " + std::to_string(report.frames) + " frames to '" + (kind == "frames" ? fgr::sequenceName(target, 0) : target)
+				+ "'" + (kind == "frames" ? " onwards (" + std::to_string(report.images) + " images)" : std::string()) + " in "
+				+ std::to_string(report.milliseconds) + " ms");
+			return uSuccess;
+		}
+		const editor& tab = *currentTab;
+		fgr::graphic art;
+		switch (tab.format) {
+		case eGlyph:
+			art = fgr::graphic(fgr::shape(tab.currentGlyph()));
+			break;
+		case eShape:
+			art = fgr::graphic(tab.currentShape());
+			break;
+		case eGraphic:
+		case eAnimation:
+			art = tab.currentGraphic();
+			break;
+		default:
+			send_message("This kind of file can't be exported yet", uError);
+			return uError;
+		}
+		//By default, write next to the current file
+		std::string target;
+		if (!(input >> target)) {
+			target = currentTab->filepath;
+			std::size_t dot = target.rfind('.');
+			if (dot != std::string::npos)
+				target.erase(dot);
+			if (currentTab->format == eAnimation)
+				target += "_frame" + std::to_string(currentTab->animArt->currentframe - currentTab->animArt->begin());
+			target += ".png";
+		}
+		fgr::rasterreport report;
+		if (!fgr::exportPNG(art, target, width, height, pixelScale, report)) {
+			send_message("Error writing to '" + target + '\'', uError);
+			return uError;
+		}
+		send_message("Exported '" + target + "' (" + std::to_string(width) + "x" + std::to_string(height) + ") in "
+			+ std::to_string(report.milliseconds) + " ms - " + std::to_string(report.megapixelsPerSecond(width, height))
+			+ " megapixels/s");
+		return uSuccess;
+	}
+	//Choose how the experimental fractal is drawn, and optionally the chaos game point budget
+	if (command == "fracmode" || command == "fractalmode") {
+		if (input >> command) {
+			if (command == "recursive" || command == "r") {
+				currentTab->experimentalFractalChaos = false;
+				send_message("Fractal rendering set to recursive");
+				return uSuccess;
+			}
+			if (command == "chaos" || command == "c") {
+				unsigned long budget;
+				if (input >> budget) {
+					if (!budget) {
+						send_message("Point budget must be at least 1", uIncorrectUsage);
+						return uIncorrectUsage;
+					}
+					currentTab->experimentalFractalPoints = budget;
+				}
+				currentTab->experimentalFractalChaos = true;
+				send_message("Fractal rendering set to chaos game with "
+					+ std::to_string(currentTab->experimentalFractalPoints) + " points");
+				return uSuccess;
+			}
+		}
+		send_message("Usage is :fracmode <recursive/chaos> <point-budget(optional)>", uIncorrectUsage);
+		return uIncorrectUsage;
+	}
 	//Err - invalid command
 	send_message("Invalid command - " + command, uInvalid);
 	return uInvalid;
@@ -595,9 +1157,13 @@ uCode cli::digest(const std::string& token) {
 
 //Rendering instructions for the console
 void cli::draw() {
-	setcolor(currentTab -> commandLineColor);
-	setViewport(currentTab -> commandLinePane());
-	std::string field = cli::getfield();
+	drawField(*currentTab, cli::getfield());
+}
+
+//Draw what's been typed into the console, in the command line pane of some tab
+void cli::drawField(const editor& tab, const std::string& field) {
+	setcolor(tab.commandLineColor);
+	setViewport(tab.commandLinePane());
 	for (int i = 0; i < field.size(); ++i)
 		glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, field[i]);
 }
@@ -14,6 +14,14 @@ int mouseMemory [2];
 //The history of keypresses for the user
 std::string chordMemory;
 
+//The latest mouse motion (with a button down) that hasn't been processed yet. Motion is
+//coalesced, so however many motion events arrive between two frames, only the last is handled.
+bool motionPending = false;
+int pendingMotion[2];
+
+//Handle the coalesced mouse motion now, if there is any
+void flushPendingMotion();
+
 
 //Non-mapping-based key functionalities
 void keyProcessNoMap(unsigned char key, int x, int y) {
@@ -39,7 +47,7 @@ void keyProcessNoMap(unsigned char key, int x, int y) {
 		else {
 			cli::input.push_back(key);
 		}
-		renderScene();
+		redraw::request();
 		return;
 	}
 	if (key == ':') {
@@ -49,7 +57,7 @@ void keyProcessNoMap(unsigned char key, int x, int y) {
 	}
 	if (key == '0')
 		cli::digest("fit");
-	renderScene();
+	redraw::request();
 	return;
 
 }
@@ -67,6 +75,8 @@ char getSpecialKey(const std::string& nickname) {
 
 //GLUT event handler for regular key-presses
 void processNormalKeys(unsigned char key, int x, int y) {
+	perf::timer timing(perf::pInput);
+	flushPendingMotion();
 	if (cli::listening) {
 		keyProcessNoMap(key, x, y);
 		return;
@@ -109,17 +119,19 @@ void releaseNormalKeys(unsigned char key, int x, int y) {
 
 //GLUT event handler for special key-presses
 void ProcessSpecialKeys(int key, int x, int y) {
+	perf::timer timing(perf::pInput);
+	flushPendingMotion();
 	if (key == GLUT_KEY_UP) {
 		if (cli::listening && cli::history.size()) {
 			cli::input = cli::history.back();
-			renderScene();
+			redraw::request();
 			return;
 		}
 	}
 	if (key == GLUT_KEY_DOWN) {
 		if (cli::listening && cli::history.size() && cli::input == cli::history.back()) {
 			cli::input = ":";
-			renderScene();
+			redraw::request();
 			return;
 		}
 	}
@@ -143,24 +155,32 @@ void leftClick(int x, int y) {
 			//Action depends on tool
 			switch (currentTab->currentTool) {
 				case tAppend:
-					currentTab->pushBackPoint(x, y);
-					renderScene();
+					currentTab->pushBackPoint(x, y, true);
+					redraw::request();
 					return;
-				case tInsert: {
+				case tInsert:
 					//Holding the left-mouse button shows where the point would be put
-					if (currentTab->currentGlyph().size() < 2) return;
-					fgr::glyph::iterator rid = currentTab->insertPoint(x, y);
-					renderScene();
-					currentTab->currentGlyph().erase(rid);
+					currentTab->previewInsertPoint(x, y);
+					redraw::request();
 					return;
-				}
 				case tMovePoint:
 					currentTab->movePoint(x, y);
-					renderScene();
+					redraw::request();
 					return;
 				case tDeletePoint:
 					currentTab->deletePoint(x, y);
-					renderScene();
+					redraw::request();
+					return;
+				case tSelectPoints:
+					currentTab->beginSelection(x, y, glutGetModifiers());
+					redraw::request();
+					return;
+				case tSelectionManip:
+					currentTab->beginManipulation(x, y, glutGetModifiers());
+					return;
+				case tSelectShapes:
+					currentTab->pickShape(x, y, glutGetModifiers());
+					redraw::request();
 					return;
 			}
 		case rAnimationFrames:
@@ -183,6 +203,7 @@ void leftClick(int x, int y) {
 			return;
 		case rShapes:
 			currentTab->processShapesClick(x, y);
+			redraw::request();
 			return;
 		case rTabHeader:
 			cli::send_message("Tab Header");
@@ -198,14 +219,23 @@ void leftClick(int x, int y) {
 			break;
 		}
 	case GLUT_UP:
+		//Whatever was done while the button was down is undone as one step
+		currentTab->history.seal();
+		//A selection being dragged out is finished wherever the button comes up
+		if (currentTab->selectionOutline.size()) {
+			currentTab->finishSelection();
+			redraw::request();
+		}
+		//The hovering vertex only sticks if the button comes up over the canvas
+		currentTab->cancelInsertPreview();
 		switch (currentTab->reigonID(x, y)) {
 		case rCentral:
 			switch (currentTab->currentTool) {
 			case tInsert:
 				//Finally place the hovering vertex once and for all
+				redraw::request();
 				if (currentTab->currentGlyph().size() < 2) return;
 				currentTab->insertPoint(x, y);
-				renderScene();
 				return;
 			case tMovePoint:
 				//Put down the point that is being held
@@ -264,8 +294,10 @@ void rightClick(int x, int y) {
 		switch (currentTab->currentTool) {
 		case tAppend:
 			if (currentTab->currentGlyph().size()) {
-				currentTab->currentGlyph().back() = currentTab->mapPixel(x, y);
-				renderScene();
+				std::size_t last = currentTab->currentGlyph().size() - 1;
+				currentTab->moveVertex(last, currentTab->snappedPixel(x, y, last));
+				currentTab->makechange();
+				redraw::request();
 			}
 			break;
 		}
@@ -298,6 +330,8 @@ void rightClick(int x, int y) {
 
 //GLUT event handler for a mouse click
 void MouseClick(int button, int state, int x, int y) {
+	perf::timer timing(perf::pInput);
+	flushPendingMotion();
 	int mod = glutGetModifiers();
 	float scrollspeed = 0.05f;
 	//Toggling - this always happens
@@ -324,7 +358,11 @@ void MouseClick(int button, int state, int x, int y) {
 					currentTab->pan.xinc(scrollspeed);
 				else
 					currentTab->pan.yinc(scrollspeed);
-				renderScene();
+				redraw::request();
+				break;
+			case rShapes:
+				currentTab->scrollShapes(-currentTab->shapeRowStep() / 2);
+				redraw::request();
 				break;
 			}
 		}
@@ -339,7 +377,11 @@ void MouseClick(int button, int state, int x, int y) {
 					currentTab->pan.xdec(scrollspeed);
 				else
 					currentTab->pan.ydec(scrollspeed);
-				renderScene();
+				redraw::request();
+				break;
+			case rShapes:
+				currentTab->scrollShapes(currentTab->shapeRowStep() / 2);
+				redraw::request();
 				break;
 			}
 		}
@@ -350,8 +392,8 @@ void MouseClick(int button, int state, int x, int y) {
 	return;
 }
 
-//GLUT event handler for mouse motion with a mouse-button down
-void ActiveMouseMove(int x, int y) {
+//Process mouse motion with a mouse-button down (called at most once per frame)
+void processActiveMotion(int x, int y) {
 	//Behaviour depends on what pane the motion is in
 	switch (currentTab->reigonID(x, y)) {
 	case rCentral:
@@ -359,7 +401,6 @@ void ActiveMouseMove(int x, int y) {
 		if (!mouseStates[GLUT_MIDDLE_BUTTON]) {
 			//Pan an amount equal to the mouse motion
 			currentTab->pan -= (currentTab->mapPixel(x, y) - currentTab->mapPixel(mouseMemory[0], mouseMemory[1])) * currentTab->zoom;
-			renderScene();
 		}
 		//Behavior depends on tool
 		switch (currentTab->currentTool) {
@@ -368,8 +409,8 @@ void ActiveMouseMove(int x, int y) {
 			if (!(mouseStates[GLUT_RIGHT_BUTTON] && mouseStates[GLUT_LEFT_BUTTON])) {
 				//If there is a point at all,
 				if (currentTab->currentGlyph().size()) {
-					currentTab->currentGlyph().back() = currentTab->mapPixel(x, y);
-					renderScene();
+					std::size_t last = currentTab->currentGlyph().size() - 1;
+					currentTab->moveVertex(last, currentTab->snappedPixel(x, y, last));
 				}
 			}
 			break;
@@ -378,23 +419,26 @@ void ActiveMouseMove(int x, int y) {
 			if (!mouseStates[GLUT_LEFT_BUTTON] && (fgr::point(x, y) - fgr::point(mouseMemory[0],
 				mouseMemory[1])).magnitude() > currentTab->brushTolerance) {
 				currentTab->pushBackPoint(x, y);
-				renderScene();
 			}
 			break;
-		case tInsert: {
+		case tInsert:
 			//Holding the left-mouse button shows where the point would be put
-			if (currentTab->currentGlyph().size() < 2) return;
-			fgr::glyph::iterator rid = currentTab->insertPoint(x, y);
-			renderScene();
-			currentTab->currentGlyph().erase(rid);
+			if (!mouseStates[GLUT_LEFT_BUTTON])
+				currentTab->previewInsertPoint(x, y);
 			break;
-		}
 		case tMovePoint:
 			//Move the selected vertex around
-			if (currentTab->in_hand_vertex) {
-				*(currentTab->in_hand_vertex) = currentTab->mapPixel(x, y);
-				renderScene();
-			}
+			currentTab->dragHeldVertex(x, y);
+			break;
+		case tSelectPoints:
+			//Drag out the rectangle or lasso
+			if (!mouseStates[GLUT_LEFT_BUTTON])
+				currentTab->extendSelection(x, y);
+			break;
+		case tSelectionManip:
+			//Move, scale or rotate every selected vertex
+			if (!mouseStates[GLUT_LEFT_BUTTON])
+				currentTab->dragManipulation(x, y);
 			break;
 		}
 		break;
@@ -426,8 +470,28 @@ void ActiveMouseMove(int x, int y) {
 	return;
 }
 
+//GLUT event handler for mouse motion with a mouse-button down; the work is deferred to the next frame
+void ActiveMouseMove(int x, int y) {
+	perf::timer timing(perf::pInput);
+	pendingMotion[0] = x; pendingMotion[1] = y;
+	motionPending = true;
+	redraw::request();
+	return;
+}
+
+//Handle the coalesced mouse motion now, if there is any
+void flushPendingMotion() {
+	if (!motionPending)
+		return;
+	motionPending = false;
+	processActiveMotion(pendingMotion[0], pendingMotion[1]);
+	return;
+}
+
 //GLUT event handler for mouse motion with no mouse-button down
 void PassiveMouseMove(int x, int y) {
+	perf::timer timing(perf::pInput);
+	flushPendingMotion();
 
 	//Update mouse memory
 	mouseMemory[0] = x; mouseMemory[1] = y;
@@ -4,9 +4,22 @@
 #define __editor_h__
 
 #include "fgrutils.h"
+#include "thumbnails.h"
+#include "history.h"
+#include "artref.h"
+#include "selection.h"
+#include "picking.h"
+#include "snapping.h"
+#include "perf.h"
+#include "fgrparallel.h"
 
 #include <string> 
+#include <cstdio>
+#include <memory>
 #include <utility>
+#include <array>
+#include <vector>
+#include <algorithm>
 
 //Forward declare
 class editor;
@@ -155,6 +168,96 @@ viewport superWindowPane() {
 enum reigonNum { rInconclusive, rCommandLine, rFileTree, rTabHeader, rAnimationFrames, rLayers, 
 	rShapes, rShapeProperties, rGlyphGLMode, rTools, rCentral };
 
+//Everything an editor's layout depends on: the window size, zen mode, and each pane's visibility and size
+typedef std::array<GLint, 21> layoutkey;
+
+//Every pane of an editor's layout, worked out all at once
+struct panelayout {
+	viewport superWindow;
+	viewport commandLine;
+	viewport fileTree;
+	viewport tabHeader;
+	viewport animationFrames;
+	viewport layers;
+	viewport shapes;
+	viewport shapeProperties;
+	viewport shapeColor;
+	viewport shapeSpecifications;
+	viewport glyphGLMode;
+	viewport tools;
+	viewport central;
+};
+
+/* Which reigon every pixel of a layout is in. Every pane edge cuts the window into columns and
+ * rows, and a pixel is either strictly between two edges or right on one; the reigon is worked
+ * out once for each of those cells, so looking a pixel up is two binary searches. */
+class reigonmap {
+public:
+	//Work out the reigon of every cell of a layout
+	void build(const panelayout& panes) {
+		const viewport* order[] = { &panes.central, &panes.animationFrames, &panes.commandLine, &panes.fileTree,
+			&panes.glyphGLMode, &panes.layers, &panes.shapeProperties, &panes.shapes, &panes.tabHeader, &panes.tools };
+		const reigonNum names[] = { rCentral, rAnimationFrames, rCommandLine, rFileTree,
+			rGlyphGLMode, rLayers, rShapeProperties, rShapes, rTabHeader, rTools };
+		const int count = sizeof(names) / sizeof(names[0]);
+		xs.clear();
+		ys.clear();
+		for (int i = 0; i < count; ++i) {
+			xs.push_back(order[i]->left());
+			xs.push_back(order[i]->right());
+			ys.push_back(order[i]->bottom());
+			ys.push_back(order[i]->top());
+		}
+		std::sort(xs.begin(), xs.end());
+		xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+		std::sort(ys.begin(), ys.end());
+		ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+		std::size_t columns = 2 * xs.size() + 1, rows = 2 * ys.size() + 1;
+		cells.assign(columns * rows, rInconclusive);
+		for (std::size_t row = 0; row < rows; ++row) {
+			GLint y = sample(ys, row);
+			for (std::size_t column = 0; column < columns; ++column) {
+				GLint x = sample(xs, column);
+				for (int i = 0; i < count; ++i) {
+					if (order[i]->contains(x, y)) {
+						cells[row * columns + column] = names[i];
+						break;
+					}
+				}
+			}
+		}
+	}
+	//The reigon a pixel is in (with y counted up from the bottom of the window)
+	reigonNum at(int x, int y) const {
+		if (cells.empty())
+			return rInconclusive;
+		return cells[cell(ys, y) * (2 * xs.size() + 1) + cell(xs, x)];
+	}
+
+private:
+	//The pane edges, from left to right and from bottom to top
+	std::vector<GLint> xs;
+	std::vector<GLint> ys;
+	//The reigon of each cell, row by row from the bottom
+	std::vector<reigonNum> cells;
+
+	//Which cell a coordinate falls in: odd cells are right on an edge, even ones between two
+	static std::size_t cell(const std::vector<GLint>& edges, GLint at) {
+		std::size_t below = std::lower_bound(edges.begin(), edges.end(), at) - edges.begin();
+		if (below < edges.size() && edges[below] == at)
+			return 2 * below + 1;
+		return 2 * below;
+	}
+	//A coordinate inside some cell (any will do, since no edge crosses a cell)
+	static GLint sample(const std::vector<GLint>& edges, std::size_t which) {
+		if (which % 2)
+			return edges[which / 2];
+		if (which == 0)
+			return edges.front() - 1;
+		return edges[which / 2 - 1] + 1;
+	}
+};
+
 //Enumerate tools
 enum toolNum { 
 //Glyph or higher
@@ -211,15 +314,15 @@ public:
 	editortype format;
 	// Absolute file path to the file this editor is concerned with
 	std::string filepath;
-	// Pointers to the art being worked on.
-	//Pointer to the glyph this editor has open
-	fgr::glyph* glyphArt;
-	//Pointer to the shape this editor has open
-	fgr::shape* shapeArt;
-	//Pointer to the graphic this editor has open
-	fgr::graphic* graphicArt;
-	//Pointer to the animation this editor has open
-	fgr::animation* animArt;
+	// Handles to the art being worked on (shared with other editors until one of them changes it).
+	//The glyph this editor has open
+	artref<fgr::glyph> glyphArt;
+	//The shape this editor has open
+	artref<fgr::shape> shapeArt;
+	//The graphic this editor has open
+	artref<fgr::graphic> graphicArt;
+	//The animation this editor has open
+	artref<fgr::animation> animArt;
 	//Whether or not there are unsaved changes
 	bool unsavedChanges;
 	//True iff this is a blank graphic nobody is going to miss.
@@ -232,6 +335,9 @@ public:
 	toolNum currentTool;
 	//If there is a singular vertex inder the cursor, point to it with this
 	fgr::point* in_hand_vertex = NULL;
+	//While the insert tool is held down, the vertex it is previewing (not yet a real change)
+	bool insertPreviewActive = false;
+	fgr::glyph::iterator insertPreviewVertex;
 	//If we're editing a graphic, this points to the shape in it we are currently at.
 	fgr::graphicContainer::iterator subGraphicShape;
 	// Settings as to whether different editor panes are open, and their sizes when open
@@ -259,6 +365,8 @@ public:
 		bool showShapes;
 		GLint shapesWidth;
 		fgr::fcolor shapesColor;
+		//How far the shape list has been scrolled down, in pixels
+		int shapesScroll = 0;
 	//SHAPE PROPERTIES (BOTTOM)
 		bool showShapeProperties;
 		GLint shapePropertiesHeight;
@@ -273,10 +381,10 @@ public:
 		bool showTools;
 		GLint toolsWidth;
 		fgr::fcolor toolsColor;
-	//History (think of this editor like a node)
-	//Heap pointer to the previous state
-	editor* prevstate = NULL;
-	editor* nextstate = NULL;
+	//Every change that can be undone or redone
+	edithistory history;
+	//Which vertex of the current glyph in_hand_vertex is
+	std::size_t heldIndex = 0;
 	//Some other minor variables and/or prefs
 	int margin = 5;
 	int spacing = 8;
@@ -286,6 +394,13 @@ public:
 	//Experimental
 	bool experimentalFractalMode = false;
 	int experimentalFractalIterations = 10;
+	//Draw the experimental fractal with the chaos game rather than by recursion
+	bool experimentalFractalChaos = false;
+	//How many points the chaos game plots whenever it regenerates
+	unsigned long experimentalFractalPoints = 2000000;
+	//The last chaos game cloud, and a fingerprint of the fractal/depth/budget that made it
+	mutable fgr::pointcloud fractalCloud;
+	mutable std::size_t fractalCloudKey = 0;
 
 	//Trying to get this feature working
 	fgr::menu eee[4] = { fgr::menu(), fgr::menu(), fgr::menu(), fgr::menu() };
@@ -296,54 +411,22 @@ public:
 
 	fgr::menu toolsMenu = fgr::menu(fgr::graphic(), fgr::point(2, 2), fgr::point(1, 1), NUMS, &butCallBack);
 
-	//Recursively destroy the future
-	void destroyFuture() {
-		if (nextstate) {
-			nextstate->prevstate = NULL;
-			delete nextstate;
-		}
-		return;
-	}
-
-	//Recursively destroy the past
-	void destroyPast() {
-		if (prevstate) {
-			prevstate->nextstate = NULL;
-			delete prevstate;
-		}
-	}
-
-	//Call this every time the user makes a change
+	//Call this every time the user finishes a change (a click, a command), so the next one is undone separately
 	void makechange() {
-		return;
 		unsavedChanges = true;
-		editor* temp = prevstate;
-		prevstate = new editor(*this);
-		prevstate->prevstate = temp;
-		if (prevstate->prevstate)
-			prevstate->prevstate->nextstate = prevstate;
-		prevstate->nextstate = this;
-		//This has safeguards for if there is no future
-		destroyFuture();
+		++revision;
+		history.seal();
 		return;
 	}
 
 	// CONSTRUCTORS
 	//Default constructor
 	editor() {
-		glyphArt = NULL;
-		shapeArt = NULL;
-		graphicArt = NULL;
-		animArt = NULL;
 		unsavedChanges = true;
 		defaultSettings();
 	}
 	//Filepath constructor
 	editor(const std::string& filepath_) {
-		glyphArt =		NULL;
-		shapeArt =		NULL;
-		graphicArt =	NULL;
-		animArt =		NULL;
 		defaultSettings();
 		filepath = filepath_;
 		unsavedChanges = false;
@@ -352,40 +435,62 @@ public:
 	}
 	//Editor-type empty graphic constructor
 	editor(editortype format_) {
-		glyphArt =		NULL;
-		shapeArt =		NULL;
-		graphicArt =	NULL;
-		animArt =		NULL;
 		defaultSettings();
 		configureLayout(format_);
 		newFile(format_);
 	}
-	//Copy constructor
+	//Copy constructor; the art is shared, not copied, until either editor changes it
 	editor(const editor& other) {
-		//Everything except these pointers can be copied by value directly
 		format = other.format;
 		filepath = other.filepath;
 		unsavedChanges = other.unsavedChanges;
-		glyphArt =		NULL;
-		shapeArt =		NULL;
-		graphicArt =	NULL;
-		animArt =		NULL;
-		if (other.glyphArt)
-			glyphArt = new fgr::glyph(*other.glyphArt);
-		if (other.shapeArt)
-			shapeArt = new fgr::shape(*other.shapeArt);
-		if (other.graphicArt) {
-			graphicArt = new fgr::graphic(*other.graphicArt);
-			subGraphicShape = graphicArt->begin();
-		}
-		if (other.animArt) {
-			animArt = new fgr::animation(*other.animArt);
-			subGraphicShape = animArt->front().begin();
-		}
+		glyphArt = other.glyphArt;
+		shapeArt = other.shapeArt;
+		graphicArt = other.graphicArt;
+		animArt = other.animArt;
+		if (graphicArt)
+			subGraphicShape = graphicArt.get()->begin();
+		if (animArt)
+			subGraphicShape = animArt.get()->front().begin();
+		//Art that's put away is shared too
+		awake = other.awake;
+		spill = other.spill;
+		sleepingPlace = other.sleepingPlace;
 		//  LATER THIS HAS TO BE EXPANDED.
 		defaultSettings();
 		configureLayout(format);
 	}
+	//Move constructor; takes the art, the history and the view of an editor that's going away
+	editor(editor&& other) : history(std::move(other.history)) {
+		format = other.format;
+		filepath = std::move(other.filepath);
+		unsavedChanges = other.unsavedChanges;
+		blankFile = other.blankFile;
+		//Iterators into the art stay good when the art itself is only handed over
+		subGraphicShape = other.subGraphicShape;
+		insertPreviewVertex = other.insertPreviewVertex;
+		insertPreviewActive = other.insertPreviewActive;
+		in_hand_vertex = other.in_hand_vertex;
+		heldIndex = other.heldIndex;
+		glyphArt = std::move(other.glyphArt);
+		shapeArt = std::move(other.shapeArt);
+		graphicArt = std::move(other.graphicArt);
+		animArt = std::move(other.animArt);
+		awake = other.awake;
+		spill = std::move(other.spill);
+		sleepingPlace = other.sleepingPlace;
+		lastViewed = other.lastViewed;
+		//The art is handed over, so the selected vertices are still where they were found
+		selected = std::move(other.selected);
+		selectedPoints = std::move(other.selectedPoints);
+		selectedPointsArt = other.selectedPointsArt;
+		other.insertPreviewActive = false;
+		other.in_hand_vertex = NULL;
+		copyView(other);
+	}
+	//Make this editor show exactly what another one does: the same art (shared, not copied), and
+	//the same view, tool, layout and colors. The history isn't copied, so this is for drawing, not editing.
+	void mirror(const editor& other);
 
 	// FILE/INITIALIZATION METHODS
 	void newFile(editortype filetype);
@@ -395,6 +500,12 @@ public:
 	bool save();
 	//Save the current artwork to the specified file path
 	bool save(const std::string& path);
+	//Write the art to a file without making it this editor's file (for copies such as recovery files)
+	bool saveCopy(const std::string& path) const;
+	//Replace the art with art of the same format read from another file (such as a recovery file),
+	//as an unsaved change to this editor's file. The history is forgotten. Returns false if the file
+	//couldn't be opened; if it couldn't be read, the art is left empty.
+	bool recover(const std::string& path);
 	//Be careful - this function does not save any progress first
 	void deleteAllArt();
 	//Configure the layout of the editor to a particular editor type
@@ -412,184 +523,304 @@ public:
 	//Convert this editor's contents into another format
 	void convertFile(editortype newFormat);
 
+	// RESIDENCY
+	//Open a file without reading it yet; it's read the first time the tab is woken.
+	//Returns false if the extention is not recognized.
+	bool openLater(const std::string& path);
+	//Open the file another tab has open, sharing its art instead of reading it again. The other
+	//tab's art has to be in memory and the same as its file.
+	void openShared(const editor& other);
+	//True while this tab's art is in memory (see sleep() and wake())
+	bool resident() const { return awake; }
+	//Put this tab's art away to save memory. Art that's the same as its file is just let go of
+	//(it's read from the file again), and any other art is written to a temporary file.
+	//The history, view and layout stay. Returns false if the art couldn't be put away.
+	bool sleep();
+	//Bring back art that was put away, or read a file opened with openLater(). Returns false if
+	//it couldn't be read; the tab is left with empty art then, like opening a file that isn't there.
+	bool wake();
+	//Roughly how much memory this tab's art takes up, in bytes (nothing while it's put away)
+	std::size_t artBytes() const;
+	//When this tab was last viewed (a count of tab switches), so the tabs viewed longest ago are put away first
+	unsigned long lastViewed = 0;
+	//Counts changes to the art, so something holding a copy can tell whether it's out of date
+	unsigned long revision = 0;
+	//The revision last copied for autosaving (see autosave.h)
+	unsigned long autosavedRevision = 0;
+
 	// LAYOUT INFORMATION ACCESSORS
+	//Every pane, worked out again only when the window size, zen mode or a pane's size or visibility changes
+	const panelayout& layout() const;
 	//Bottom-side command line interface
-	viewport commandLinePane() const {
-		return viewport(superWindowPane().left(), superWindowPane().bottom(), superWindowPane().right(), commandLineHeight, showCommandLine, false);
-	}
+	viewport commandLinePane() const { return layout().commandLine; }
 	//Right-hand side file-tree display
-	viewport fileTreePane() const {
-		return viewport(superWindowPane().right() - fileTreeWidth * (!!showFileTree && !zen), commandLinePane().top(), fileTreeWidth, superWindowPane().top() - commandLinePane().top(), showFileTree && !zen, true);
-	}
+	viewport fileTreePane() const { return layout().fileTree; }
 	//Top-side editor open tabs display
-	viewport tabHeaderPane() const {
-		return viewport(superWindowPane().left(), superWindowPane().top() - tabHeaderHeight * !!(showTabHeader && !zen), fileTreePane().left(), tabHeaderHeight, showTabHeader && !zen, false);
-	}
+	viewport tabHeaderPane() const { return layout().tabHeader; }
 	//Left-hand side animation frames display
-	viewport animationFramesPane() const {
-		return viewport(superWindowPane().left(), commandLinePane().top(), animationFramesWidth * !!(showAnimationFrames && !zen), tabHeaderPane().bottom() - commandLinePane().top(), showAnimationFrames && !zen, true);
-	}
+	viewport animationFramesPane() const { return layout().animationFrames; }
 	//Left-hand side layers display
-	viewport layersPane() const {
-		return viewport(animationFramesPane().right(), commandLinePane().top(), layersWidth * !!(showLayers && !zen), animationFramesPane().top() - commandLinePane().top(), showLayers && !zen, true);
-	}
+	viewport layersPane() const { return layout().layers; }
 	//Left-hand side shapes display
-	viewport shapesPane() const {
-		return viewport(layersPane().right(), commandLinePane().top(), shapesWidth * !!(showShapes && !zen), animationFramesPane().top() - commandLinePane().top(), showShapes && !zen, true);
-	}
+	viewport shapesPane() const { return layout().shapes; }
 	//Bottom-side shape-properties display; contains two other panes
-	viewport shapePropertiesPane() const {
-		return viewport(shapesPane().right(), commandLinePane().top(), fileTreePane().left() - shapesPane().right(), shapePropertiesHeight * !!( showShapeProperties && !zen), showShapeProperties && !zen, false);
-	}
+	viewport shapePropertiesPane() const { return layout().shapeProperties; }
 	//Part of the shape-properties display: line thickness and point size
-	viewport shapeSpecificationsPane() const {
-		return viewport(shapeColorPane().right(), commandLinePane().top(), shapePropertiesPane().width - shapeColorPane().width, shapePropertiesPane().height, shapePropertiesPane().show, false);
-	}
+	viewport shapeSpecificationsPane() const { return layout().shapeSpecifications; }
 	//Part of the shape-properties display: color of the current shape
-	viewport shapeColorPane() const {
-		return viewport(shapePropertiesPane().left(), commandLinePane().top(), shapePropertiesPane().width / 2, shapePropertiesPane().height, shapePropertiesPane().show, false);
-	}
+	viewport shapeColorPane() const { return layout().shapeColor; }
 	//Bottom-side glyph GLmode display
-	viewport glyphGLModePane() const {
-		return viewport(shapePropertiesPane().left(), shapePropertiesPane().top(), shapePropertiesPane().width, glyphGLModeHeight, showGlyphGLMode, false);
-	}
+	viewport glyphGLModePane() const { return layout().glyphGLMode; }
 	//Right-hand side editor tools display
-	viewport toolsPane() const {
-		return viewport(fileTreePane().left() - toolsWidth * !!( showTools && !zen), glyphGLModePane().top(), toolsWidth, tabHeaderPane().bottom() - glyphGLModePane().top(), showTools, true);
-	}
+	viewport toolsPane() const { return layout().tools; }
 	//Central editor display
-	viewport centralPane() const {
-		return viewport(shapesPane().right(), glyphGLModePane().top(), toolsPane().left() - shapesPane().right(), tabHeaderPane().bottom() - glyphGLModePane().top(), true, false);
-	}
+	viewport centralPane() const { return layout().central; }
 
 	// DESTRUCTOR
 	//Deletes all art before going out of scope
 	~editor() {
 		deleteAllArt();
-		destroyFuture();
-		destroyPast();
 	}
 
 	// EDITING FUNCTIONALITIES
-	//Editing to the selected shape/glyph should always be done through this
-	fgr::glyph& currentGlyph() const;
+	//Editing to the selected shape/glyph should always be done through this. Getting at the art
+	//of an editor that isn't const gives it its own copy first, if it's sharing it; read through
+	//a const editor to leave shared art shared.
+	const fgr::glyph& currentGlyph() const { return heldGlyph(); }
+	fgr::glyph& currentGlyph() { ownArt(); return heldGlyph(); }
 	//...Except in cases of shape-exclusive properties.
-	fgr::shape& currentShape() const;
+	const fgr::shape& currentShape() const { return heldShape(); }
+	fgr::shape& currentShape() { ownArt(); return heldShape(); }
 	//The graphic currently being edited
-	fgr::graphic& currentGraphic() const;
+	const fgr::graphic& currentGraphic() const { return heldGraphic(); }
+	fgr::graphic& currentGraphic() { ownArt(); return heldGraphic(); }
+	//Make sure no other editor shares this one's art, copying it if one does
+	void ownArt();
+	//Edit the next shape of the graphic (going back around to the first after the last)
+	void nextShape();
+	//Edit the previous shape of the graphic, if there is one
+	void previousShape();
 	//This function is applied to transform the matrix to its default zoom, considered 100%
 	void baseTransform() const;
 	//Assuming correct translations/viewport, draw the editor contents.
 	void renderArt() const;
+	//Draw a fractal with the chaos game over the visible part of the plane, regenerating only if needed
+	void renderChaosFractal(const fgr::fractal& pattern, const fgr::segment& view) const;
 	//The is the base scaling factor
 	float basefactor() const { return 1.0f / float(centralPane().width); }
 	//Aspect ratio of the central pane, as y/x
 	float aspectRatio() const { return float(centralPane().height) / float(centralPane().width); }
+	//Takes a pixel-position (from the top of the window, as GLUT gives them) to an in-editor coordinate
+	//position; kept until the layout, pan or zoom changes. Rotation isn't accounted for yet.
+	const fgr::affine& pixelToWorld() const;
 	//Maps a pixel-position to an in-editor coordinate position
 	fgr::point mapPixel(int x, int y) const {
-		y = superWindowPane().top() - y;
-		fgr::point retp(float(x - centralPane().left()), float(y - centralPane().bottom()));
-		retp *= basefactor();
-		retp -= fgr::point(0.5f, 0.5f * aspectRatio());
-		retp += pan;
-		retp /= zoom;
-		fgr::rotateabout(retp, fgr::point(0.0f, 0.0f), rotation); //Not working quite right
-		return retp;
-	}
-	//Add a point to the glyph
-	void pushBackPoint(int x, int y) {
-		currentGlyph().push_back(mapPixel(x, y));
-		makechange();
+		return pixelToWorld()(fgr::point(float(x), float(y)));
+	}
+	//Where a pixel lands in the art once it's snapped to whatever :snap has turned on, leaving out
+	//one vertex of the current glyph (the one being dragged or added) and the edges to and from it
+	fgr::point snappedPixel(int x, int y, std::size_t dragged) const;
+	//Add a point to the glyph (points added during one drag are undone together), snapped if asked
+	void pushBackPoint(int x, int y, bool snapped = false) {
+		std::size_t end = currentGlyph().size();
+		insertVertex(end, snapped ? snappedPixel(x, y, end) : mapPixel(x, y));
 		return;
 	}
 	//Insert a point on the shape near the cursor
 	fgr::glyph::iterator insertPoint(int x, int y) {
 		fgr::point dot = mapPixel(x, y);
 		std::pair<fgr::glyphContainer::const_iterator, fgr::point> dest = fgr::nearestCollinearPointMesh(currentGlyph(), dot);
+		std::size_t index = std::distance(fgr::glyphContainer::const_iterator(currentGlyph().begin()), dest.first);
+		fgr::glyph::iterator placed = insertVertex(index, dest.second);
 		makechange();
-		return currentGlyph().insert(dest.first, dest.second);
+		return placed;
+	}
+	//Show where a point would be inserted near the cursor, without counting it as a change
+	void previewInsertPoint(int x, int y) {
+		cancelInsertPreview();
+		if (currentGlyph().size() < 2)
+			return;
+		std::pair<fgr::glyphContainer::const_iterator, fgr::point> dest = fgr::nearestCollinearPointMesh(currentGlyph(), mapPixel(x, y));
+		insertPreviewVertex = currentGlyph().insert(dest.first, dest.second);
+		insertPreviewActive = true;
+	}
+	//Take back the previewed insertion, if there is one
+	void cancelInsertPreview() {
+		if (insertPreviewActive) {
+			ownArt();
+			heldGlyph().erase(insertPreviewVertex);
+			insertPreviewActive = false;
+		}
 	}
 	void movePoint(int x, int y) {
 		float epsilon = 0.005f / zoom;
 		fgr::point dot = mapPixel(x, y);
+		std::size_t index = currentGlyph().size();
 		for (fgr::glyph::reverse_iterator itr = currentGlyph().rbegin(); itr != currentGlyph().rend(); ++itr) {
+			--index;
 			if ((*itr - dot).magnitude() < epsilon) {
+				recordVertexMove(index, *itr, dot);
 				*itr = dot;
 				in_hand_vertex = &(*itr);
+				heldIndex = index;
 			}
 		}
 		return;
 	}
+	//Move the vertex being held to the cursor (the whole drag is undone at once)
+	void dragHeldVertex(int x, int y) {
+		if (!in_hand_vertex)
+			return;
+		ownArt();
+		fgr::point dot = snappedPixel(x, y, heldIndex);
+		recordVertexMove(heldIndex, *in_hand_vertex, dot);
+		*in_hand_vertex = dot;
+	}
 	void deletePoint(int x, int y) {
 		float epsilon = 0.005f / zoom;
 		fgr::point dot = mapPixel(x, y);
-		for (fgr::glyph::iterator itr = currentGlyph().begin(); itr != currentGlyph().end(); ++itr) {
+		std::size_t index = 0;
+		for (fgr::glyph::iterator itr = currentGlyph().begin(); itr != currentGlyph().end(); ++itr, ++index) {
 			if ((*itr - dot).magnitude() < epsilon) {
-				currentGlyph().erase(itr);
+				eraseVertex(index);
+				makechange();
 				return;
 			}
 		}
 		return;
 	}
+
+	// UNDOABLE EDITS
+	//These change the art and write down what they did, as part of the step being made.
+	//Call makechange() once the user is done, so the next change is a step of its own.
+	//Where the glyph (or shape) being edited is in the art
+	artplace currentPlace() const;
+	//The graphic a frame of the art is held in (the graphic itself, if the art isn't an animation)
+	const fgr::graphic& graphicAt(std::size_t frame) const;
+	fgr::graphic& graphicAt(std::size_t frame);
+	//The glyph at some place in the art
+	const fgr::glyph& glyphAt(const artplace& place) const;
+	fgr::glyph& glyphAt(const artplace& place);
+	//Put a vertex into the current glyph before the one at some index (or at the end)
+	fgr::glyph::iterator insertVertex(std::size_t index, const fgr::point& where);
+	//Move a vertex of the current glyph
+	void moveVertex(std::size_t index, const fgr::point& where);
+	//Take a vertex out of the current glyph
+	void eraseVertex(std::size_t index);
+	//Take every vertex out of the current glyph
+	void clearGlyph();
+	//Put a shape into the graphic being edited before the one at some index, and edit it
+	void insertShape(std::size_t index, const fgr::shape& subject);
+	//Take a shape out of the graphic being edited, and edit the one that takes its place
+	void eraseShape(std::size_t index);
+	//Move, scale and rotate every selected vertex at once, in one pass over them. Transforms made
+	//during one step (one drag) fold into a single record.
+	void transformSelection(const fgr::affine& how);
+	//Take every selected vertex out of the art
+	void eraseSelection();
+	//The current shape's (or glyph's) mode, bezier status, color, line width and point size, without its vertices
+	fgr::shape currentStyle() const;
+	//Write down that the current shape (or glyph) has been restyled, from the style it had before
+	void restyled(const fgr::shape& before);
+	// SELECTION
+	//The vertices picked out in the graphic (or glyph) being edited. It's emptied whenever vertices
+	//or shapes are added or taken away, since that changes which vertex a key names.
+	indexset selected;
+	//The outline of a selection being dragged out: two opposite corners of a rectangle, or the path of a lasso
+	std::vector<fgr::point> selectionOutline;
+	bool lassoing = false;
+	//Start dragging out a selection at a pixel. Holding shift adds to the selection there is, and
+	//holding control draws a lasso rather than a rectangle.
+	void beginSelection(int x, int y, int modifiers);
+	//Carry the selection being dragged out to a pixel
+	void extendSelection(int x, int y);
+	//Pick out the vertices inside the outline dragged out, and stop dragging
+	void finishSelection();
+	//Pick out every vertex of the graphic (or glyph) being edited
+	void selectAll();
+	//Pick out no vertices
+	void clearSelection();
+	//The middle of the box around the selected vertices
+	fgr::point selectionCentre() const;
+	//The top-most shape of the graphic being edited under a pixel (the graphic's size if there's none,
+	//and 0 for a glyph or shape, which have no shapes to pick from)
+	std::size_t shapeAt(int x, int y) const;
+	//Edit the top-most shape under a pixel and pick out its vertices. Holding shift adds them to the
+	//selection there is; clicking where there's no shape picks out nothing.
+	void pickShape(int x, int y, int modifiers);
+	//Start a drag with the selection manipulating tool at a pixel: it moves the selection, or
+	//scales it with shift held, or rotates it with control held
+	void beginManipulation(int x, int y, int modifiers);
+	//Carry a drag with the selection manipulating tool to a pixel
+	void dragManipulation(int x, int y);
+	//Take back the last step. Returns false if there's nothing to undo.
+	bool undo();
+	//Make the last step undone again. Returns false if there's nothing to redo.
+	bool redo();
 	//Get the ID of the reigon a particular pixel is in
-	reigonNum reigonID(int x, int y) {
-		//Transform the y-coordinate
-		y = superWindowPane().top() - y;
-		//Check every reigon
-		if (centralPane().contains(x, y))
-			return rCentral;
-		if (animationFramesPane().contains(x, y))
-			return rAnimationFrames;
-		if (commandLinePane().contains(x, y))
-			return rCommandLine;
-		if (fileTreePane().contains(x, y))
-			return rFileTree;
-		if (glyphGLModePane().contains(x, y))
-			return rGlyphGLMode;
-		if (layersPane().contains(x, y))
-			return rLayers;
-		if (shapePropertiesPane().contains(x, y))
-			return rShapeProperties;
-		if (shapesPane().contains(x, y))
-			return rShapes;
-		if (tabHeaderPane().contains(x, y))
-			return rTabHeader;
-		if (toolsPane().contains(x, y))
-			return rTools;
-		return rInconclusive;
-	}
-	//Deal with a click in the shapes panel
+	reigonNum reigonID(int x, int y) const {
+		layout();
+		return reigons.at(x, superWindowPane().top() - y);
+	}
+	//Side length of one shape's thumbnail in the shapes pane, in pixels
+	int shapeThumbnailSize() const {
+		return shapesPane().width - 2 * margin;
+	}
+	//Vertical distance from one shape's thumbnail to the next, in pixels
+	int shapeRowStep() const {
+		return shapeThumbnailSize() + spacing;
+	}
+	//Height of the whole shape list (thumbnails and 'add shape' button), in pixels
+	int shapesContentHeight() const {
+		return int(currentGraphic().size()) * shapeRowStep() + 20 + 2 * margin;
+	}
+	//The range [first, end) of shapes whose thumbnails are at least partly inside the shapes pane
+	void visibleShapeRows(int& first, int& end) const {
+		int rowStep = shapeRowStep();
+		int count = int(currentGraphic().size());
+		if (rowStep <= 0) {
+			first = end = 0;
+			return;
+		}
+		first = std::min(count, std::max(0, shapesScroll - margin) / rowStep);
+		end = std::min(count, (shapesScroll + shapesPane().height) / rowStep + 1);
+	}
+	//Scroll the shape list by some pixels (positive is down), staying within the list
+	void scrollShapes(int pixels) {
+		shapesScroll += pixels;
+		int most = shapesContentHeight() - shapesPane().height;
+		if (shapesScroll > most)
+			shapesScroll = most;
+		if (shapesScroll < 0)
+			shapesScroll = 0;
+	}
+	//Deal with a click in the shapes panel. Only the clicked row is looked at, however many shapes there are.
 	void processShapesClick(int x, int y) {
 		if (!showShapes)
 			return;
 		if (reigonID(x, y) != rShapes)
 			return;
 		y = superWindowPane().top() - y;
-		x -= shapesPane().left();
-		x += margin;
-		y -= shapesPane().top() - margin;
-		int paneWidth = shapesPane().width;
-		int step = paneWidth - 2 * margin;
-		int dy = 0;
-		for (fgr::graphic::iterator itr = currentGraphic().begin();
-			itr != currentGraphic().end(); ++itr) {
-			viewport box(0, dy - paneWidth + 2 * margin, 
-				paneWidth - 2 * margin, 
-				paneWidth - 2 * margin);
-			if (box.contains(x, y)) {
-				subGraphicShape = itr;
-				return;
-			}
-			dy -= step + spacing;
-		}
-		viewport box(0, dy - 20, 
-			paneWidth - 2 * margin, 
-			20);
-		if (box.contains(x, y)) {
-			currentGraphic().push_back(fgr::shape());
-			subGraphicShape = --currentGraphic().end();
+		x -= shapesPane().left() + margin;
+		//Distance down the (scrolled) list from the top of the first thumbnail
+		int depth = shapesScroll - (y - (shapesPane().top() - margin));
+		int step = shapeThumbnailSize();
+		int rowStep = shapeRowStep();
+		if (x < 0 || x > step || depth < 0 || rowStep <= 0)
+			return;
+		std::size_t row = std::size_t(depth / rowStep);
+		int within = depth % rowStep;
+		if (row < currentGraphic().size()) {
+			if (within <= step)
+				subGraphicShape = heldGraphic().begin() + row;
 			return;
 		}
+		if (row == currentGraphic().size() && within <= 20 + margin) {
+			insertShape(currentGraphic().size(), fgr::shape());
+			makechange();
+			//Keep the new shape in sight
+			scrollShapes(shapesContentHeight());
+		}
 		return;
 	}
 	//Zoom in
@@ -608,8 +839,183 @@ public:
 		if (zoom < 0.05f)
 			zoom = 0.05f;
 	}
+
+private:
+	//The last layout worked out, what it was worked out from, and which reigon each pixel is in
+	mutable panelayout panes;
+	mutable layoutkey panesKey;
+	mutable reigonmap reigons;
+	//Counts how many times the layout has been worked out, so what depends on it knows when it's stale
+	mutable unsigned long layoutVersion = 0;
+	//The last pixel-to-world transform, and what it was worked out from
+	mutable fgr::affine pixelTransform;
+	mutable unsigned long pixelTransformVersion = 0;
+	mutable fgr::point pixelTransformPan;
+	mutable float pixelTransformZoom = 0.0f;
+	//Everything the layout depends on
+	layoutkey layoutInputs() const;
+	//The art being edited, without giving this editor its own copy of it. Only for finding and
+	//keeping iterators; call ownArt() before changing anything through these.
+	fgr::glyph& heldGlyph() const;
+	fgr::shape& heldShape() const;
+	fgr::graphic& heldGraphic() const;
+	//Show the same view, tool, layout and colors as another editor
+	void copyView(const editor& other);
+	//False while the art is put away, or hasn't been read yet
+	bool awake = true;
+	//The temporary file art that differs from its file was put away in (closed once no editor holds it)
+	std::shared_ptr<FILE> spill;
+	//Which frame and shape were being edited when the art was put away
+	artplace sleepingPlace;
+	//Read art of this editor's format from a stream into its handle
+	bool readArt(FILE*& source);
+	//Write this editor's art to a stream
+	bool writeArt(FILE*& sink) const;
+	//Give this editor empty art of its format, like a file that isn't there
+	void emptyArt();
+	//Roughly how much memory a graphic takes up, in bytes
+	static std::size_t graphicBytes(const fgr::graphic& art);
+	//True if another editor shares this one's art
+	bool artShared() const {
+		return glyphArt.shared() || shapeArt.shared() || graphicArt.shared() || animArt.shared();
+	}
+	//Move the glyph (or shape) being edited into another one, for converting the art; it's copied
+	//instead if another editor shares the art
+	void takeGlyph(fgr::glyph& into);
+	void takeShape(fgr::shape& into);
+	//Find a vertex of a glyph by its index, walking from whichever end is nearer
+	static fgr::glyph::iterator vertexAt(fgr::glyph& art, std::size_t index) {
+		fgr::glyph::iterator itr;
+		if (index <= art.size() / 2) {
+			itr = art.begin();
+			std::advance(itr, index);
+		}
+		else {
+			itr = art.end();
+			std::advance(itr, -std::ptrdiff_t(art.size() - index));
+		}
+		return itr;
+	}
+	//Write down that a vertex of the current glyph moved
+	void recordVertexMove(std::size_t index, const fgr::point& from, const fgr::point& to);
+	//Write down a change to the art
+	void record(const artedit& change) {
+		if (change.movesIndices())
+			clearSelection();
+		history.record(change);
+		unsavedChanges = true;
+		++revision;
+		keepUp(change);
+	}
+	//Bring the grids of vertices and edges up to date with a vertex moved, or added to the end of its
+	//glyph, just written down but not made yet (the grids are sorted again when next used after any other change)
+	void keepUp(const artedit& change);
+	//Whether the selection being dragged out adds to the one there was
+	bool selectionAdds = false;
+	//What a drag with the selection manipulating tool does, where the cursor was when it was
+	//last handled, and the point scaling and rotating are about
+	enum manipulationkind { mMove, mScale, mRotate };
+	manipulationkind manipulation = mMove;
+	fgr::point manipulationLast;
+	fgr::point manipulationCentre;
+	//Every vertex of the graphic being edited sorted into cells, and the revision and frame it was sorted from
+	mutable vertexgrid vertexIndex;
+	mutable bool vertexIndexBuilt = false;
+	mutable unsigned long vertexIndexRevision = 0;
+	mutable std::size_t vertexIndexFrame = 0;
+	//The grid of vertices, sorted again if the art has changed since it last was
+	const vertexgrid& vertices() const;
+	//The box around every shape of the graphic being edited packed into a tree, and the revision and
+	//frame it was packed from
+	mutable shapetree shapeIndex;
+	mutable bool shapeIndexBuilt = false;
+	mutable unsigned long shapeIndexRevision = 0;
+	mutable std::size_t shapeIndexFrame = 0;
+	//The tree of shapes, packed again if the art has changed since it last was
+	const shapetree& shapeBoxes() const;
+	//Every edge of the graphic being edited sorted into cells, and the revision and frame it was sorted from
+	mutable edgegrid edgeIndex;
+	mutable bool edgeIndexBuilt = false;
+	mutable unsigned long edgeIndexRevision = 0;
+	mutable std::size_t edgeIndexFrame = 0;
+	//The grid of edges, sorted again if the art has changed since it last was
+	const edgegrid& edges() const;
+	//The selected vertices themselves, in the order of their keys, and the art they were found in
+	mutable std::vector<fgr::point*> selectedPoints;
+	mutable const void* selectedPointsArt = NULL;
+	//Which art selected vertices are in (it's different once the art has been copied)
+	const void* selectionArt() const;
+	//The selected vertices, found again if the art has been copied since they last were.
+	//Call ownArt() first to change them.
+	const std::vector<fgr::point*>& selectedVertices() const;
+	//The glyph at some shape (0 for a glyph or shape) of some frame, without copying the art
+	fgr::glyph& heldGlyphAt(std::size_t frame, std::size_t shape) const;
+	//Find the vertices some keys name in a frame, walking through each shape they're in once
+	void pointsAt(const indexset& which, std::size_t frame, std::vector<fgr::point*>& found) const;
+	//Take the vertices some keys name out of a frame, or put them back where the keys say, with
+	//the positions given (as x and y one after the other). Call ownArt() first.
+	void eraseAt(const indexset& which, std::size_t frame);
+	void insertAt(const indexset& which, std::size_t frame, const std::vector<float>& coordinates);
+	//Play one record forward (to redo it) or backward (to undo it)
+	void replay(artedit& change, bool forward);
+	//Edit whatever a record changed
+	void select(const artplace& place);
 };
 
+//Everything the layout depends on
+layoutkey editor::layoutInputs() const {
+	layoutkey inputs = { { windowWidth, windowHeight, zen,
+		showCommandLine, commandLineHeight, showFileTree, fileTreeWidth, showTabHeader, tabHeaderHeight,
+		showAnimationFrames, animationFramesWidth, showLayers, layersWidth, showShapes, shapesWidth,
+		showShapeProperties, shapePropertiesHeight, showGlyphGLMode, glyphGLModeHeight, showTools, toolsWidth } };
+	return inputs;
+}
+
+//Work out every pane, if anything they depend on has changed since they last were
+const panelayout& editor::layout() const {
+	layoutkey inputs = layoutInputs();
+	if (layoutVersion && inputs == panesKey)
+		return panes;
+	perf::timer timing(perf::pLayout);
+	panesKey = inputs;
+	panelayout& l = panes;
+	viewport super = superWindowPane();
+	l.superWindow = super;
+	l.commandLine = viewport(super.left(), super.bottom(), super.right(), commandLineHeight, showCommandLine, false);
+	l.fileTree = viewport(super.right() - fileTreeWidth * (!!showFileTree && !zen), l.commandLine.top(), fileTreeWidth, super.top() - l.commandLine.top(), showFileTree && !zen, true);
+	l.tabHeader = viewport(super.left(), super.top() - tabHeaderHeight * !!(showTabHeader && !zen), l.fileTree.left(), tabHeaderHeight, showTabHeader && !zen, false);
+	l.animationFrames = viewport(super.left(), l.commandLine.top(), animationFramesWidth * !!(showAnimationFrames && !zen), l.tabHeader.bottom() - l.commandLine.top(), showAnimationFrames && !zen, true);
+	l.layers = viewport(l.animationFrames.right(), l.commandLine.top(), layersWidth * !!(showLayers && !zen), l.animationFrames.top() - l.commandLine.top(), showLayers && !zen, true);
+	l.shapes = viewport(l.layers.right(), l.commandLine.top(), shapesWidth * !!(showShapes && !zen), l.animationFrames.top() - l.commandLine.top(), showShapes && !zen, true);
+	l.shapeProperties = viewport(l.shapes.right(), l.commandLine.top(), l.fileTree.left() - l.shapes.right(), shapePropertiesHeight * !!(showShapeProperties && !zen), showShapeProperties && !zen, false);
+	l.shapeColor = viewport(l.shapeProperties.left(), l.commandLine.top(), l.shapeProperties.width / 2, l.shapeProperties.height, l.shapeProperties.show, false);
+	l.shapeSpecifications = viewport(l.shapeColor.right(), l.commandLine.top(), l.shapeProperties.width - l.shapeColor.width, l.shapeProperties.height, l.shapeProperties.show, false);
+	l.glyphGLMode = viewport(l.shapeProperties.left(), l.shapeProperties.top(), l.shapeProperties.width, glyphGLModeHeight, showGlyphGLMode, false);
+	l.tools = viewport(l.fileTree.left() - toolsWidth * !!(showTools && !zen), l.glyphGLMode.top(), toolsWidth, l.tabHeader.bottom() - l.glyphGLMode.top(), showTools, true);
+	l.central = viewport(l.shapes.right(), l.glyphGLMode.top(), l.tools.left() - l.shapes.right(), l.tabHeader.bottom() - l.glyphGLMode.top(), true, false);
+	reigons.build(l);
+	++layoutVersion;
+	return panes;
+}
+
+//The pixel-to-world transform, worked out again only when the layout, pan or zoom has changed
+const fgr::affine& editor::pixelToWorld() const {
+	const panelayout& l = layout();
+	if (pixelTransformVersion == layoutVersion && pixelTransformZoom == zoom
+		&& pixelTransformPan.x() == pan.x() && pixelTransformPan.y() == pan.y())
+		return pixelTransform;
+	//Pixels are counted down from the top of the window, and scaled so the central pane is one unit across
+	float scale = basefactor() / zoom;
+	float aspect = aspectRatio();
+	pixelTransform = fgr::affine(scale, 0.0f, 0.0f, -scale,
+		(pan.x() - 0.5f) / zoom - float(l.central.left()) * scale,
+		(pan.y() - 0.5f * aspect) / zoom + float(l.superWindow.top() - l.central.bottom()) * scale);
+	pixelTransformVersion = layoutVersion;
+	pixelTransformPan = pan;
+	pixelTransformZoom = zoom;
+	return pixelTransform;
+}
+
 //Get the matrix primed for art rendering (not applying user-specified transformations yet)
 void editor::baseTransform() const {
 	glTranslatef(float(centralPane().left()), float(centralPane().bottom()), 0.0f);
@@ -656,6 +1062,79 @@ void editor::defaultSettings() {
 	//toolsMenu = fgr::menu("button1.fgr", fgr::point(toolsPane().left(), toolsPane().bottom()), fgr::point(100.0f, 100.0f), 0, eee, switchTool);
 }
 
+//Make this editor show exactly what another one does
+void editor::mirror(const editor& other) {
+	deleteAllArt();
+	format = other.format;
+	filepath = other.filepath;
+	unsavedChanges = other.unsavedChanges;
+	blankFile = other.blankFile;
+	glyphArt = other.glyphArt;
+	shapeArt = other.shapeArt;
+	graphicArt = other.graphicArt;
+	animArt = other.animArt;
+	//The art is the same, so the same iterators point into it
+	subGraphicShape = other.subGraphicShape;
+	in_hand_vertex = NULL;
+	insertPreviewActive = false;
+	//The selection is drawn too; the art is the same, so the selected vertices found in it still are
+	selected = other.selected;
+	selectedPoints = other.selectedPoints;
+	selectedPointsArt = other.selectedPointsArt;
+	selectionOutline = other.selectionOutline;
+	lassoing = other.lassoing;
+	copyView(other);
+}
+
+//Show the same view, tool, layout and colors as another editor
+void editor::copyView(const editor& other) {
+	//View and tool
+	pan = other.pan;
+	zoom = other.zoom;
+	rotation = other.rotation;
+	currentTool = other.currentTool;
+	//Layout and colors
+	showCommandLine = other.showCommandLine;
+	commandLineHeight = other.commandLineHeight;
+	commandLineColor = other.commandLineColor;
+	showFileTree = other.showFileTree;
+	fileTreeWidth = other.fileTreeWidth;
+	fileTreeColor = other.fileTreeColor;
+	showTabHeader = other.showTabHeader;
+	tabHeaderHeight = other.tabHeaderHeight;
+	tabHeaderColor = other.tabHeaderColor;
+	showAnimationFrames = other.showAnimationFrames;
+	animationFramesWidth = other.animationFramesWidth;
+	animationFramesColor = other.animationFramesColor;
+	showLayers = other.showLayers;
+	layersWidth = other.layersWidth;
+	layersColor = other.layersColor;
+	showShapes = other.showShapes;
+	shapesWidth = other.shapesWidth;
+	shapesColor = other.shapesColor;
+	shapesScroll = other.shapesScroll;
+	showShapeProperties = other.showShapeProperties;
+	shapePropertiesHeight = other.shapePropertiesHeight;
+	shapeColorWidth = other.shapeColorWidth;
+	shapeColorColor = other.shapeColorColor;
+	shapeSpecificationsColor = other.shapeSpecificationsColor;
+	showGlyphGLMode = other.showGlyphGLMode;
+	glyphGLModeHeight = other.glyphGLModeHeight;
+	glyphGLModeColor = other.glyphGLModeColor;
+	showTools = other.showTools;
+	toolsWidth = other.toolsWidth;
+	toolsColor = other.toolsColor;
+	margin = other.margin;
+	spacing = other.spacing;
+	brushTolerance = other.brushTolerance;
+	show_skeleton = other.show_skeleton;
+	//Experimental fractal settings (the cached cloud stays with whoever drew it)
+	experimentalFractalMode = other.experimentalFractalMode;
+	experimentalFractalIterations = other.experimentalFractalIterations;
+	experimentalFractalChaos = other.experimentalFractalChaos;
+	experimentalFractalPoints = other.experimentalFractalPoints;
+}
+
 //Load an empty file of a given kind, which will cause loss of unsaved changes
 void editor::newFile(editortype filetype) {
 	deleteAllArt();
@@ -665,28 +1144,29 @@ void editor::newFile(editortype filetype) {
 	blankFile = false;
 	switch (filetype) {
 	case eAnimation:
-		animArt = new fgr::animation;
-		subGraphicShape = currentGraphic().begin();
+		animArt.reset(new fgr::animation);
+		subGraphicShape = heldGraphic().begin();
 		break;
 	default:
 	case eGraphic:
-		graphicArt = new fgr::graphic;
-		subGraphicShape = graphicArt->begin();
+		graphicArt.reset(new fgr::graphic);
+		subGraphicShape = heldGraphic().begin();
 		break;
 	case eShape:
-		shapeArt = new fgr::shape;
+		shapeArt.reset(new fgr::shape);
 		break;
 	case eGlyph:
-		glyphArt = new fgr::glyph;
+		glyphArt.reset(new fgr::glyph);
 		break;
 	}
 	return;
 }
 
-/* Editing to the selected shape/glyph should always be done through this.
+/* The glyph being edited, without copying shared art (see currentGlyph(), which editing
+ * should always be done through).
  * Be sure to update the 'blankFile' flag to false if something is changed!
  * As well as the 'unsavedChanges' flag!!!! */
-fgr::glyph& editor::currentGlyph() const {
+fgr::glyph& editor::heldGlyph() const {
 	switch (format) {
 	case eSpritesheet:
 		//NOT YET SUPPORTED
@@ -697,17 +1177,17 @@ fgr::glyph& editor::currentGlyph() const {
 	case eGraphic:
 		return *subGraphicShape;
 	case eShape:
-		return *shapeArt;
+		return *shapeArt.get();
 	case eGlyph:
-		return *glyphArt;
+		return *glyphArt.get();
 	}
 	//Exception
-	assert(0 && "Bad logic in editor::currentGlyph");
-	return *glyphArt;
+	assert(0 && "Bad logic in editor::heldGlyph");
+	return *glyphArt.get();
 }
 
-//Access the current shape! Good for colors, etc.
-fgr::shape& editor::currentShape() const {
+//The shape being edited. Good for colors, etc.
+fgr::shape& editor::heldShape() const {
 	switch (format) {
 	case eSpritesheet:
 		//NOT YET SUPPORTED
@@ -719,120 +1199,838 @@ fgr::shape& editor::currentShape() const {
 		return *subGraphicShape;
 		break;
 	case eShape:
-		return *shapeArt;
+		return *shapeArt.get();
 	}
 	//Exception
-	assert(0 && "Bad logic in editor::currentShape");
-	return *shapeArt;
+	assert(0 && "Bad logic in editor::heldShape");
+	return *shapeArt.get();
 }
 
-//Access the current Graphic
-fgr::graphic& editor::currentGraphic() const {
+//The graphic being edited
+fgr::graphic& editor::heldGraphic() const {
 	switch (format) {
 	case eGraphic:
-		return *graphicArt;
+		return *graphicArt.get();
 	case eAnimation:
-		return *(animArt->currentframe);
+		return *(animArt.get()->currentframe);
 	case eSpritesheet:
 		//Not yet supported
 		assert(0 && "Spritesheet editing not yet supported");
-		return *graphicArt;
+		return *graphicArt.get();
 	}
 	assert(0);
+	return *graphicArt.get();
 }
 
-//Reformat the art to another type
-void editor::convertFile(editortype newformat) {
-	//2x2 switch
-	switch (newformat) {
-	case eGlyph: //Convert to glyph
-		switch (format) {
-		case eShape: //Shape to glyph
-			glyphArt = new fgr::glyph(*shapeArt);
-			delete shapeArt;
-			shapeArt = NULL;
-			break;
-		case eGraphic: //Graphic to glyph
-			glyphArt = new fgr::glyph(currentGlyph());
-			delete graphicArt;
-			graphicArt = NULL;
-			break;
-		case eAnimation: //Animation to glyph
-			glyphArt = new fgr::glyph(currentGlyph());
-			delete animArt;
-			animArt = NULL;
-			break;
-		}
+//Give this editor its own copy of its art, if another one shares it
+void editor::ownArt() {
+	if (!artShared())
+		return;
+	//Iterators into the shared art are found again by their place in the copy
+	bool inGraphic = format == eGraphic || format == eAnimation;
+	std::size_t shape = inGraphic ? std::size_t(subGraphicShape - heldGraphic().begin()) : 0;
+	std::size_t preview = insertPreviewActive ? std::size_t(std::distance(heldGlyph().begin(), insertPreviewVertex)) : 0;
+	glyphArt.unshare();
+	shapeArt.unshare();
+	graphicArt.unshare();
+	animArt.unshare();
+	if (inGraphic)
+		subGraphicShape = heldGraphic().begin() + shape;
+	if (insertPreviewActive)
+		insertPreviewVertex = vertexAt(heldGlyph(), preview);
+	if (in_hand_vertex)
+		in_hand_vertex = &*vertexAt(heldGlyph(), heldIndex);
+}
+
+//Move the vertices, mode and bezier status of the glyph being edited into another glyph
+void editor::takeGlyph(fgr::glyph& into) {
+	const fgr::glyph& art = heldGlyph();
+	into.mode = art.mode;
+	into.bezier = art.bezier;
+	if (artShared())
+		into.assign(art.begin(), art.end());
+	else
+		into.splice(into.end(), heldGlyph());
+}
+
+//Move the shape being edited into another shape (a glyph keeps the default style)
+void editor::takeShape(fgr::shape& into) {
+	if (format != eGlyph) {
+		const fgr::shape& look = heldShape();
+		into.color = look.color;
+		into.lineThickness = look.lineThickness;
+		into.pointSize = look.pointSize;
+	}
+	takeGlyph(into);
+}
+
+//Edit the next shape of the graphic
+void editor::nextShape() {
+	fgr::graphic& art = heldGraphic();
+	if (subGraphicShape == art.end() || ++subGraphicShape == art.end())
+		subGraphicShape = art.begin();
+}
+
+//Edit the previous shape of the graphic
+void editor::previousShape() {
+	if (subGraphicShape != heldGraphic().begin())
+		--subGraphicShape;
+}
+
+//Where the glyph (or shape) being edited is in the art
+artplace editor::currentPlace() const {
+	artplace place;
+	place.frame = format == eAnimation ? std::size_t(animArt->currentframe - animArt->begin()) : 0;
+	place.shape = format == eGraphic || format == eAnimation ? std::size_t(subGraphicShape - currentGraphic().begin()) : NO_SHAPE;
+	return place;
+}
+
+//The graphic a frame of the art is held in
+const fgr::graphic& editor::graphicAt(std::size_t frame) const {
+	if (format == eAnimation)
+		return (*animArt)[frame];
+	return *graphicArt;
+}
+fgr::graphic& editor::graphicAt(std::size_t frame) {
+	ownArt();
+	if (format == eAnimation)
+		return (*animArt.get())[frame];
+	return *graphicArt.get();
+}
+
+//The glyph at some place in the art
+const fgr::glyph& editor::glyphAt(const artplace& place) const {
+	if (place.shape != NO_SHAPE)
+		return graphicAt(place.frame)[place.shape];
+	if (format == eShape)
+		return *shapeArt;
+	return *glyphArt;
+}
+fgr::glyph& editor::glyphAt(const artplace& place) {
+	if (place.shape != NO_SHAPE)
+		return graphicAt(place.frame)[place.shape];
+	ownArt();
+	if (format == eShape)
+		return *shapeArt.get();
+	return *glyphArt.get();
+}
+
+//Put a vertex into the current glyph before the one at some index
+fgr::glyph::iterator editor::insertVertex(std::size_t index, const fgr::point& where) {
+	artedit change;
+	change.what = artedit::kInsertVertex;
+	change.place = currentPlace();
+	change.index = index;
+	change.after = where;
+	record(change);
+	return currentGlyph().insert(vertexAt(currentGlyph(), index), where);
+}
+
+//Move a vertex of the current glyph
+void editor::moveVertex(std::size_t index, const fgr::point& where) {
+	fgr::glyph::iterator vertex = vertexAt(currentGlyph(), index);
+	recordVertexMove(index, *vertex, where);
+	*vertex = where;
+}
+
+//Write down that a vertex of the current glyph moved
+void editor::recordVertexMove(std::size_t index, const fgr::point& from, const fgr::point& to) {
+	artedit change;
+	change.what = artedit::kMoveVertex;
+	change.place = currentPlace();
+	change.index = index;
+	change.before = from;
+	change.after = to;
+	record(change);
+}
+
+//Take a vertex out of the current glyph
+void editor::eraseVertex(std::size_t index) {
+	fgr::glyph::iterator vertex = vertexAt(currentGlyph(), index);
+	artedit change;
+	change.what = artedit::kEraseVertex;
+	change.place = currentPlace();
+	change.index = index;
+	change.before = *vertex;
+	record(change);
+	if (in_hand_vertex == &(*vertex))
+		in_hand_vertex = NULL;
+	currentGlyph().erase(vertex);
+}
+
+//Take every vertex out of the current glyph; they're moved into the record, not copied
+void editor::clearGlyph() {
+	artedit change;
+	change.what = artedit::kClearGlyph;
+	change.place = currentPlace();
+	change.index = 0;
+	change.points.splice(change.points.end(), currentGlyph());
+	in_hand_vertex = NULL;
+	record(change);
+}
+
+//Put a shape into the graphic being edited before the one at some index, and edit it
+void editor::insertShape(std::size_t index, const fgr::shape& subject) {
+	artedit change;
+	change.what = artedit::kInsertShape;
+	change.place = currentPlace();
+	change.place.shape = index;
+	change.index = 0;
+	change.subject = subject;
+	record(change);
+	subGraphicShape = currentGraphic().insert(currentGraphic().begin() + index, subject);
+	in_hand_vertex = NULL;
+}
+
+//Take a shape out of the graphic being edited, and edit the one that takes its place
+void editor::eraseShape(std::size_t index) {
+	artedit change;
+	change.what = artedit::kEraseShape;
+	change.place = currentPlace();
+	change.place.shape = index;
+	change.index = 0;
+	change.subject = currentGraphic()[index];
+	record(change);
+	currentGraphic().erase(currentGraphic().begin() + index);
+	in_hand_vertex = NULL;
+	select(change.place);
+}
+
+//The current shape's (or glyph's) style, without its vertices
+fgr::shape editor::currentStyle() const {
+	const fgr::glyph& art = currentGlyph();
+	fgr::glyph bare(art.mode, art.bezier, fgr::glyphContainer());
+	if (format == eGlyph)
+		return fgr::shape(bare);
+	const fgr::shape& look = currentShape();
+	return fgr::shape(bare, look.color, look.lineThickness, look.pointSize);
+}
+
+//Write down that the current shape (or glyph) has been restyled
+void editor::restyled(const fgr::shape& before) {
+	artedit change;
+	change.what = artedit::kRestyle;
+	change.place = currentPlace();
+	change.index = 0;
+	change.subject = before;
+	change.restyled = currentStyle();
+	record(change);
+	makechange();
+}
+
+//Play one record forward or backward
+void editor::replay(artedit& change, bool forward) {
+	if (change.movesIndices())
+		clearSelection();
+	switch (change.what) {
+	case artedit::kMoveVertex:
+		*vertexAt(glyphAt(change.place), change.index) = forward ? change.after : change.before;
 		break;
-	case eShape: //Convert to shape
-		switch (format) {
-		case eGlyph: //Glyph to shape
-			shapeArt = new fgr::shape(*glyphArt);
-			delete glyphArt;
-			glyphArt = NULL;
-			break;
-		case eGraphic: //Graphic to shape
-			shapeArt = new fgr::shape(currentShape());
-			delete graphicArt;
-			graphicArt = NULL;
-			break;
-		case eAnimation: //Animation to shape
-			shapeArt = new fgr::shape(currentShape());
-			delete animArt;
-			animArt = NULL;
-			break;
+	case artedit::kInsertVertex:
+	case artedit::kEraseVertex: {
+		fgr::glyph& art = glyphAt(change.place);
+		if (forward == (change.what == artedit::kInsertVertex))
+			art.insert(vertexAt(art, change.index), forward ? change.after : change.before);
+		else
+			art.erase(vertexAt(art, change.index));
+		break;
+	}
+	case artedit::kClearGlyph:
+		if (forward)
+			change.points.splice(change.points.end(), glyphAt(change.place));
+		else
+			glyphAt(change.place).splice(glyphAt(change.place).end(), change.points);
+		break;
+	case artedit::kInsertShape:
+	case artedit::kEraseShape: {
+		fgr::graphic& art = graphicAt(change.place.frame);
+		if (forward == (change.what == artedit::kInsertShape))
+			art.insert(art.begin() + change.place.shape, change.subject);
+		else
+			art.erase(art.begin() + change.place.shape);
+		break;
+	}
+	case artedit::kRestyle: {
+		const fgr::shape& look = forward ? change.restyled : change.subject;
+		fgr::glyph& art = glyphAt(change.place);
+		art.mode = look.mode;
+		art.bezier = look.bezier;
+		if (format != eGlyph) {
+			fgr::shape& restyle = static_cast<fgr::shape&>(art);
+			restyle.color = look.color;
+			restyle.lineThickness = look.lineThickness;
+			restyle.pointSize = look.pointSize;
 		}
 		break;
-	case eGraphic: //Convert to graphic
-		switch (format) {
-		case eGlyph: //Glyph to Graphic
-			graphicArt = new fgr::graphic(*glyphArt);
-			delete glyphArt;
-			glyphArt = NULL;
-			break;
-		case eShape: //Shape to Graphic
-			graphicArt = new fgr::graphic(*shapeArt);
-			delete shapeArt;
-			shapeArt = NULL;
-			break;
-		case eAnimation: //Animation to Graphic
-			graphicArt = new fgr::graphic(animArt->front());
-			delete animArt;
-			animArt = NULL;
-			break;
+	}
+	case artedit::kTransformVertices: {
+		//The vertices go back to where they were, or to where the transform took them from there
+		ownArt();
+		std::vector<fgr::point*> moved;
+		pointsAt(change.vertices, change.place.frame, moved);
+		for (std::size_t i = 0; i < moved.size(); ++i) {
+			float x = change.coordinates[2 * i], y = change.coordinates[2 * i + 1];
+			if (forward)
+				change.transform.apply(x, y);
+			moved[i]->x(x);
+			moved[i]->y(y);
 		}
-		subGraphicShape = graphicArt->begin();
 		break;
-	case eAnimation: //Convert to animation
-		switch (format) {
-		case eGlyph: //Glyph to Animation
-			animArt = new fgr::animation(*glyphArt);
-			delete glyphArt;
-			glyphArt = NULL;
-			break;
-		case eShape: //Shape to Animation
-			animArt = new fgr::animation(*shapeArt);
-			delete shapeArt;
-			glyphArt = NULL;
-			break;
-		case eGraphic: //Graphic to Animation
-			animArt = new fgr::animation(*graphicArt);
-			delete graphicArt;
-			graphicArt = NULL;
-			break;
+	}
+	case artedit::kEraseVertices:
+		ownArt();
+		if (forward)
+			eraseAt(change.vertices, change.place.frame);
+		else
+			insertAt(change.vertices, change.place.frame, change.coordinates);
+		break;
+	}
+	select(change.place);
+}
+
+//Edit whatever a record changed: its frame, and its shape (or the nearest one left)
+void editor::select(const artplace& place) {
+	//Which frame is current is kept in the animation itself
+	if (format == eAnimation) {
+		//The selection is of the frame being edited
+		if (place.frame != currentPlace().frame)
+			clearSelection();
+		ownArt();
+		animArt.get()->currentframe = animArt.get()->begin() + place.frame;
+	}
+	if (place.shape == NO_SHAPE)
+		return;
+	fgr::graphic& art = heldGraphic();
+	std::size_t index = place.shape;
+	if (index >= art.size() && art.size())
+		index = art.size() - 1;
+	subGraphicShape = art.begin() + index;
+}
+
+//The glyph at some shape of some frame, without copying the art
+fgr::glyph& editor::heldGlyphAt(std::size_t frame, std::size_t shape) const {
+	switch (format) {
+	case eGlyph:
+		return *glyphArt.get();
+	case eShape:
+		return *shapeArt.get();
+	case eAnimation:
+		return (*animArt.get())[frame][shape];
+	default:
+		return (*graphicArt.get())[shape];
+	}
+}
+
+//Find the vertices some keys name in a frame
+void editor::pointsAt(const indexset& which, std::size_t frame, std::vector<fgr::point*>& found) const {
+	found.clear();
+	found.reserve(which.size());
+	const std::vector<indexset::run>& runs = which.runs();
+	fgr::glyph* art = NULL;
+	fgr::glyph::iterator walker;
+	std::size_t shape = 0, at = 0;
+	for (std::size_t r = 0; r < runs.size(); ++r) {
+		if (!art || keyShape(runs[r].first) != shape) {
+			shape = keyShape(runs[r].first);
+			art = &heldGlyphAt(frame, shape);
+			walker = art->begin();
+			at = 0;
 		}
-		subGraphicShape = animArt->currentframe->begin();
+		std::size_t first = keyVertex(runs[r].first), last = keyVertex(runs[r].last);
+		std::advance(walker, first - at);
+		for (at = first; at <= last; ++at, ++walker)
+			found.push_back(&*walker);
+	}
+}
+
+//Take the vertices some keys name out of a frame
+void editor::eraseAt(const indexset& which, std::size_t frame) {
+	const std::vector<indexset::run>& runs = which.runs();
+	fgr::glyph* art = NULL;
+	fgr::glyph::iterator walker;
+	//Counted in the indices the glyph had before anything was taken out of it
+	std::size_t shape = 0, at = 0;
+	for (std::size_t r = 0; r < runs.size(); ++r) {
+		if (!art || keyShape(runs[r].first) != shape) {
+			shape = keyShape(runs[r].first);
+			art = &heldGlyphAt(frame, shape);
+			walker = art->begin();
+			at = 0;
+		}
+		std::size_t first = keyVertex(runs[r].first), last = keyVertex(runs[r].last);
+		std::advance(walker, first - at);
+		for (at = first; at <= last; ++at)
+			walker = art->erase(walker);
+	}
+}
+
+//Put the vertices some keys name back into a frame
+void editor::insertAt(const indexset& which, std::size_t frame, const std::vector<float>& coordinates) {
+	const std::vector<indexset::run>& runs = which.runs();
+	fgr::glyph* art = NULL;
+	fgr::glyph::iterator walker;
+	std::size_t shape = 0, at = 0, placed = 0;
+	for (std::size_t r = 0; r < runs.size(); ++r) {
+		if (!art || keyShape(runs[r].first) != shape) {
+			shape = keyShape(runs[r].first);
+			art = &heldGlyphAt(frame, shape);
+			walker = art->begin();
+			at = 0;
+		}
+		//Going in order, every vertex put back before this one is already where it belongs
+		std::size_t first = keyVertex(runs[r].first), last = keyVertex(runs[r].last);
+		std::advance(walker, first - at);
+		for (at = first; at <= last; ++at, ++placed)
+			art->insert(walker, fgr::point(coordinates[2 * placed], coordinates[2 * placed + 1]));
+	}
+}
+
+//Which art selected vertices are in
+const void* editor::selectionArt() const {
+	switch (format) {
+	case eGlyph:		return glyphArt.get();
+	case eShape:		return shapeArt.get();
+	case eGraphic:		return graphicArt.get();
+	case eAnimation:	return animArt.get();
+	default:			return NULL;
+	}
+}
+
+//The selected vertices, found again if the art has been copied since they last were
+const std::vector<fgr::point*>& editor::selectedVertices() const {
+	if (selectedPointsArt != selectionArt() || selectedPoints.size() != selected.size()) {
+		pointsAt(selected, currentPlace().frame, selectedPoints);
+		selectedPointsArt = selectionArt();
+	}
+	return selectedPoints;
+}
+
+//The grid of vertices, sorted again if the art has changed since it last was
+const vertexgrid& editor::vertices() const {
+	std::size_t frame = currentPlace().frame;
+	if (!vertexIndexBuilt || vertexIndexRevision != revision || vertexIndexFrame != frame) {
+		if (format == eGraphic || format == eAnimation)
+			vertexIndex.build(currentGraphic());
+		else
+			vertexIndex.build(currentGlyph());
+		vertexIndexBuilt = true;
+		vertexIndexRevision = revision;
+		vertexIndexFrame = frame;
+	}
+	return vertexIndex;
+}
+
+//The tree of shapes, packed again if the art has changed since it last was
+const shapetree& editor::shapeBoxes() const {
+	std::size_t frame = currentPlace().frame;
+	if (!shapeIndexBuilt || shapeIndexRevision != revision || shapeIndexFrame != frame) {
+		shapeIndex.build(currentGraphic());
+		shapeIndexBuilt = true;
+		shapeIndexRevision = revision;
+		shapeIndexFrame = frame;
+	}
+	return shapeIndex;
+}
+
+//The grid of edges, sorted again if the art has changed since it last was
+const edgegrid& editor::edges() const {
+	std::size_t frame = currentPlace().frame;
+	if (!edgeIndexBuilt || edgeIndexRevision != revision || edgeIndexFrame != frame) {
+		if (format == eGraphic || format == eAnimation)
+			edgeIndex.build(currentGraphic());
+		else
+			edgeIndex.build(currentGlyph());
+		edgeIndexBuilt = true;
+		edgeIndexRevision = revision;
+		edgeIndexFrame = frame;
+	}
+	return edgeIndex;
+}
+
+//Bring the grids of vertices and edges up to date with a vertex moved or added to the end of its glyph
+void editor::keepUp(const artedit& change) {
+	std::size_t shape = change.place.shape == NO_SHAPE ? 0 : change.place.shape;
+	vertexkey key = makeVertexKey(shape, change.index);
+	bool moved = change.what == artedit::kMoveVertex;
+	//Only the vertex itself is new; one put anywhere else would change the keys of the ones after it
+	bool appended = change.what == artedit::kInsertVertex
+		&& change.index == heldGlyphAt(change.place.frame, shape).size();
+	if (!moved && !appended)
+		return;
+	//The grids have to have been up to date just before this change, and of the frame it's in
+	if (vertexIndexBuilt && vertexIndexRevision + 1 == revision && vertexIndexFrame == change.place.frame) {
+		if (appended)
+			vertexIndex.add(key, change.after);
+		if (appended || vertexIndex.move(key, change.before, change.after))
+			vertexIndexRevision = revision;
+	}
+	if (edgeIndexBuilt && edgeIndexRevision + 1 == revision && edgeIndexFrame == change.place.frame) {
+		bool keptUp;
+		if (edgeIndex.curved(shape)) {
+			//A curve is cut into pieces again from every control point. Changes are written down
+			//before they're made, so it's cut from a copy with the change made to it.
+			fgr::glyph edited = heldGlyphAt(change.place.frame, shape);
+			if (appended)
+				edited.push_back(change.after);
+			else
+				*vertexAt(edited, change.index) = change.after;
+			keptUp = edgeIndex.reshape(shape, edited);
+		}
+		else
+			keptUp = appended ? edgeIndex.append(shape, change.after) : edgeIndex.move(key, change.after);
+		if (keptUp)
+			edgeIndexRevision = revision;
+	}
+}
+
+//Where a pixel lands in the art once it's snapped
+fgr::point editor::snappedPixel(int x, int y, std::size_t dragged) const {
+	fgr::point at = mapPixel(x, y);
+	if (!snap::any())
+		return at;
+	//How far the cursor reaches in the art, for how close a vertex or edge has to be
+	float reach = snap::reach * (mapPixel(x + 1, y) - at).magnitude();
+	vertexkey skip = makeVertexKey(format == eGraphic || format == eAnimation ? currentPlace().shape : 0, dragged);
+	if (snap::toVertices) {
+		vertexgrid::entry found;
+		if (vertices().nearest(at, reach, skip, found))
+			return fgr::point(found.x, found.y);
+	}
+	if (snap::toEdges) {
+		fgr::point found;
+		if (edges().nearest(at, reach, skip, found))
+			return found;
+	}
+	if (snap::toGrid)
+		return snap::toGridPoint(at);
+	return at;
+}
+
+//The top-most shape under a pixel
+std::size_t editor::shapeAt(int x, int y) const {
+	if (format != eGraphic && format != eAnimation)
+		return 0;
+	//How far one pixel is in the art, for how close to a line counts as on it
+	fgr::point at = mapPixel(x, y);
+	float pixel = (mapPixel(x + 1, y) - at).magnitude();
+	return shapeBoxes().topmost(currentGraphic(), at, pixel);
+}
+
+//Edit the top-most shape under a pixel and pick out its vertices
+void editor::pickShape(int x, int y, int modifiers) {
+	if (format != eGraphic && format != eAnimation)
+		return;
+	std::size_t hit = shapeAt(x, y);
+	bool adds = (modifiers & GLUT_ACTIVE_SHIFT) != 0;
+	//Picking changes nothing, so the art is only looked at, and stays shared
+	const fgr::graphic& art = heldGraphic();
+	if (hit >= art.size()) {
+		if (!adds)
+			clearSelection();
+		return;
+	}
+	subGraphicShape = heldGraphic().begin() + hit;
+	indexset picked;
+	picked.append(makeVertexKey(hit, 0), makeVertexKey(hit, art[hit].size() - 1));
+	if (adds)
+		selected.merge(picked);
+	else
+		selected = picked;
+	selectedPointsArt = NULL;
+	//Keep the shape's thumbnail in sight
+	int row = int(hit) * shapeRowStep();
+	if (row < shapesScroll || row + shapeRowStep() > shapesScroll + shapesPane().height)
+		scrollShapes(row - shapesScroll);
+}
+
+//Start dragging out a selection at a pixel
+void editor::beginSelection(int x, int y, int modifiers) {
+	fgr::point dot = mapPixel(x, y);
+	lassoing = (modifiers & GLUT_ACTIVE_CTRL) != 0;
+	selectionAdds = (modifiers & GLUT_ACTIVE_SHIFT) != 0;
+	selectionOutline.assign(lassoing ? 1 : 2, dot);
+}
+
+//Carry the selection being dragged out to a pixel
+void editor::extendSelection(int x, int y) {
+	if (selectionOutline.empty())
+		return;
+	if (lassoing)
+		selectionOutline.push_back(mapPixel(x, y));
+	else
+		selectionOutline.back() = mapPixel(x, y);
+}
+
+//Pick out the vertices inside the outline dragged out
+void editor::finishSelection() {
+	if (selectionOutline.empty())
+		return;
+	std::vector<vertexkey> found;
+	if (lassoing)
+		vertices().within(selectionOutline, found);
+	else
+		vertices().within(selectionOutline.front(), selectionOutline.back(), found);
+	indexset picked;
+	picked.assign(found);
+	if (selectionAdds)
+		selected.merge(picked);
+	else
+		selected = picked;
+	selectedPointsArt = NULL;
+	selectionOutline.clear();
+	lassoing = false;
+}
+
+//Pick out every vertex of the graphic (or glyph) being edited
+void editor::selectAll() {
+	clearSelection();
+	//Selecting changes nothing, so the art is only looked at, and stays shared
+	if (format == eGraphic || format == eAnimation) {
+		const fgr::graphic& art = heldGraphic();
+		for (std::size_t s = 0; s < art.size(); ++s) {
+			if (art[s].size())
+				selected.append(makeVertexKey(s, 0), makeVertexKey(s, art[s].size() - 1));
+		}
+	}
+	else if (heldGlyph().size()) {
+		selected.append(makeVertexKey(0, 0), makeVertexKey(0, heldGlyph().size() - 1));
+	}
+}
+
+//Pick out no vertices
+void editor::clearSelection() {
+	selected.clear();
+	selectedPoints.clear();
+	selectedPointsArt = NULL;
+}
+
+//The middle of the box around the selected vertices
+fgr::point editor::selectionCentre() const {
+	const std::vector<fgr::point*>& dots = selectedVertices();
+	if (dots.empty())
+		return fgr::point();
+	float left = dots[0]->x(), right = left, bottom = dots[0]->y(), top = bottom;
+	for (std::size_t i = 1; i < dots.size(); ++i) {
+		left = std::min(left, dots[i]->x());
+		right = std::max(right, dots[i]->x());
+		bottom = std::min(bottom, dots[i]->y());
+		top = std::max(top, dots[i]->y());
+	}
+	return fgr::point((left + right) / 2.0f, (bottom + top) / 2.0f);
+}
+
+//Move, scale and rotate every selected vertex at once
+void editor::transformSelection(const fgr::affine& how) {
+	if (selected.empty())
+		return;
+	cancelInsertPreview();
+	ownArt();
+	const std::vector<fgr::point*>& dots = selectedVertices();
+	//Every transform of one drag folds into the record the drag started
+	artedit* last = history.lastOpen();
+	if (last && last->what == artedit::kTransformVertices && last->place.frame == currentPlace().frame
+		&& last->vertices == selected) {
+		last->transform = how * last->transform;
+		unsavedChanges = true;
+		++revision;
+	}
+	else {
+		artedit change;
+		change.what = artedit::kTransformVertices;
+		change.place = currentPlace();
+		change.index = 0;
+		change.vertices = selected;
+		change.coordinates.reserve(2 * dots.size());
+		for (std::size_t i = 0; i < dots.size(); ++i) {
+			change.coordinates.push_back(dots[i]->x());
+			change.coordinates.push_back(dots[i]->y());
+		}
+		change.transform = how;
+		record(change);
+	}
+	//One pass over the vertices; a big selection is split across every core
+	auto move = [&dots, &how](std::size_t begin, std::size_t end, unsigned int) {
+		for (std::size_t i = begin; i < end; ++i) {
+			float x = dots[i]->x(), y = dots[i]->y();
+			how.apply(x, y);
+			dots[i]->x(x);
+			dots[i]->y(y);
+		}
+	};
+	if (dots.size() < 65536)
+		move(0, dots.size(), 0);
+	else
+		fgr::parallel::forChunks(0, dots.size(), move);
+}
+
+//Take every selected vertex out of the art
+void editor::eraseSelection() {
+	if (selected.empty())
+		return;
+	cancelInsertPreview();
+	in_hand_vertex = NULL;
+	ownArt();
+	const std::vector<fgr::point*>& dots = selectedVertices();
+	artedit change;
+	change.what = artedit::kEraseVertices;
+	change.place = currentPlace();
+	change.index = 0;
+	change.vertices = selected;
+	change.coordinates.reserve(2 * dots.size());
+	for (std::size_t i = 0; i < dots.size(); ++i) {
+		change.coordinates.push_back(dots[i]->x());
+		change.coordinates.push_back(dots[i]->y());
+	}
+	//Recording it empties the selection
+	record(change);
+	eraseAt(change.vertices, change.place.frame);
+}
+
+//Start a drag with the selection manipulating tool
+void editor::beginManipulation(int x, int y, int modifiers) {
+	if (modifiers & GLUT_ACTIVE_SHIFT)
+		manipulation = mScale;
+	else if (modifiers & GLUT_ACTIVE_CTRL)
+		manipulation = mRotate;
+	else
+		manipulation = mMove;
+	manipulationLast = mapPixel(x, y);
+	manipulationCentre = selectionCentre();
+}
+
+//Carry a drag with the selection manipulating tool to a pixel
+void editor::dragManipulation(int x, int y) {
+	if (selected.empty())
+		return;
+	fgr::point dot = mapPixel(x, y);
+	float cx = manipulationCentre.x(), cy = manipulationCentre.y();
+	float fromX = manipulationLast.x() - cx, fromY = manipulationLast.y() - cy;
+	float toX = dot.x() - cx, toY = dot.y() - cy;
+	fgr::affine how;
+	switch (manipulation) {
+	case mMove:
+		how = fgr::affine(1.0f, 0.0f, 0.0f, 1.0f, dot.x() - manipulationLast.x(), dot.y() - manipulationLast.y());
+		break;
+	case mScale: {
+		//Scaled about the centre by how much further from it the cursor is
+		float from = std::sqrt(fromX * fromX + fromY * fromY);
+		if (from < 1e-6f)
+			return;
+		float factor = std::sqrt(toX * toX + toY * toY) / from;
+		how = fgr::affine(factor, 0.0f, 0.0f, factor, cx - factor * cx, cy - factor * cy);
+		break;
+	}
+	case mRotate: {
+		//Rotated about the centre by the angle the cursor turned through around it
+		float turn = std::atan2(toY, toX) - std::atan2(fromY, fromX);
+		float cosine = std::cos(turn), sine = std::sin(turn);
+		how = fgr::affine(cosine, -sine, sine, cosine, cx - (cosine * cx - sine * cy), cy - (sine * cx + cosine * cy));
 		break;
-	case eSpritesheet: //Convert to spritesheet
+	}
+	}
+	manipulationLast = dot;
+	transformSelection(how);
+}
 
+//Take back the last step
+bool editor::undo() {
+	cancelInsertPreview();
+	in_hand_vertex = NULL;
+	std::vector<artedit>* step = history.undo();
+	if (!step)
+		return false;
+	for (std::size_t i = step->size(); i-- > 0;)
+		replay((*step)[i], false);
+	unsavedChanges = true;
+	++revision;
+	return true;
+}
+
+//Make the last step undone again
+bool editor::redo() {
+	cancelInsertPreview();
+	in_hand_vertex = NULL;
+	std::vector<artedit>* step = history.redo();
+	if (!step)
+		return false;
+	for (std::size_t i = 0; i < step->size(); ++i)
+		replay((*step)[i], true);
+	unsavedChanges = true;
+	++revision;
+	return true;
+}
+
+//Reformat the art to another type. Whatever is kept of the art is moved over rather than
+//copied, unless another editor shares it.
+void editor::convertFile(editortype newformat) {
+	//There's nothing to do for the same format, and spritesheets aren't supported yet
+	if (newformat == format || newformat == eSpritesheet)
+		return;
+	cancelInsertPreview();
+	clearSelection();
+	switch (newformat) {
+	case eGlyph: { //Convert to glyph
+		fgr::glyph* made = new fgr::glyph;
+		takeGlyph(*made);
+		glyphArt.reset(made);
 		break;
 	}
+	case eShape: { //Convert to shape
+		fgr::shape* made = new fgr::shape;
+		takeShape(*made);
+		shapeArt.reset(made);
+		break;
+	}
+	case eGraphic: { //Convert to graphic
+		fgr::graphic* made = new fgr::graphic;
+		if (format == eAnimation) { //Only the first frame is kept
+			if (artShared())
+				*made = animArt->front();
+			else
+				made->swap(animArt.get()->front());
+		}
+		else {
+			//A new graphic starts out with one empty shape, which takes the art
+			takeShape(made->front());
+		}
+		graphicArt.reset(made);
+		subGraphicShape = made->begin();
+		break;
+	}
+	case eAnimation: { //Convert to animation
+		fgr::animation* made = new fgr::animation;
+		if (format == eGraphic) {
+			if (artShared())
+				made->front() = fgr::frame(*graphicArt);
+			else
+				made->front().swap(*graphicArt.get());
+		}
+		else {
+			//So does the first frame of a new animation
+			takeShape(made->front().front());
+		}
+		animArt.reset(made);
+		subGraphicShape = made->currentframe->begin();
+		break;
+	}
+	}
+	//Let go of the art in the old format (only the handle of the new one is kept)
+	switch (format) {
+	case eGlyph:		glyphArt.reset();		break;
+	case eShape:		shapeArt.reset();		break;
+	case eGraphic:		graphicArt.reset();		break;
+	case eAnimation:	animArt.reset();		break;
+	}
+	in_hand_vertex = NULL;
+	insertPreviewActive = false;
 	format = newformat;
 	while (filepath.back() != '.') {
 		filepath.pop_back();
 	}
 	filepath += associatedExtention(format);
 	configureLayout(format);
+	//Records point into the art as it was, so converting can't be undone
+	history.clear();
 	makechange();
 	return;
 }
@@ -913,33 +2111,244 @@ void editor::updateWindowName() const {
 //Be very careful - this function does not save any progress first. It's primary purpose
 //is to prevent memory leaks
 void editor::deleteAllArt() {
-	/*How this is handled depends on the editor type:
-	 *	Of the art pointers, only one corresponds to something that ever be
-	 *	deleted or copied. This is the highest-level art, or the one matching 'format.'
-	 *	The rest should be set to null rather than deleted, or re-found rather than
-	 *	copied.
-	 */
+	//Only the handle matching 'format' ever holds anything, but all of them are let go of.
+	//The art itself is only deleted once no other editor shares it.
+	glyphArt.reset();
+	shapeArt.reset();
+	graphicArt.reset();
+	animArt.reset();
+	clearSelection();
+	//Art that was put away goes too
+	awake = true;
+	spill.reset();
+	history.clear();
+	unsavedChanges = false;
+	//Whatever takes the art's place is new, so the grids and trees sorted from the old art are out of date
+	++revision;
+	return;
+}
+
+//Open a file without reading it yet
+bool editor::openLater(const std::string& path) {
+	editortype artform = interpretExtention(getExtention(path));
+	if (!artform || artform == eSpritesheet)
+		return false;
+	deleteAllArt();
+	filepath = path;
+	blankFile = false;
+	configureLayout(artform);
+	format = artform;
+	sleepingPlace.frame = 0;
+	sleepingPlace.shape = format == eGraphic || format == eAnimation ? 0 : NO_SHAPE;
+	awake = false;
+	return true;
+}
+
+//Open the file another tab has open, sharing its art
+void editor::openShared(const editor& other) {
+	deleteAllArt();
+	filepath = other.filepath;
+	blankFile = false;
+	configureLayout(other.format);
+	format = other.format;
+	glyphArt = other.glyphArt;
+	shapeArt = other.shapeArt;
+	graphicArt = other.graphicArt;
+	animArt = other.animArt;
+	if (format == eGraphic || format == eAnimation)
+		subGraphicShape = heldGraphic().begin();
+}
+
+//Put this tab's art away to save memory
+bool editor::sleep() {
+	if (!awake)
+		return true;
+	cancelInsertPreview();
+	in_hand_vertex = NULL;
+	//Art that isn't the same as a file on disk is written to a temporary one, and so is art with
+	//a history, since the file could change before it's brought back
+	if (unsavedChanges || blankFile || !history.empty()) {
+		FILE* sink = std::tmpfile();
+		if (!sink)
+			return false;
+		std::shared_ptr<FILE> kept(sink, std::fclose);
+		if (!writeArt(sink) || std::fflush(sink))
+			return false;
+		spill = kept;
+	}
+	sleepingPlace = currentPlace();
+	//The selection stays, but its vertices are found again in the art that's brought back
+	selectedPoints.clear();
+	selectedPointsArt = NULL;
+	glyphArt.reset();
+	shapeArt.reset();
+	graphicArt.reset();
+	animArt.reset();
+	awake = false;
+	return true;
+}
+
+//Bring back art that was put away, or read a file opened with openLater()
+bool editor::wake() {
+	if (awake)
+		return true;
+	FILE* source = NULL;
+	if (spill) {
+		source = spill.get();
+		std::rewind(source);
+	}
+	else {
+		fopen_s(&source, filepath.c_str(), "rb");
+	}
+	bool read = source && readArt(source);
+	if (source && !spill)
+		std::fclose(source);
+	//Like opening a file that isn't there, a tab whose art can't be read is left empty
+	if (!read)
+		emptyArt();
+	//Art that isn't exactly what was put away doesn't match the history's records or the selection
+	if (!read || !spill) {
+		history.clear();
+		clearSelection();
+		++revision;
+	}
+	spill.reset();
+	awake = true;
+	if (format == eGraphic || format == eAnimation) {
+		subGraphicShape = heldGraphic().begin();
+		select(sleepingPlace);
+	}
+	return read;
+}
+
+//Replace the art with art of the same format read from another file
+bool editor::recover(const std::string& path) {
+	FILE* source = NULL;
+	fopen_s(&source, path.c_str(), "rb");
+	if (!source)
+		return false;
+	cancelInsertPreview();
+	in_hand_vertex = NULL;
+	//Whatever was put away is replaced too
+	spill.reset();
+	awake = true;
+	clearSelection();
+	bool read = readArt(source);
+	std::fclose(source);
+	if (!read)
+		emptyArt();
+	//The history's records point into the art that was replaced
+	history.clear();
+	unsavedChanges = true;
+	blankFile = false;
+	++revision;
+	if (format == eGraphic || format == eAnimation) {
+		subGraphicShape = heldGraphic().begin();
+		artplace start;
+		start.frame = 0;
+		start.shape = 0;
+		select(start);
+	}
+	return read;
+}
+
+//Give this editor empty art of its format
+void editor::emptyArt() {
 	switch (format) {
-	case eAnimation:
-		if (format == eAnimation && animArt)
-			delete animArt;
-		animArt = NULL;
+	case eGlyph:		glyphArt.reset(new fgr::glyph);			break;
+	case eShape:		shapeArt.reset(new fgr::shape);			break;
+	case eGraphic:		graphicArt.reset(new fgr::graphic);		break;
+	case eAnimation:	animArt.reset(new fgr::animation);		break;
+	}
+}
+
+//Read art of this editor's format from a stream
+bool editor::readArt(FILE*& source) {
+	//The vertices found for the selection were in the art being replaced
+	selectedPoints.clear();
+	selectedPointsArt = NULL;
+	switch (format) {
+	case eGlyph:
+		glyphArt.reset(new fgr::glyph(fgr::fgetglyph(source)));
+		break;
+	case eShape:
+		shapeArt.reset(new fgr::shape(fgr::fgetshape(source)));
+		break;
 	case eGraphic:
-		if (format == eGraphic && graphicArt)
-			delete graphicArt;
-		graphicArt = NULL;
+		graphicArt.reset(new fgr::graphic(fgr::fgetgraphic(source)));
+		break;
+	case eAnimation:
+		animArt.reset(new fgr::animation(fgr::fgetanimation(source)));
+		break;
+	default:
+		return false;
+	}
+	return !std::ferror(source);
+}
+
+//Write this editor's art to a stream
+bool editor::writeArt(FILE*& sink) const {
+	switch (format) {
+	case eGlyph:
+		fgr::fputglyph(*glyphArt, sink);
+		break;
 	case eShape:
-		if (format == eShape && shapeArt)
-			delete shapeArt;
-		shapeArt = NULL;
+		fgr::fputshape(*shapeArt, sink);
+		break;
+	case eGraphic:
+		fgr::fputgraphic(*graphicArt, sink);
+		break;
+	case eAnimation:
+		fgr::fputanimation(*animArt, sink);
+		break;
+	default:
+		return false;
+	}
+	return !std::ferror(sink);
+}
+
+//Write the art to a file without making it this editor's file
+bool editor::saveCopy(const std::string& path) const {
+	if (!awake)
+		return false;
+	FILE* sink = NULL;
+	fopen_s(&sink, path.c_str(), "wb");
+	if (!sink)
+		return false;
+	bool written = writeArt(sink);
+	return std::fclose(sink) == 0 && written;
+}
+
+//Roughly how much memory a graphic takes up
+std::size_t editor::graphicBytes(const fgr::graphic& art) {
+	//Every vertex is a node of a std::list, with two links
+	std::size_t bytes = sizeof(fgr::graphic) + art.capacity() * sizeof(fgr::shape);
+	for (fgr::graphic::const_iterator itr = art.begin(); itr != art.end(); ++itr)
+		bytes += itr->size() * (sizeof(fgr::point) + 2 * sizeof(void*));
+	return bytes;
+}
+
+//Roughly how much memory this tab's art takes up
+std::size_t editor::artBytes() const {
+	const std::size_t vertex = sizeof(fgr::point) + 2 * sizeof(void*);
+	switch (format) {
 	case eGlyph:
-		if (format == eGlyph && glyphArt)
-			delete glyphArt;
-		glyphArt = NULL;
+		return glyphArt ? sizeof(fgr::glyph) + glyphArt->size() * vertex : 0;
+	case eShape:
+		return shapeArt ? sizeof(fgr::shape) + shapeArt->size() * vertex : 0;
+	case eGraphic:
+		return graphicArt ? graphicBytes(*graphicArt) : 0;
+	case eAnimation: {
+		if (!animArt)
+			return 0;
+		std::size_t bytes = sizeof(fgr::animation);
+		for (fgr::animation::const_iterator itr = animArt->begin(); itr != animArt->end(); ++itr)
+			bytes += graphicBytes(*itr) - sizeof(fgr::graphic) + sizeof(fgr::frame);
+		return bytes;
+	}
+	default:
+		return 0;
 	}
-	unsavedChanges = false;
-	assert(!(glyphArt || shapeArt || graphicArt || animArt) && "Bad logic - not all pointer nullified.");
-	return;
 }
 
 //Write the current artwork to a particular file path
@@ -1001,22 +2410,22 @@ bool editor::loadFile(const std::string& path) {
 	bool foundFile = true;
 	switch (artform) {
 	case eGlyph:
-		glyphArt = new fgr::glyph;
-		foundFile = fgr::glyphFromFile(*glyphArt, path);
+		glyphArt.reset(new fgr::glyph);
+		foundFile = fgr::glyphFromFile(glyphArt.write(), path);
 		break;
 	case eShape:
-		shapeArt = new fgr::shape;
-		foundFile = fgr::shapeFromFile(*shapeArt, path);
+		shapeArt.reset(new fgr::shape);
+		foundFile = fgr::shapeFromFile(shapeArt.write(), path);
 		break;
 	case eGraphic:
-		graphicArt = new fgr::graphic;
-		foundFile = fgr::graphicFromFile(*graphicArt, path);
-		subGraphicShape = currentGraphic().begin();
+		graphicArt.reset(new fgr::graphic);
+		foundFile = fgr::graphicFromFile(graphicArt.write(), path);
+		subGraphicShape = heldGraphic().begin();
 		break;
 	case eAnimation:
-		animArt = new fgr::animation;
-		foundFile = fgr::animationFromFile(*animArt, path);
-		subGraphicShape = currentGraphic().begin();
+		animArt.reset(new fgr::animation);
+		foundFile = fgr::animationFromFile(animArt.write(), path);
+		subGraphicShape = heldGraphic().begin();
 		break;
 	case eSpritesheet:
 
@@ -1105,7 +2514,11 @@ void editor::renderArt() const {
 			break;
 		case eGraphic:
 			if (experimentalFractalMode && currentGraphic().size() >= 2) {
-				fgr::draw(fgr::fractal(currentGraphic().front(), currentGraphic().back()), experimentalFractalIterations);
+				fgr::fractal pattern(currentGraphic().front(), currentGraphic().back());
+				if (experimentalFractalChaos)
+					renderChaosFractal(pattern, fgr::segment(LBound, BBound, RBound, TBound));
+				else
+					fgr::draw(pattern, experimentalFractalIterations);
 			}
 			else {
 				fgr::draw(*graphicArt);
@@ -1158,21 +2571,155 @@ void editor::renderArt() const {
 				glEnd();
 			}
 		}
+		//The selected vertices
+		if (!selected.empty()) {
+			const std::vector<fgr::point*>& dots = selectedVertices();
+			glPointSize(5.0f);
+			glColor3f(1.0f, 0.6f, 0.0f);
+			glBegin(GL_POINTS);
+				for (std::size_t i = 0; i < dots.size(); ++i)
+					glVertex2f(dots[i]->x(), dots[i]->y());
+			glEnd();
+		}
+		//The outline of a selection being dragged out
+		if (!selectionOutline.empty()) {
+			glLineWidth(1.0f);
+			glColor3f(1.0f, 0.6f, 0.0f);
+			glLineStipple(1, 0xF0F0);
+			glEnable(GL_LINE_STIPPLE);
+			glBegin(GL_LINE_LOOP);
+				if (lassoing) {
+					for (std::size_t i = 0; i < selectionOutline.size(); ++i)
+						glVertex2f(selectionOutline[i].x(), selectionOutline[i].y());
+				}
+				else {
+					const fgr::point& from = selectionOutline.front();
+					const fgr::point& to = selectionOutline.back();
+					glVertex2f(from.x(), from.y());
+					glVertex2f(to.x(), from.y());
+					glVertex2f(to.x(), to.y());
+					glVertex2f(from.x(), to.y());
+				}
+			glEnd();
+			glDisable(GL_LINE_STIPPLE);
+		}
 	glPopMatrix();
 }
 
-//Draw render an editor using OpenGL instructions
-void drawEditor(const editor& workbench) {
+//Draw a fractal with the chaos game over the visible part of the plane. The cloud is only
+//regenerated when the fractal, depth, point budget, view or pane size has changed.
+void editor::renderChaosFractal(const fgr::fractal& pattern, const fgr::segment& view) const {
+	std::size_t key = fgr::chaos::signature(pattern);
+	key = key * 31 + std::size_t(experimentalFractalIterations);
+	key = key * 31 + std::size_t(experimentalFractalPoints);
+	bool sameView = fgr::converges(fractalCloud.bounds.p1, view.p1) && fgr::converges(fractalCloud.bounds.p2, view.p2)
+		&& fractalCloud.width == centralPane().width && fractalCloud.height == centralPane().height;
+	if (key != fractalCloudKey || !sameView) {
+		fractalCloud.bounds = view;
+		fractalCloud.width = centralPane().width;
+		fractalCloud.height = centralPane().height;
+		fgr::chaosgame(pattern, experimentalFractalIterations, experimentalFractalPoints, fractalCloud);
+		fractalCloudKey = key;
+	}
+	fgr::draw(fractalCloud, pattern.color);
+}
+
+//The thumbnails the shapes pane will show this frame
+struct shapeThumbnailFrame {
+	//The range of visible shapes
+	int first;
+	int end;
+	//The atlas cell for each visible shape, or -1 if it must be drawn directly
+	std::vector<int> cells;
+	//How the graphic is fitted into each thumbnail
+	float boundscale;
+	fgr::point centre;
+};
+
+//Make sure every visible shape has an up-to-date thumbnail in the atlas. Missing ones are
+//rendered into the corner of the back buffer and copied out, so this must run before the
+//rest of the frame is drawn (the back buffer is cleared again afterwards).
+shapeThumbnailFrame prepareShapeThumbnails(const editor& workbench) {
+	shapeThumbnailFrame retf;
+	retf.first = retf.end = 0;
+	retf.boundscale = 1.0f;
+	//Only graphics (and animation frames) have a shapes pane
+	if (!workbench.showShapes)
+		return retf;
+	workbench.visibleShapeRows(retf.first, retf.end);
+	fgr::segment bounds = workbench.currentGraphic().bounds();
+	retf.boundscale = fmaxf(bounds.width(), bounds.height());
+	if (retf.boundscale <= 0.0f)
+		retf.boundscale = 1.0f;
+	retf.centre = bounds.midpoint();
+	int step = workbench.shapeThumbnailSize();
+	if (step <= 0 || step > thumbnailAtlas::ATLAS_SIZE) {
+		retf.cells.assign(std::max(0, retf.end - retf.first), -1);
+		return retf;
+	}
+	shapeThumbnails.beginFrame(step);
+	//Every thumbnail depends on how the whole graphic is fitted, as well as on its own shape
+	std::size_t framing = fgr::fingerprint(fgr::FINGERPRINT_SEED, float(step));
+	framing = fgr::fingerprint(framing, retf.boundscale);
+	framing = fgr::fingerprint(framing, retf.centre.x());
+	framing = fgr::fingerprint(framing, retf.centre.y());
+	GLfloat clearColor[4];
+	bool drewAny = false;
+	for (int i = retf.first; i < retf.end; ++i) {
+		const fgr::shape& subject = workbench.currentGraphic()[i];
+		std::size_t key = fgr::fingerprint(subject, framing);
+		int cell = shapeThumbnails.find(key);
+		if (cell < 0) {
+			cell = shapeThumbnails.claim(key);
+			if (cell >= 0) {
+				if (!drewAny) {
+					glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+					glViewport(0, 0, step, step);
+					glMatrixMode(GL_PROJECTION);
+					glLoadIdentity();
+					glOrtho(0, step, 0, step, -1.0f, 1.0f);
+					glMatrixMode(GL_MODELVIEW);
+					glEnable(GL_SCISSOR_TEST);
+					glScissor(0, 0, step, step);
+					glClearColor(workbench.shapesColor.getLevel('r'), workbench.shapesColor.getLevel('g'),
+						workbench.shapesColor.getLevel('b'), 1.0f);
+					drewAny = true;
+				}
+				glClear(GL_COLOR_BUFFER_BIT);
+				glLoadIdentity();
+				glTranslatef(step / 2.0f, step / 2.0f, 0.0f);
+				glScalef(step / retf.boundscale, step / retf.boundscale, 0);
+				glTranslatef(-retf.centre.x(), -retf.centre.y(), 0.0f);
+				fgr::draw(subject);
+				shapeThumbnails.capture(cell);
+			}
+		}
+		retf.cells.push_back(cell);
+	}
+	if (drewAny) {
+		glDisable(GL_SCISSOR_TEST);
+		glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+		glLoadIdentity();
+		ClearScreen();
+	}
+	return retf;
+}
+
+//Draw render an editor using OpenGL instructions (with the session directory it shows in the file tree)
+void drawEditor(const editor& workbench, const std::string& session = sessionFilePath) {
+	//The central editor's time is counted on its own, and taken out of the panels'
+	perf::timer timing(perf::pPanels);
 	glLineWidth(1.0f);
 	void* fontNum = GLUT_BITMAP_HELVETICA_18;
+	shapeThumbnailFrame thumbnails = prepareShapeThumbnails(workbench);
 	
 
 	//Draw the File Tree
 	if (workbench.showFileTree) {
 		fgr::setcolor(workbench.fileTreeColor);
 		setViewport(workbench.fileTreePane());
-		if (sessionFilePath.size()) {
-			for (char c : sessionFilePath)
+		if (session.size()) {
+			for (char c : session)
 				glutBitmapCharacter(fontNum, c);
 		}
 		else {
@@ -1208,50 +2755,54 @@ void drawEditor(const editor& workbench) {
 		setViewport(workbench.shapesPane());
 		int margin = workbench.margin;
 		int spacing = workbench.spacing;
-		int paneWidth = workbench.shapesPane().width;
-		int step = paneWidth - 2 * margin;
-		float boundscale = fmaxf(workbench.currentGraphic().bounds().width(),
-			workbench.currentGraphic().bounds().height());
-		fgr::point centre = workbench.currentGraphic().bounds().midpoint();
+		int step = workbench.shapeThumbnailSize();
 		glMatrixMode(GL_MODELVIEW);
 		glPushMatrix();
+			//Only the visible rows are drawn, starting from the first one in view
 			glTranslatef(workbench.shapesPane().left() + margin, 
-				workbench.shapesPane().top() - margin, 0);
-			//Draw every current shape
-			for (fgr::graphicContainer::iterator itr = workbench.currentGraphic().begin();
-				itr != workbench.currentGraphic().end(); ++itr) {
-				//Draw the shape
-				glPushMatrix();
-					glTranslatef(paneWidth / 2 - margin - 1, - step / 2, 0.0f);
-					glScalef((paneWidth - 2 * margin) / boundscale,
-						(paneWidth - 2 * margin) / boundscale, 0);
-					glTranslatef(-centre.x(), -centre.y(), 0.0f);
-					fgr::draw(*itr);
-				glPopMatrix();
+				workbench.shapesPane().top() - margin + workbench.shapesScroll
+				- thumbnails.first * workbench.shapeRowStep(), 0);
+			for (int i = thumbnails.first; i < thumbnails.end; ++i) {
+				const fgr::shape& subject = workbench.currentGraphic()[i];
+				//Draw the shape, from the atlas if it made it in there
+				int cell = thumbnails.cells[i - thumbnails.first];
+				if (cell >= 0) {
+					shapeThumbnails.draw(cell, -1.0f, -float(step) - 1.0f, float(step) - 1.0f, -1.0f);
+				}
+				else {
+					glPushMatrix();
+						glTranslatef(step / 2 - 1, - step / 2, 0.0f);
+						glScalef(step / thumbnails.boundscale, step / thumbnails.boundscale, 0);
+						glTranslatef(-thumbnails.centre.x(), -thumbnails.centre.y(), 0.0f);
+						fgr::draw(subject);
+					glPopMatrix();
+				}
 				//Draw the outline
 				glLineWidth(1.0f);
 				glColor3f(0.0f, 0.0f, 0.0f);
-				if (itr == workbench.subGraphicShape) {
+				if (workbench.currentGraphic().begin() + i == workbench.subGraphicShape) {
 					glColor3f(0.0f, 0.5f, 1.0f);
 					glLineWidth(2.0f);
 				}
 				glBegin(GL_LINE_LOOP);
 					glVertex2i(-1, -1);
-					glVertex2i(paneWidth - 2 * margin, -1);
-					glVertex2i(paneWidth - 2 * margin, -(step) - 1);
+					glVertex2i(step, -1);
+					glVertex2i(step, -(step) - 1);
 					glVertex2i(-1, -(step) - 1);
 				glEnd();
 				glTranslatef(0.0f, - (step + spacing), 0.0f);
 			}
-			//The 'add shape' button
-			glLineWidth(1.0f);
-			glColor3f(0.0f, 0.0f, 0.0f);
-			glBegin(GL_LINE_LOOP);
-				glVertex2i(0, 0);
-				glVertex2i(workbench.shapesPane().width - 2 * margin, 0);
-				glVertex2i(workbench.shapesPane().width - 2 * margin, -(20 + margin));
-				glVertex2i(0, -(20 + margin));
-			glEnd();
+			//The 'add shape' button, once the list has been scrolled to the end
+			if (thumbnails.end == int(workbench.currentGraphic().size())) {
+				glLineWidth(1.0f);
+				glColor3f(0.0f, 0.0f, 0.0f);
+				glBegin(GL_LINE_LOOP);
+					glVertex2i(0, 0);
+					glVertex2i(step, 0);
+					glVertex2i(step, -(20 + margin));
+					glVertex2i(0, -(20 + margin));
+				glEnd();
+			}
 		glPopMatrix();
 	}
 	//Draw the Shape Properties
@@ -1291,6 +2842,7 @@ void drawEditor(const editor& workbench) {
 	//DP: Supposed to draw eee
 	//Draw the central editor
 	if (true) {
+		perf::timer artTiming(perf::pArt);
 		glPushMatrix();
 			setViewport(workbench.centralPane(), false);
 			//Apply base transformations
@@ -1304,6 +2856,11 @@ void drawEditor(const editor& workbench) {
 				+ "\nZoom - " + std::to_string(workbench.zoom) 
 				+ "\nPan - " + workbench.pan.label()
 				+ "\nTool - " + std::to_string(workbench.currentTool));
+			if (!workbench.selected.empty())
+				label += "\nSelected - " + std::to_string(workbench.selected.size());
+			if (workbench.experimentalFractalMode && workbench.experimentalFractalChaos)
+				label += "\nChaos - " + std::to_string(workbench.fractalCloud.pointCount) + " points, "
+					+ std::to_string(workbench.fractalCloud.megapointsPerSecond()) + " Mpts/s";
 			for (char c : label)
 				glutBitmapCharacter(fontNum, c);
 		glPopMatrix();
@@ -0,0 +1,493 @@
+/* This header file lets Glimmer do work without ever opening a window, for use on
+ * machines with no display. Run as:
+ *     Glimmer --bench <file> [width height repetitions]
+ * to draw a file with the software renderer (directly, then through a command list) and
+ * report how long it took,
+ *     Glimmer --bench-painting [file.fpg | components] [repetitions]
+ * to time instancing a painting (by default one made up of 1000 components), or
+ *     Glimmer --export <file> <png-file> <width> <height>
+ * to export it as an anti-aliased PNG, or
+ *     Glimmer --export <file> <gif-file> <width> <height> [ticks-per-second]
+ * to export every frame of it as an animated GIF, or
+ *     Glimmer --bake-atlas <file> <atlas-file> <pixels-per-unit> [more pixels-per-unit...]
+ * to bake every frame of it into texture atlases ahead of time, for the game to load, or
+ *     Glimmer --check-gif
+ * to check that what the GIF writer compresses reads back the same, or
+ *     Glimmer --check-snap
+ * to check that vertices snap to the edges each drawing mode draws, and no others. */
+#pragma once
+
+#ifndef __headless_h__
+#define __headless_h__
+
+#include "fgrutils.h"
+#include "snapping.h"
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <initializer_list>
+#include <chrono>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+
+//Load any fgr file as a sequence of frames (paintings are loaded into 'scene' instead).
+//Returns false if the file couldn't be loaded.
+bool loadHeadless(const std::string& path, fgr::animation& frames, fgr::painting& scene) {
+	bool loaded = false;
+	//Both start out holding one blank piece of art
+	frames.clear();
+	scene.clear();
+	std::string ext = getExtention(path);
+	if (ext == "fgl") {
+		fgr::glyph art;
+		loaded = fgr::glyphFromFile(art, path);
+		frames.push_back(fgr::frame(fgr::graphic(fgr::shape(art))));
+	}
+	else if (ext == "fsh") {
+		fgr::shape art;
+		loaded = fgr::shapeFromFile(art, path);
+		frames.push_back(fgr::frame(fgr::graphic(art)));
+	}
+	else if (ext == "fgr") {
+		fgr::graphic art;
+		loaded = fgr::graphicFromFile(art, path);
+		frames.push_back(fgr::frame(art));
+	}
+	else if (ext == "fan") {
+		loaded = fgr::animationFromFile(frames, path);
+	}
+	else if (ext == "fpg") {
+		loaded = fgr::paintingFromFile(scene, path);
+	}
+	frames.currentframe = frames.begin();
+	if (!loaded)
+		printf("Could not load \"%s\".\n", path.c_str());
+	return loaded;
+}
+
+//Load any fgr file, draw it repeatedly with the software renderer and print the timings.
+//Returns the process exit code.
+int headlessBenchmark(int argc, char** argv) {
+	if (argc < 3) {
+		printf("Usage: %s --bench <file> [width height repetitions]\n", argv[0]);
+		return 1;
+	}
+	std::string path(argv[2]);
+	int width = argc > 4 ? atoi(argv[3]) : 1920;
+	int height = argc > 4 ? atoi(argv[4]) : 1080;
+	int repetitions = argc > 5 ? atoi(argv[5]) : 10;
+	if (width <= 0 || height <= 0 || repetitions <= 0) {
+		printf("Width, height and repetitions must all be positive.\n");
+		return 1;
+	}
+	//Everything is loaded as an animation, so frames can be drawn one after another
+	fgr::animation frames;
+	fgr::painting scene;
+	if (!loadHeadless(path, frames, scene))
+		return 1;
+	//Fit the view around the art (paintings move about, so they get a fixed view)
+	fgr::segment bounds(1e30f, 1e30f, -1e30f, -1e30f);
+	for (fgr::animation::const_iterator itr = frames.begin(); itr != frames.end(); ++itr) {
+		fgr::segment box = fgr::vertexBounds(*itr);
+		bounds = fgr::segment(fminf(bounds.p1.x(), box.p1.x()), fminf(bounds.p1.y(), box.p1.y()),
+			fmaxf(bounds.p2.x(), box.p2.x()), fmaxf(bounds.p2.y(), box.p2.y()));
+	}
+	fgr::segment view = fgr::fitView(bounds, width, height, 0.0f);
+	fgr::softrenderer canvas(width, height, view);
+	std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+	unsigned long fragments = 0;
+	unsigned long primitives = 0;
+	for (int rep = 0; rep < repetitions; ++rep) {
+		canvas.clear(fgr::fcolor(0.0f, 0.0f, 0.0f, 1.0f));
+		for (fgr::animation::const_iterator itr = frames.begin(); itr != frames.end(); ++itr)
+			fgr::draw((const fgr::graphic&)*itr, canvas);
+		fgr::draw(scene, canvas);
+		fragments += canvas.fragments;
+		primitives += canvas.primitives;
+	}
+	float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started).count();
+	float perRep = milliseconds / repetitions;
+	printf("%s: %d x %d, %d repetitions\n", path.c_str(), width, height, repetitions);
+	printf("  %.3f ms per repetition, %lu primitives and %lu pixels written per repetition\n",
+		perRep, primitives / repetitions, fragments / repetitions);
+	printf("  %.2f megapixels per second\n", perRep > 0.0f ? float(width) * height / (perRep * 1000.0f) : 0.0f);
+	//The same again, recorded once into a command list, batched, and replayed
+	started = std::chrono::steady_clock::now();
+	fgr::commandlist list;
+	list.setPixelSize(view.width() / width);
+	for (fgr::animation::const_iterator itr = frames.begin(); itr != frames.end(); ++itr)
+		fgr::draw((const fgr::graphic&)*itr, list);
+	fgr::draw(scene, list);
+	std::size_t recorded = list.size();
+	list.optimize();
+	float recording = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started).count();
+	started = std::chrono::steady_clock::now();
+	fgr::replayreport replayed;
+	for (int rep = 0; rep < repetitions; ++rep) {
+		canvas.clear(fgr::fcolor(0.0f, 0.0f, 0.0f, 1.0f));
+		replayed = list.replay(canvas);
+	}
+	perRep = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started).count() / repetitions;
+	printf("  command list: recorded and batched in %.3f ms, %u draws into %u\n", recording,
+		unsigned(recorded), unsigned(replayed.draws));
+	printf("  %.3f ms per replay, %u state changes per replay\n", perRep, unsigned(replayed.stateChanges));
+	return 0;
+}
+
+//A painting of many components scattered about and oscillating, drawn from a few pieces of art
+//(layered: every copy of one piece, then every copy of the next)
+fgr::painting benchmarkPainting(std::size_t components) {
+	std::vector<fgr::animation> pieces;
+	//A filled hexagon with an outline
+	fgr::graphic hexagon;
+	hexagon.clear();
+	fgr::shape fill(fgr::glyph(fgr::glPolygon, fgr::glyphContainer()), fgr::fcolor(0.9f, 0.6f, 0.2f, 1.0f), 1.0f, 1.0f);
+	fgr::shape outline(fgr::glyph(fgr::glLineLoop, fgr::glyphContainer()), fgr::fcolor(0.2f, 0.1f, 0.0f, 1.0f), 2.0f, 1.0f);
+	for (int i = 0; i < 6; ++i) {
+		fgr::point corner(cosf(i * fgr::PI / 3.0f), sinf(i * fgr::PI / 3.0f));
+		fill.push_back(corner);
+		outline.push_back(corner);
+	}
+	hexagon.push_back(fill);
+	hexagon.push_back(outline);
+	pieces.push_back(fgr::animation());
+	pieces.back().front() = fgr::frame(hexagon);
+	//A two-frame flickering star of lines
+	fgr::animation star;
+	star.clear();
+	for (int f = 0; f < 2; ++f) {
+		fgr::shape rays(fgr::glyph(fgr::glLines, fgr::glyphContainer()), fgr::fcolor(1.0f, 1.0f, 0.5f * f, 1.0f), 2.0f, 1.0f);
+		for (int i = 0; i < 8; ++i) {
+			rays.push_back(fgr::point(0.0f, 0.0f));
+			rays.push_back(fgr::point(cosf(i * fgr::PI / 4.0f + f * 0.2f), sinf(i * fgr::PI / 4.0f + f * 0.2f)));
+		}
+		star.push_back(fgr::frame(fgr::graphic(rays)));
+		star.back().delay = 5;
+	}
+	star.currentframe = star.begin();
+	pieces.push_back(star);
+	//A fan of triangles
+	fgr::shape fan(fgr::glyph(fgr::glTriangleFan, fgr::glyphContainer()), fgr::fcolor(0.3f, 0.5f, 1.0f, 0.8f), 1.0f, 1.0f);
+	fan.push_back(fgr::point(0.0f, 0.0f));
+	for (int i = 0; i <= 12; ++i)
+		fan.push_back(fgr::point(cosf(i * fgr::PI / 12.0f), sinf(i * fgr::PI / 12.0f)));
+	pieces.push_back(fgr::animation(fan));
+	fgr::painting scene;
+	scene.framerate = 60.0f;
+	unsigned int seed = 12345;
+	for (std::size_t i = 0; i < components; ++i) {
+		fgr::component piece(pieces[i * pieces.size() / components]);
+		seed = seed * 1103515245u + 12345u;
+		piece.position = fgr::point(float(seed % 2000) - 1000.0f, float((seed >> 11) % 2000) - 1000.0f);
+		piece.scale = 10.0f + float((seed >> 7) % 20);
+		piece.posfreq = fgr::point(0.1f + float(seed % 7) * 0.1f, 0.2f);
+		piece.posamp = fgr::point(20.0f, 10.0f);
+		piece.rotfreq = float(seed % 3) * 0.25f;
+		piece.scalefreq = 0.5f;
+		piece.scaleamp = 2.0f;
+		scene.push_back(piece);
+	}
+	return scene;
+}
+
+//Time instancing a painting (see fgrinstance.h) from a file or made up, and print what it took.
+//Returns the process exit code.
+int headlessPaintingBenchmark(int argc, char** argv) {
+	fgr::painting scene;
+	std::string source = argc > 2 ? argv[2] : "1000";
+	if (getExtention(source) == "fpg") {
+		if (!fgr::paintingFromFile(scene, source)) {
+			printf("Could not load \"%s\".\n", source.c_str());
+			return 1;
+		}
+	}
+	else
+		scene = benchmarkPainting(std::size_t(std::max(1, atoi(source.c_str()))));
+	int repetitions = argc > 3 ? atoi(argv[3]) : 600;
+	if (repetitions <= 0) {
+		printf("Repetitions must be positive.\n");
+		return 1;
+	}
+	std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+	std::vector<std::shared_ptr<fgr::vertexart> > art = fgr::shareArt(scene);
+	float buildMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started).count();
+	std::size_t sharedBytes = 0, unsharedBytes = 0;
+	std::vector<const fgr::vertexart*> counted;
+	for (std::size_t i = 0; i < art.size(); ++i) {
+		unsharedBytes += art[i]->bytes();
+		if (std::find(counted.begin(), counted.end(), art[i].get()) == counted.end()) {
+			counted.push_back(art[i].get());
+			sharedBytes += art[i]->bytes();
+		}
+	}
+	//Every frame: work out the instance buffer, then stream every component through it
+	std::vector<fgr::affine> instances(scene.size());
+	std::vector<fgr::colorvertex> vertices;
+	std::vector<fgr::vertexrun> runs;
+	fgr::instancebatch batch;
+	started = std::chrono::steady_clock::now();
+	for (int rep = 0; rep < repetitions; ++rep) {
+		double seconds = rep / 60.0;
+		for (std::size_t i = 0; i < scene.size(); ++i)
+			instances[i] = fgr::pose(scene[i], seconds);
+		batch.clear();
+		for (std::size_t i = 0; i < scene.size(); ++i) {
+			std::size_t frame = art[i]->frames.empty() ? 0 : (rep / 6) % art[i]->frames.size();
+			batch.append(*art[i], frame, instances[i]);
+		}
+		batch.finish(vertices, runs);
+	}
+	float perFrame = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started).count() / repetitions;
+	printf("Painting of %u components (%u distinct pieces of art), %d frames\n", unsigned(scene.size()),
+		unsigned(counted.size()), repetitions);
+	printf("  art flattened in %.3f ms: %u bytes shared (%u bytes if every component had its own copy)\n",
+		buildMilliseconds, unsigned(sharedBytes), unsigned(unsharedBytes));
+	printf("  %.3f ms per frame to place and stream %u vertices\n", perFrame, unsigned(vertices.size()));
+	printf("  %u draw calls per frame (%u if every component were drawn by itself)\n",
+		unsigned(runs.size()), unsigned(batch.gathered()));
+	return 0;
+}
+
+//Export the first frame of any fgr file as an anti-aliased PNG (or all of them as a GIF) and print
+//how long it took. Returns the process exit code.
+int headlessExport(int argc, char** argv) {
+	if (argc < 6) {
+		printf("Usage: %s --export <file> <png-file> <width> <height>\n", argv[0]);
+		printf("       %s --export <file> <gif-file> <width> <height> [ticks-per-second]\n", argv[0]);
+		return 1;
+	}
+	int width = atoi(argv[4]);
+	int height = atoi(argv[5]);
+	if (width <= 0 || height <= 0) {
+		printf("Width and height must both be positive.\n");
+		return 1;
+	}
+	fgr::animation frames;
+	fgr::painting scene;
+	if (!loadHeadless(argv[2], frames, scene))
+		return 1;
+	if (!frames.size()) {
+		printf("Only glyphs, shapes, graphics and animations can be exported.\n");
+		return 1;
+	}
+	if (getExtention(argv[3]) == "gif") {
+		float ticksPerSecond = argc > 6 ? float(atof(argv[6])) : 60.0f;
+		fgr::animreport report;
+		if (!fgr::exportAnimation(frames, std::string(), argv[3], width, height, ticksPerSecond, 1.0f, report)) {
+			printf("Could not write \"%s\".\n", argv[3]);
+			return 1;
+		}
+		printf("%s: %u frames at %d x %d in %.3f ms\n", argv[3], unsigned(report.frames), width, height, report.milliseconds);
+		return 0;
+	}
+	fgr::rasterreport report;
+	if (!fgr::exportPNG(frames.front(), argv[3], width, height, 1.0f, report)) {
+		printf("Could not write \"%s\".\n", argv[3]);
+		return 1;
+	}
+	printf("%s: %d x %d in %.3f ms (%.2f megapixels per second), %u tiles, %u polygon-tile pairs\n", argv[3],
+		width, height, report.milliseconds, report.megapixelsPerSecond(width, height),
+		unsigned(report.tiles), unsigned(report.binned));
+	return 0;
+}
+
+//Bake every frame of any fgr file (every component's, for paintings) into texture atlases at some
+//scales, save them, and print how well they packed. Returns the process exit code.
+int headlessBakeAtlas(int argc, char** argv) {
+	if (argc < 5) {
+		printf("Usage: %s --bake-atlas <file> <atlas-file> <pixels-per-unit> [more pixels-per-unit...]\n", argv[0]);
+		return 1;
+	}
+	std::vector<float> scales;
+	for (int i = 4; i < argc; ++i) {
+		float scale = float(atof(argv[i]));
+		if (!(scale > 0.0f)) {
+			printf("Scales must all be positive.\n");
+			return 1;
+		}
+		scales.push_back(scale);
+	}
+	fgr::animation frames;
+	fgr::painting scene;
+	if (!loadHeadless(argv[2], frames, scene))
+		return 1;
+	fgr::atlascache cache;
+	std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+	cache.bake(frames, scales);
+	for (fgr::painting::const_iterator itr = scene.begin(); itr != scene.end(); ++itr)
+		cache.bake(*itr, scales);
+	float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started).count();
+	if (!cache.save(argv[3])) {
+		printf("Could not write \"%s\".\n", argv[3]);
+		return 1;
+	}
+	const std::map<int, std::shared_ptr<fgr::textureatlas> >& atlases = cache.atlases();
+	for (std::map<int, std::shared_ptr<fgr::textureatlas> >::const_iterator itr = atlases.begin(); itr != atlases.end(); ++itr) {
+		printf("%g pixels per unit: %u frames on %u pages, %.1f%% full\n", itr->second->pixelsPerUnit(),
+			unsigned(itr->second->frameCount()), unsigned(itr->second->pageCount()), itr->second->occupancy() * 100.0f);
+	}
+	printf("%s: %.1f KB in %.3f ms\n", argv[3], cache.bytes() / 1024.0f, milliseconds);
+	return 0;
+}
+
+//Compress noise of every length up to just past a full code table with the GIF writer's LZW and read
+//it back, so every place the codes can widen or the table can fill is hit at the very end of
+//the data somewhere. Returns the process exit code.
+int headlessCheckGif(int argc, char** argv) {
+	//How much of this noise it takes to fill the table once (and a little more), by code size
+	const std::size_t filled[] = { 20000, 13000, 9500, 7500, 5700, 4600, 4200 };
+	std::size_t checked = 0, failed = 0;
+	for (int minCodeSize = 2; minCodeSize <= 8; ++minCodeSize) {
+		std::vector<unsigned char> noise(filled[minCodeSize - 2]);
+		std::uint32_t state = 12345u + minCodeSize;
+		for (std::size_t i = 0; i < noise.size(); ++i) {
+			state = state * 1664525u + 1013904223u;
+			noise[i] = (unsigned char)((state >> 16) & ((1u << minCodeSize) - 1));
+		}
+		std::vector<unsigned char> indices, compressed, back;
+		for (std::size_t length = 0; length <= noise.size(); ++length) {
+			indices.assign(noise.begin(), noise.begin() + length);
+			compressed.clear();
+			fgr::gif::compress(indices, minCodeSize, compressed);
+			++checked;
+			if (!fgr::gif::decompress(compressed, back) || back != indices) {
+				if (!failed)
+					printf("%d-bit codes, %u indices: read back wrong\n", minCodeSize, unsigned(length));
+				++failed;
+			}
+		}
+	}
+	printf("%u of %u round trips read back the same\n", unsigned(checked - failed), unsigned(checked));
+	return failed ? 1 : 0;
+}
+
+//The sides of every primitive a glyph of 'count' vertices draws in a mode, as pairs of vertices
+std::vector<std::pair<std::size_t, std::size_t> > drawnSides(fgr::GLmode mode, std::size_t count) {
+	std::vector<std::pair<std::size_t, std::size_t> > sides;
+	auto outline = [&](std::initializer_list<std::size_t> corners) {
+		std::vector<std::size_t> at(corners);
+		for (std::size_t i = 0; i < at.size(); ++i)
+			sides.push_back(std::make_pair(at[i], at[(i + 1) % at.size()]));
+	};
+	switch (mode) {
+	case fgr::glPoints:
+		break;
+	case fgr::glLines:
+		for (std::size_t i = 0; i + 1 < count; i += 2)
+			sides.push_back(std::make_pair(i, i + 1));
+		break;
+	case fgr::glLineLoop:
+	case fgr::glPolygon:
+		if (count < 3) {
+			if (count == 2 && mode == fgr::glLineLoop)
+				sides.push_back(std::make_pair(0, 1));
+			break;
+		}
+		for (std::size_t i = 0; i < count; ++i)
+			sides.push_back(std::make_pair(i, (i + 1) % count));
+		break;
+	case fgr::glTriangles:
+		for (std::size_t i = 0; i + 2 < count; i += 3)
+			outline({ i, i + 1, i + 2 });
+		break;
+	case fgr::glTriangleStrip:
+		for (std::size_t i = 0; i + 2 < count; ++i)
+			outline({ i, i + 1, i + 2 });
+		break;
+	case fgr::glTriangleFan:
+		for (std::size_t i = 1; i + 1 < count; ++i)
+			outline({ 0, i, i + 1 });
+		break;
+	case fgr::glQuads:
+		for (std::size_t i = 0; i + 3 < count; i += 4)
+			outline({ i, i + 1, i + 2, i + 3 });
+		break;
+	case fgr::glQuadStrip:
+		for (std::size_t i = 0; i + 3 < count; i += 2)
+			outline({ i, i + 1, i + 3, i + 2 });
+		break;
+	default:
+		for (std::size_t i = 0; i + 1 < count; ++i)
+			sides.push_back(std::make_pair(i, i + 1));
+		break;
+	}
+	return sides;
+}
+
+//Check, for every pair of a glyph's vertices, that a point halfway between them snaps to the edge
+//between them if and only if the glyph draws one there. Returns how many pairs were wrong.
+std::size_t checkDrawnEdges(const edgegrid& grid, const fgr::glyph& art) {
+	std::vector<fgr::point> at(art.begin(), art.end());
+	std::vector<std::pair<std::size_t, std::size_t> > sides = drawnSides(art.mode, at.size());
+	std::size_t wrong = 0;
+	for (std::size_t a = 0; a < at.size(); ++a) {
+		for (std::size_t b = a + 1; b < at.size(); ++b) {
+			bool drawn = false;
+			for (std::size_t i = 0; i < sides.size(); ++i)
+				drawn = drawn || sides[i] == std::make_pair(a, b) || sides[i] == std::make_pair(b, a);
+			fgr::point middle((at[a].x() + at[b].x()) / 2.0f, (at[a].y() + at[b].y()) / 2.0f), found;
+			//Nothing is left out: the vertex skipped is in a shape that isn't there
+			bool snapped = grid.nearest(middle, 1.0e-4f, makeVertexKey(1, 0), found);
+			if (snapped != drawn)
+				++wrong;
+		}
+	}
+	return wrong;
+}
+
+//Build edge grids of glyphs of every drawing mode and size up to a few primitives, both at once and
+//one vertex at a time, moving every vertex once, and check each snaps to just the edges drawn.
+//Returns the process exit code.
+int headlessCheckSnap(int argc, char** argv) {
+	const fgr::GLmode modes[] = { fgr::glPoints, fgr::glLines, fgr::glLineLoop, fgr::glLineStrip, fgr::glTriangles,
+		fgr::glTriangleStrip, fgr::glTriangleFan, fgr::glQuads, fgr::glQuadStrip, fgr::glPolygon };
+	//Vertices around a circle, unevenly, so no edge runs through the middle of another pair
+	auto around = [](std::size_t i, float radius) {
+		float angle = 0.5f * float(i) + 0.015f * float(i * i);
+		fgr::point made;
+		made.x(radius * std::cos(angle));
+		made.y(radius * std::sin(angle));
+		return made;
+	};
+	std::size_t checked = 0, failed = 0;
+	for (std::size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+		for (std::size_t count = 0; count <= 10; ++count) {
+			fgr::glyph art(modes[m], fgr::glyphContainer());
+			for (std::size_t i = 0; i < count; ++i)
+				art.push_back(around(i, 1.0f));
+			edgegrid whole;
+			whole.build(art);
+			std::size_t wrong = checkDrawnEdges(whole, art);
+			//Made a vertex at a time, then with each vertex moved
+			fgr::glyph growing(modes[m], fgr::glyphContainer());
+			edgegrid kept;
+			kept.build(growing);
+			for (std::size_t i = 0; i < count; ++i) {
+				growing.push_back(around(i, 1.0f));
+				kept.append(0, growing.back());
+				wrong += checkDrawnEdges(kept, growing);
+			}
+			fgr::glyph::iterator vertex = growing.begin();
+			for (std::size_t i = 0; i < count; ++i, ++vertex) {
+				*vertex = around(i, 2.0f);
+				kept.move(makeVertexKey(0, i), *vertex);
+			}
+			wrong += checkDrawnEdges(kept, growing);
+			++checked;
+			if (wrong) {
+				if (!failed)
+					printf("Mode %d with %u vertices: %u pairs snapped wrong\n", int(modes[m]), unsigned(count), unsigned(wrong));
+				++failed;
+			}
+		}
+	}
+	printf("%u of %u glyphs snapped to just the edges drawn\n", unsigned(checked - failed), unsigned(checked));
+	return failed ? 1 : 0;
+}
+
+#endif
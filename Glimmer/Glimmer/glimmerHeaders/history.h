@@ -0,0 +1,206 @@
+/* This header file defines the undo history of an editor. Rather than copying all of the art
+ * every time something changes, each change is written down as a small record of what it did
+ * (a vertex moved, inserted or erased, a glyph cleared, a shape added, taken away or restyled)
+ * holding only what it touched. Records are grouped into steps, one per thing the user did,
+ * and undoing or redoing a step plays its records backward or forward, which costs about as
+ * much as making the change did. Everything done during one drag lands in the same step, so
+ * a whole drag or brush stroke is undone at once. Once the history takes up more memory than
+ * it's allowed, the oldest steps are forgotten. */
+#pragma once
+
+#ifndef __history_h__
+#define __history_h__
+
+#include "fgrutils.h"
+#include "selection.h"
+
+#include <deque>
+#include <vector>
+#include <cstddef>
+
+//Stands in for a shape index when the art is a single glyph or shape
+const std::size_t NO_SHAPE = std::size_t(-1);
+
+//How much memory each editor's history may take up, in bytes (set with :undolimit)
+std::size_t undoMemoryLimit = 64 * 1024 * 1024;
+
+//Where in an editor's art a change happened
+struct artplace {
+	//Which frame of an animation (0 for any other art)
+	std::size_t frame;
+	//Which shape of the graphic (NO_SHAPE if the art is a single glyph or shape)
+	std::size_t shape;
+	bool operator==(const artplace& other) const {
+		return frame == other.frame && shape == other.shape;
+	}
+};
+
+//One change to an editor's art, with enough written down to take it back
+class artedit {
+public:
+	//The kinds of change there are
+	enum kind { kMoveVertex, kInsertVertex, kEraseVertex, kClearGlyph, kInsertShape, kEraseShape, kRestyle,
+		kTransformVertices, kEraseVertices };
+	kind what;
+	//The glyph or shape that changed (for kInsertShape and kEraseShape, where the shape went or was)
+	artplace place;
+	//Which vertex changed, counting from the start of the glyph
+	std::size_t index;
+	//Where the vertex was before, and after (an inserted vertex only has an after, an erased one only a before)
+	fgr::point before;
+	fgr::point after;
+	//The vertices a clear took away (while it's done; they go back into the glyph when it's undone)
+	fgr::glyphContainer points;
+	//A shape that was added or taken away, or the style a shape had before it was restyled (without vertices)
+	fgr::shape subject;
+	//The style a shape was given (without vertices)
+	fgr::shape restyled;
+	//The vertices a transform moved or an erase took away (all in place.frame), and where they
+	//were before, as x and y one after the other in the order of their keys
+	indexset vertices;
+	std::vector<float> coordinates;
+	//What a transform did to them (every drag event of one drag folds into this)
+	fgr::affine transform;
+
+	//True if this change adds or takes away vertices or shapes, so the indices of others change
+	bool movesIndices() const {
+		return what != kMoveVertex && what != kRestyle && what != kTransformVertices;
+	}
+	//Roughly how much memory this record takes up, in bytes
+	std::size_t bytes() const {
+		//Every vertex of a std::list is a node with two links
+		return sizeof(artedit) + (points.size() + subject.size()) * (sizeof(fgr::point) + 2 * sizeof(void*))
+			+ vertices.bytes() + coordinates.capacity() * sizeof(float);
+	}
+};
+
+//The steps that can be undone and redone in one editor
+class edithistory {
+public:
+	// CONSTRUCTORS
+	//Default constructor
+	edithistory() {
+		limit = undoMemoryLimit;
+		used = 0;
+		open = false;
+	}
+
+	// FUNCTIONS
+	//Write down a change as part of the step being made (starting one if there isn't one).
+	//Anything that could have been redone is forgotten.
+	void record(const artedit& change) {
+		dropFuture();
+		if (open && !past.empty() && coalesce(past.back().edits.back(), change))
+			return;
+		if (!open || past.empty()) {
+			past.push_back(step());
+			open = true;
+		}
+		past.back().edits.push_back(change);
+		std::size_t size = change.bytes();
+		past.back().bytes += size;
+		used += size;
+		trim();
+	}
+	//The last record of the step being made, to fold another change of the same kind into it
+	//(NULL if no step is being made)
+	artedit* lastOpen() {
+		if (!open || past.empty() || past.back().edits.empty())
+			return NULL;
+		return &past.back().edits.back();
+	}
+	//Finish the step being made, so the next change starts a step of its own
+	void seal() {
+		open = false;
+	}
+	//Forget every step
+	void clear() {
+		past.clear();
+		future.clear();
+		used = 0;
+		open = false;
+	}
+	//Take the last step made off the past and keep it for redoing. Returns its records, to be
+	//played backward, or NULL if there's nothing to undo.
+	std::vector<artedit>* undo() {
+		open = false;
+		if (past.empty())
+			return NULL;
+		future.push_back(step());
+		future.back().edits.swap(past.back().edits);
+		future.back().bytes = past.back().bytes;
+		past.pop_back();
+		return &future.back().edits;
+	}
+	//Take the last step undone and put it back on the past. Returns its records, to be played
+	//forward, or NULL if there's nothing to redo.
+	std::vector<artedit>* redo() {
+		open = false;
+		if (future.empty())
+			return NULL;
+		past.push_back(step());
+		past.back().edits.swap(future.back().edits);
+		past.back().bytes = future.back().bytes;
+		future.pop_back();
+		return &past.back().edits;
+	}
+	//Change how much memory the history may take up, forgetting the oldest steps if it's over
+	void setLimit(std::size_t bytes) {
+		limit = bytes;
+		trim();
+	}
+
+	// STATISTICS
+	std::size_t undoSteps() const { return past.size(); }
+	std::size_t redoSteps() const { return future.size(); }
+	//True if there's nothing to undo or redo
+	bool empty() const { return past.empty() && future.empty(); }
+	//Roughly how much memory every step takes up, in bytes
+	std::size_t bytes() const { return used; }
+	//The most memory the history may take up, in bytes
+	std::size_t memoryLimit() const { return limit; }
+
+private:
+	//Everything one user action changed
+	struct step {
+		std::vector<artedit> edits;
+		std::size_t bytes;
+		step() {
+			bytes = 0;
+		}
+	};
+	//Steps that can be undone, oldest first
+	std::deque<step> past;
+	//Steps that can be redone, the next one to redo last
+	std::vector<step> future;
+	std::size_t limit;
+	std::size_t used;
+	//True while changes are still being added to the last step
+	bool open;
+
+	//Fold a change into the record before it, if it only moves the same vertex again
+	static bool coalesce(artedit& last, const artedit& change) {
+		if (change.what != artedit::kMoveVertex || !(last.place == change.place) || last.index != change.index)
+			return false;
+		//Dragging a vertex around, or a vertex that was just put down
+		if (last.what == artedit::kMoveVertex || last.what == artedit::kInsertVertex) {
+			last.after = change.after;
+			return true;
+		}
+		return false;
+	}
+	void dropFuture() {
+		for (std::size_t i = 0; i < future.size(); ++i)
+			used -= future[i].bytes;
+		future.clear();
+	}
+	//Forget the oldest steps until the history fits (the step being made always stays)
+	void trim() {
+		while (used > limit && past.size() > 1) {
+			used -= past.front().bytes;
+			past.pop_front();
+		}
+	}
+};
+
+#endif
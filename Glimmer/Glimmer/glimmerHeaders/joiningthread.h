@@ -0,0 +1,42 @@
+/* This header file defines the threads Glimmer runs in the background. A thread still running
+ * when the program exits would take it down with an error, so each one is stopped and joined
+ * on the way out, before the globals it works with are torn down. */
+#pragma once
+
+#ifndef __joiningthread_h__
+#define __joiningthread_h__
+
+#include <thread>
+#include <utility>
+#include <cstdlib>
+
+//A thread that's stopped before the program exits, if it's still running then
+class joiningthread {
+public:
+	//'stop' is what stops the thread: it tells the work to finish, then calls join()
+	explicit joiningthread(void (*stop)()) : stop(stop) {}
+	//Run something on the thread (it mustn't be running already)
+	template<class Work>
+	void start(Work&& work) {
+		if (!stopsAtExit) {
+			std::atexit(stop);
+			stopsAtExit = true;
+		}
+		worker = std::thread(std::forward<Work>(work));
+	}
+	//Returns true from start() until the thread is joined
+	bool joinable() const {
+		return worker.joinable();
+	}
+	//Wait for the thread to finish, if it's running
+	void join() {
+		if (worker.joinable())
+			worker.join();
+	}
+private:
+	std::thread worker;
+	void (*stop)();
+	bool stopsAtExit = false;
+};
+
+#endif
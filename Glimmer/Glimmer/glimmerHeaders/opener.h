@@ -0,0 +1,156 @@
+/* This header file opens the files Glimmer is started with. They're all read at once, on
+ * every core, and each becomes a tab as soon as it and every file before it have been read,
+ * so the tabs appear in the order the files were given. Startup only waits for the first
+ * one; the rest are added between frames. Once the art already read is over the memory
+ * budget for tabs not being viewed, the files after it are left to be read when they're
+ * first viewed, rather than read just to be put away again. */
+#pragma once
+
+#ifndef __opener_h__
+#define __opener_h__
+
+#include "editor.h"
+#include "fgrparallel.h"
+#include "joiningthread.h"
+
+#include <string>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <condition_variable>
+
+namespace opener {
+	//A file being opened, and the tab it's opened into
+	class request {
+	public:
+		std::string path;
+		//The tab, made on a worker thread and moved into the tab list once it's this file's turn
+		std::list<editor> tab;
+		//False if the file extention wasn't recognized (no tab is made)
+		bool recognized = false;
+		//False if the file couldn't be read; the tab is left empty, as if the file were new
+		bool read = false;
+		//True once a worker is finished with this file
+		bool done = false;
+	};
+
+	//Every file being opened, in the order they were given
+	std::vector<request> requests;
+	//How many of them have been turned into tabs (or reported) so far
+	std::size_t shown = 0;
+	//Guards 'done' in every request, and the two counters below
+	std::mutex lock;
+	std::condition_variable finished;
+	//The next file a worker should take, and how much art the workers have read so far, in bytes
+	std::size_t nextFile = 0;
+	std::size_t bytesRead = 0;
+	void stop();
+	//Runs the workers, so none of them hold up the main thread
+	joiningthread crew(stop);
+	//How often finished files are looked for, in milliseconds
+	int pollInterval = 15;
+
+	//What every worker does: take the next file, read it into a tab, and repeat
+	void work(std::size_t budget) {
+		for (;;) {
+			std::size_t which;
+			bool readNow;
+			{
+				std::lock_guard<std::mutex> hold(lock);
+				if (nextFile >= requests.size())
+					return;
+				which = nextFile++;
+				//The first file is always read, since it's the one shown first
+				readNow = which == 0 || bytesRead < budget;
+			}
+			request& job = requests[which];
+			job.tab.emplace_back();
+			editor& made = job.tab.back();
+			job.recognized = made.openLater(job.path);
+			std::size_t bytes = 0;
+			if (job.recognized && readNow) {
+				job.read = made.wake();
+				bytes = made.artBytes();
+			}
+			//Left to be read when it's first viewed; there's no telling yet whether it's there
+			else if (job.recognized) {
+				job.read = true;
+			}
+			{
+				std::lock_guard<std::mutex> hold(lock);
+				bytesRead += bytes;
+				job.done = true;
+			}
+			finished.notify_all();
+		}
+	}
+
+	//Stop handing out files and wait for the workers to finish the ones they're reading
+	void stop() {
+		{
+			std::lock_guard<std::mutex> hold(lock);
+			nextFile = requests.size();
+		}
+		crew.join();
+	}
+
+	//Start reading files in the background, budgeting for the tabs not being viewed
+	void start(const std::vector<std::string>& paths, std::size_t budget) {
+		requests.resize(paths.size());
+		for (std::size_t i = 0; i < paths.size(); ++i)
+			requests[i].path = paths[i];
+		crew.start([budget]() {
+			fgr::parallel::forChunks(0, fgr::parallel::workerCount(), [budget](std::size_t, std::size_t, unsigned int) {
+				work(budget);
+			});
+		});
+	}
+
+	//Turn every file that's ready (and every file before it) into a tab at the end of the tab list.
+	//If 'wait' is true, keep waiting for files until there's at least one tab or every file has been dealt with.
+	//Returns true once every file has been dealt with.
+	bool showFinished(bool wait) {
+		std::unique_lock<std::mutex> hold(lock);
+		bool added = false;
+		for (;;) {
+			while (shown < requests.size() && requests[shown].done) {
+				request& job = requests[shown++];
+				if (!job.recognized) {
+					cli::send_message("Can't open '" + job.path + "' - unrecognized file extention", uError);
+					continue;
+				}
+				if (!job.read)
+					cli::send_message("Editing new file '" + job.path + '\'', uSuccess);
+				cli::offerRecovery(job.path);
+				tabs.splice(tabs.end(), job.tab);
+				added = true;
+			}
+			//Keep waiting for the next file while none of them could be opened
+			if (!wait || !tabs.empty() || shown >= requests.size())
+				break;
+			finished.wait(hold, []() { return requests[shown].done; });
+		}
+		bool complete = shown >= requests.size();
+		hold.unlock();
+		if (complete && crew.joinable()) {
+			crew.join();
+			requests.clear();
+			shown = 0;
+			nextFile = 0;
+			bytesRead = 0;
+		}
+		if (added && !tabs.empty() && !wait) {
+			fitTabBudget();
+			redraw::request();
+		}
+		return complete;
+	}
+
+	//Called back every so often until every file is a tab
+	void poll(int) {
+		if (!showFinished(false))
+			glutTimerFunc(pollInterval, poll, 0);
+	}
+}
+
+#endif
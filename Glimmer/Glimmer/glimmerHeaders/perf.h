@@ -0,0 +1,376 @@
+/* This header file measures what each frame costs, for the overlay :perf shows over the central
+ * pane. A frame's time is split into phases (handling input, working out the layout, drawing
+ * the art, drawing the panels and drawing the console), each timed by a timer that only counts
+ * time no timer inside it counted. A frame lasts from when it starts being drawn to when the next
+ * one does, so presenting it and waiting for the next count too; the time spent drawing it on the
+ * CPU is kept apart. fgr counts the primitives and vertices it hands to OpenGL,
+ * and where the driver supports timer queries, how long the GPU took is read back a few
+ * frames later so waiting on it never stalls a frame. The last few seconds of frames are kept
+ * for percentiles and a rolling graph. Nothing is measured while the overlay is hidden. */
+#pragma once
+
+#ifndef __perf_h__
+#define __perf_h__
+
+#include "fgrutils.h"
+#include "fgrglext.h"
+
+#include <GL/glut.h>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstddef>
+
+namespace perf {
+	//True while the overlay is shown (toggled with :perf)
+	std::atomic<bool> shown(false);
+
+	//The parts a frame's time is split into
+	enum phase { pInput, pLayout, pArt, pPanels, pConsole, phaseCount };
+
+	//Returns the name of a phase
+	std::string phaseName(phase which) {
+		switch (which) {
+		case pInput:	return "Input";
+		case pLayout:	return "Layout";
+		case pArt:		return "Art";
+		case pPanels:	return "Panels";
+		case pConsole:	return "Console";
+		default:		return "ERROR - NOT A VALID PHASE";
+		}
+	}
+
+	typedef std::chrono::steady_clock clock;
+
+	//Time spent in each phase since the last frame finished, in nanoseconds (input is handled on
+	//the main thread while the render thread may be drawing, so these are added to from both)
+	std::atomic<long long> spent[phaseCount];
+
+	//Counts the time until it goes out of scope toward a phase. A timer made while another is
+	//running on the same thread pauses that one, so no time is counted twice.
+	class timer {
+	public:
+		timer(phase which_) : which(which_), outer(NULL), counting(shown) {
+			if (!counting)
+				return;
+			clock::time_point now = clock::now();
+			outer = running();
+			if (outer)
+				outer->pause(now);
+			started = now;
+			running() = this;
+		}
+		~timer() {
+			if (!counting)
+				return;
+			clock::time_point now = clock::now();
+			pause(now);
+			running() = outer;
+			if (outer)
+				outer->started = now;
+		}
+	private:
+		phase which;
+		timer* outer;
+		bool counting;
+		clock::time_point started;
+
+		//The innermost timer running on this thread
+		static timer*& running() {
+			static thread_local timer* innermost = NULL;
+			return innermost;
+		}
+		//Count the time since the timer was started (or last resumed)
+		void pause(clock::time_point now) {
+			spent[which] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - started).count();
+		}
+		//Not copyable
+		timer(const timer&);
+		timer& operator=(const timer&);
+	};
+
+	//What was measured of one frame
+	struct sample {
+		//Which frame it was, counting from the first measured
+		unsigned long number;
+		//From the start of this frame to the start of the next, in milliseconds (negative until the
+		//next one starts)
+		float frameMs;
+		//From the start of drawing to the end of it, on the CPU, in milliseconds
+		float cpuMs;
+		//Each phase's share (input is what happened since the frame before)
+		float phaseMs[phaseCount];
+		//What fgr handed to OpenGL
+		unsigned long primitives;
+		unsigned long vertices;
+		//How long the GPU took to draw it, in milliseconds (negative until it's known, or if it can't be)
+		float gpuMs;
+	};
+
+	//How many frames are kept
+	const std::size_t kept = 240;
+	//The last frames measured, oldest first once 'kept' have been
+	std::vector<sample> samples;
+	std::size_t nextSample = 0;
+	unsigned long framesMeasured = 0;
+	//How many bytes of art the tabs have in memory (worked out on the main thread each frame)
+	std::atomic<std::size_t> residentBytes(0);
+	//Set to forget what was measured before, by whichever thread draws the next frame
+	std::atomic<bool> restart(false);
+
+	//When the frame being drawn started
+	clock::time_point frameStarted;
+	bool frameOpen = false;
+	//True once a frame has started since the overlay was shown (so the one before can be timed)
+	bool framesStarted = false;
+
+	//Timer queries for the GPU: a few in flight at once, each read back once the GPU is done with it
+	const std::size_t queryCount = 4;
+	GLuint queries[queryCount];
+	//Which frame each query is timing (0 if it isn't waiting on one)
+	unsigned long queryFrame[queryCount];
+	//The context the queries were made in (they can't be used in another)
+	HGLRC queryContext = NULL;
+	bool gpuTimed = false;
+	//The query timing the frame being drawn (queryCount if none is)
+	std::size_t activeQuery = queryCount;
+
+	//The frame kept with some number, or NULL if it's been forgotten
+	sample* findSample(unsigned long number) {
+		for (std::size_t i = 0; i < samples.size(); ++i) {
+			if (samples[i].number == number)
+				return &samples[i];
+		}
+		return NULL;
+	}
+
+	//Read back whatever queries the GPU is done with
+	void collectQueries() {
+		for (std::size_t i = 0; i < queryCount; ++i) {
+			if (!queryFrame[i] || i == activeQuery)
+				continue;
+			GLint available = 0;
+			fgr::glext::getQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				continue;
+			unsigned long long nanoseconds = 0;
+			fgr::glext::getQueryObjectui64v(queries[i], GL_QUERY_RESULT, &nanoseconds);
+			sample* timed = findSample(queryFrame[i]);
+			if (timed)
+				timed->gpuMs = float(double(nanoseconds) / 1.0e6);
+			queryFrame[i] = 0;
+		}
+	}
+
+	//Start measuring a frame. Needs the context it's drawn in to be current.
+	void frameBegun() {
+		if (!shown)
+			return;
+		if (restart.exchange(false)) {
+			samples.clear();
+			nextSample = 0;
+			framesStarted = false;
+		}
+		clock::time_point now = clock::now();
+		//The frame before lasted until this one started
+		if (framesStarted && !samples.empty()) {
+			sample& before = samples[(nextSample + samples.size() - 1) % samples.size()];
+			before.frameMs = float(std::chrono::duration<double, std::milli>(now - frameStarted).count());
+		}
+		framesStarted = true;
+		frameStarted = now;
+		frameOpen = true;
+		fgr::primitivesDrawn = 0;
+		fgr::verticesDrawn = 0;
+		activeQuery = queryCount;
+		if (!fgr::glext::loadQueries())
+			return;
+		//The render thread draws in a context of its own
+		if (queryContext != wglGetCurrentContext()) {
+			queryContext = wglGetCurrentContext();
+			fgr::glext::genQueries(GLsizei(queryCount), queries);
+			std::fill(queryFrame, queryFrame + queryCount, 0ul);
+		}
+		gpuTimed = true;
+		collectQueries();
+		//If every query is still waiting on the GPU, this frame goes untimed rather than waiting too
+		for (std::size_t i = 0; i < queryCount; ++i) {
+			if (!queryFrame[i]) {
+				activeQuery = i;
+				queryFrame[i] = framesMeasured + 1;
+				fgr::glext::beginQuery(GL_TIME_ELAPSED, queries[i]);
+				break;
+			}
+		}
+	}
+
+	//Finish measuring a frame (before anything that shouldn't count, like the overlay, is drawn)
+	void frameFinished() {
+		if (!frameOpen)
+			return;
+		frameOpen = false;
+		if (activeQuery < queryCount) {
+			fgr::glext::endQuery(GL_TIME_ELAPSED);
+			activeQuery = queryCount;
+		}
+		sample made;
+		made.number = ++framesMeasured;
+		made.frameMs = -1.0f;
+		made.cpuMs = float(std::chrono::duration<double, std::milli>(clock::now() - frameStarted).count());
+		for (int p = 0; p < phaseCount; ++p)
+			made.phaseMs[p] = float(double(spent[p].exchange(0)) / 1.0e6);
+		made.primitives = fgr::primitivesDrawn;
+		made.vertices = fgr::verticesDrawn;
+		made.gpuMs = -1.0f;
+		if (samples.size() < kept)
+			samples.push_back(made);
+		else
+			samples[nextSample] = made;
+		nextSample = (nextSample + 1) % kept;
+	}
+
+	//A percentile (0 to 100) of one of the times kept of every frame, leaving out ones not known yet
+	float percentile(float sample::* time, float percent) {
+		std::vector<float> times;
+		times.reserve(samples.size());
+		for (std::size_t i = 0; i < samples.size(); ++i) {
+			if (samples[i].*time >= 0.0f)
+				times.push_back(samples[i].*time);
+		}
+		if (times.empty())
+			return 0.0f;
+		std::size_t rank = std::min(times.size() - 1, std::size_t(percent / 100.0f * float(times.size())));
+		std::nth_element(times.begin(), times.begin() + rank, times.end());
+		return times[rank];
+	}
+
+	//Text with a fixed number of decimals
+	std::string decimals(double value, int places) {
+		char text[32];
+		std::snprintf(text, sizeof(text), "%.*f", places, value);
+		return text;
+	}
+
+	//The lines of text the overlay shows
+	std::vector<std::string> report() {
+		std::vector<std::string> lines;
+		if (samples.empty()) {
+			lines.push_back("Measuring...");
+			return lines;
+		}
+		//Phases and GPU time are averaged over every frame kept; counts are of the last frame
+		float phases[phaseCount] = {};
+		double gpu = 0.0;
+		std::size_t gpuFrames = 0;
+		for (std::size_t i = 0; i < samples.size(); ++i) {
+			for (int p = 0; p < phaseCount; ++p)
+				phases[p] += samples[i].phaseMs[p] / float(samples.size());
+			if (samples[i].gpuMs >= 0.0f) {
+				gpu += samples[i].gpuMs;
+				++gpuFrames;
+			}
+		}
+		const sample& last = samples[(nextSample + samples.size() - 1) % samples.size()];
+		lines.push_back("Frame ms  p50 " + decimals(percentile(&sample::frameMs, 50.0f), 2) + "  p95 " + decimals(percentile(&sample::frameMs, 95.0f), 2)
+			+ "  p99 " + decimals(percentile(&sample::frameMs, 99.0f), 2) + "  max " + decimals(percentile(&sample::frameMs, 100.0f), 2));
+		lines.push_back("CPU ms  p50 " + decimals(percentile(&sample::cpuMs, 50.0f), 2) + "  p95 " + decimals(percentile(&sample::cpuMs, 95.0f), 2)
+			+ "  p99 " + decimals(percentile(&sample::cpuMs, 99.0f), 2) + "  max " + decimals(percentile(&sample::cpuMs, 100.0f), 2));
+		std::string split;
+		for (int p = 0; p < phaseCount; ++p)
+			split += (p ? "  " : "") + phaseName(phase(p)) + " " + decimals(phases[p], 2);
+		lines.push_back(split + " ms");
+		lines.push_back("Draw calls " + std::to_string(last.primitives) + "  Vertices " + std::to_string(last.vertices));
+		if (gpuFrames)
+			lines.push_back("GPU " + decimals(gpu / double(gpuFrames), 2) + " ms");
+		else
+			lines.push_back(gpuTimed ? "GPU waiting..." : "GPU time not available");
+		lines.push_back("Art in memory " + decimals(double(residentBytes) / (1024.0 * 1024.0), 1) + " MB  ("
+			+ std::to_string(samples.size()) + " frames)");
+		return lines;
+	}
+
+	//Draw the overlay with its top right corner at a pixel, given a projection in pixels
+	void draw(int right, int top) {
+		if (!shown)
+			return;
+		std::vector<std::string> lines = report();
+		const int lineHeight = 14, graphHeight = 60, width = 420, padding = 6;
+		int height = int(lines.size()) * lineHeight + graphHeight + 3 * padding;
+		int left = right - width - padding, bottom = top - height - padding;
+		//A dark backing, so the numbers can be read over any art
+		glColor3f(0.08f, 0.08f, 0.08f);
+		glBegin(GL_QUADS);
+			glVertex2i(left, bottom);
+			glVertex2i(left + width, bottom);
+			glVertex2i(left + width, top - padding);
+			glVertex2i(left, top - padding);
+		glEnd();
+		glColor3f(0.9f, 0.9f, 0.9f);
+		for (std::size_t i = 0; i < lines.size(); ++i) {
+			glRasterPos2i(left + padding, top - 2 * padding - int(i + 1) * lineHeight + 3);
+			for (char c : lines[i])
+				glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, c);
+		}
+		//The rolling graph: a bar per frame, scaled so the top is 33 ms (two frames at 60 fps)
+		int graphLeft = left + padding, graphBottom = bottom + padding;
+		float scale = float(graphHeight) / 33.3f;
+		float step = float(width - 2 * padding) / float(kept);
+		glColor3f(0.3f, 0.3f, 0.3f);
+		glBegin(GL_LINES);
+			glVertex2f(float(graphLeft), graphBottom + 16.7f * scale);
+			glVertex2f(float(left + width - padding), graphBottom + 16.7f * scale);
+		glEnd();
+		std::size_t oldest = samples.size() < kept ? 0 : nextSample;
+		glBegin(GL_QUADS);
+		for (std::size_t i = 0; i < samples.size(); ++i) {
+			const sample& one = samples[(oldest + i) % samples.size()];
+			if (one.frameMs < 0.0f)
+				continue;
+			float x = graphLeft + step * float(i);
+			float y = graphBottom + std::min(float(graphHeight), one.frameMs * scale);
+			//Green under a 60 fps frame, yellow under 30 fps, red over
+			if (one.frameMs < 16.7f)
+				glColor3f(0.2f, 0.8f, 0.3f);
+			else if (one.frameMs < 33.3f)
+				glColor3f(0.9f, 0.8f, 0.2f);
+			else
+				glColor3f(0.9f, 0.2f, 0.2f);
+			glVertex2f(x, float(graphBottom));
+			glVertex2f(x + step, float(graphBottom));
+			glVertex2f(x + step, y);
+			glVertex2f(x, y);
+		}
+		glEnd();
+		//The time spent drawing on the CPU, then the GPU's, over the bars
+		glColor3f(0.95f, 0.95f, 0.95f);
+		glBegin(GL_LINE_STRIP);
+		for (std::size_t i = 0; i < samples.size(); ++i) {
+			const sample& one = samples[(oldest + i) % samples.size()];
+			glVertex2f(graphLeft + step * (float(i) + 0.5f), graphBottom + std::min(float(graphHeight), one.cpuMs * scale));
+		}
+		glEnd();
+		glColor3f(0.3f, 0.6f, 1.0f);
+		glBegin(GL_LINE_STRIP);
+		for (std::size_t i = 0; i < samples.size(); ++i) {
+			const sample& one = samples[(oldest + i) % samples.size()];
+			if (one.gpuMs >= 0.0f)
+				glVertex2f(graphLeft + step * (float(i) + 0.5f), graphBottom + std::min(float(graphHeight), one.gpuMs * scale));
+		}
+		glEnd();
+	}
+
+	//Show or hide the overlay, starting over on what it measures
+	void show(bool on) {
+		if (on && !shown) {
+			for (int p = 0; p < phaseCount; ++p)
+				spent[p] = 0;
+			restart = true;
+		}
+		shown = on;
+	}
+}
+
+#endif
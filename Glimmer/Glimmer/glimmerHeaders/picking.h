@@ -0,0 +1,315 @@
+/* This header file defines how a shape is picked out of a graphic by clicking on it. The box
+ * around every shape is worked out once per change to the art and packed into an R-tree (a
+ * tree of boxes, each holding the boxes below it), so a click only looks at the few shapes
+ * whose boxes it's in. Those are then tested exactly, from the top-most (the last drawn)
+ * down: a filled shape is hit inside it, and lines and points are hit within reach of them. */
+#pragma once
+
+#ifndef __picking_h__
+#define __picking_h__
+
+#include "fgrutils.h"
+#include "fgrparallel.h"
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+//How many pixels away from a line or point still counts as on it
+const float pickLeeway = 3.0f;
+
+//Every shape of a graphic, packed into an R-tree by the box around it
+class shapetree {
+public:
+	//A box in the art's co-ordinates (empty if its left is past its right)
+	struct box {
+		float left;
+		float bottom;
+		float right;
+		float top;
+		//Grow to take in another box
+		void add(const box& other) {
+			left = std::min(left, other.left);
+			bottom = std::min(bottom, other.bottom);
+			right = std::max(right, other.right);
+			top = std::max(top, other.top);
+		}
+		//True if a point is in the box, grown by 'reach' on every side
+		bool holds(float x, float y, float reach) const {
+			return x >= left - reach && x <= right + reach && y >= bottom - reach && y <= top + reach;
+		}
+		float middleX() const {
+			return (left + right) * 0.5f;
+		}
+		float middleY() const {
+			return (bottom + top) * 0.5f;
+		}
+	};
+
+	//Work out the box around every shape of a graphic, and pack the boxes into a tree
+	void build(const fgr::graphic& art) {
+		bounds.assign(art.size(), nothing());
+		widest = 0.0f;
+		std::size_t total = 0;
+		for (std::size_t s = 0; s < art.size(); ++s)
+			total += art[s].size();
+		//Big graphics are measured on every core
+		auto job = [&](std::size_t first, std::size_t last, unsigned int) {
+			for (std::size_t s = first; s < last; ++s)
+				bounds[s] = measure(art[s]);
+		};
+		if (total >= 65536)
+			fgr::parallel::forChunks(0, art.size(), job);
+		else
+			job(0, art.size(), 0u);
+		order.clear();
+		for (std::size_t s = 0; s < art.size(); ++s) {
+			if (!art[s].size())
+				continue;
+			order.push_back(std::uint32_t(s));
+			widest = std::max(widest, std::max(art[s].lineThickness, art[s].pointSize));
+		}
+		pack();
+	}
+	//How many shapes the tree was built from
+	std::size_t size() const {
+		return bounds.size();
+	}
+	//The box around a shape
+	const box& boundsOf(std::size_t shape) const {
+		return bounds[shape];
+	}
+	//The top-most shape of the graphic the tree was built from at a point, given how big a pixel is
+	//in the art's co-ordinates. Returns the graphic's size if there's no shape there.
+	std::size_t topmost(const fgr::graphic& art, const fgr::point& at, float pixel) const {
+		std::vector<std::uint32_t> found;
+		//Nothing's further from its box than half the widest line or point, plus a little leeway
+		candidates(at.x(), at.y(), pixel * (widest * 0.5f + pickLeeway), found);
+		//Later shapes are drawn over earlier ones
+		std::sort(found.begin(), found.end(), std::greater<std::uint32_t>());
+		for (std::size_t i = 0; i < found.size(); ++i) {
+			if (touches(art[found[i]], at.x(), at.y(), pixel))
+				return found[i];
+		}
+		return art.size();
+	}
+
+	//True if a point is on a shape: inside it if it's filled, or within reach of it if it's lines or
+	//points (half its line width or point size, plus a little leeway, in pixels of the size given)
+	static bool touches(const fgr::shape& art, float x, float y, float pixel) {
+		//A bezier is tested as the curve it's drawn as
+		if (art.bezier && art.size())
+			return touchesPlain(fgr::evaluateBezier(art, fgr::BEZIER_RESOLUTION), art, x, y, pixel);
+		return touchesPlain(art, art, x, y, pixel);
+	}
+
+private:
+	//How many boxes each box of the tree holds, at most
+	enum { fanout = 16 };
+
+	//A box of the tree, and what's in it: some shapes (in 'order') if it's a leaf, or some other nodes if not
+	struct node {
+		box bounds;
+		std::uint32_t first;
+		std::uint32_t count;
+		bool leaf;
+	};
+
+	//The box around each shape, by its place in the graphic
+	std::vector<box> bounds;
+	//The shapes with vertices, in the order the leaves hold them
+	std::vector<std::uint32_t> order;
+	//Every node, the leaves first and each level above after the one below, ending with the root
+	std::vector<node> nodes;
+	//The widest line or biggest point of any shape, in pixels
+	float widest = 0.0f;
+
+	static box nothing() {
+		box none = { INFINITY, INFINITY, -INFINITY, -INFINITY };
+		return none;
+	}
+	//The box around a shape's vertices (a bezier never leaves the box around the points that shape it)
+	static box measure(const fgr::glyph& art) {
+		box around = nothing();
+		for (fgr::glyph::const_iterator dot = art.begin(); dot != art.end(); ++dot) {
+			around.left = std::min(around.left, dot->x());
+			around.right = std::max(around.right, dot->x());
+			around.bottom = std::min(around.bottom, dot->y());
+			around.top = std::max(around.top, dot->y());
+		}
+		return around;
+	}
+
+	//Sort-tile-recursive packing: sort things by the middle of their boxes left to right, cut them
+	//into vertical slices, and sort each slice bottom to top, so each run of 'fanout' is a compact tile
+	template<class thing, class boxof>
+	static void tile(std::vector<thing>& things, boxof boxOf) {
+		std::size_t groups = (things.size() + fanout - 1) / fanout;
+		std::size_t slices = std::size_t(std::ceil(std::sqrt(double(groups))));
+		std::size_t perSlice = std::max<std::size_t>(1, slices) * fanout;
+		std::sort(things.begin(), things.end(), [&](const thing& a, const thing& b) {
+			return boxOf(a).middleX() < boxOf(b).middleX();
+		});
+		for (std::size_t first = 0; first < things.size(); first += perSlice) {
+			std::size_t last = std::min(things.size(), first + perSlice);
+			std::sort(things.begin() + first, things.begin() + last, [&](const thing& a, const thing& b) {
+				return boxOf(a).middleY() < boxOf(b).middleY();
+			});
+		}
+	}
+
+	//Build the tree over the shapes in 'order', from the leaves up
+	void pack() {
+		nodes.clear();
+		if (order.empty())
+			return;
+		tile(order, [&](std::uint32_t s) -> const box& { return bounds[s]; });
+		for (std::size_t first = 0; first < order.size(); first += fanout) {
+			node leaf = { nothing(), std::uint32_t(first), std::uint32_t(std::min<std::size_t>(fanout, order.size() - first)), true };
+			for (std::size_t i = first; i < first + leaf.count; ++i)
+				leaf.bounds.add(bounds[order[i]]);
+			nodes.push_back(leaf);
+		}
+		//Each level is tiled in place (what the nodes point to doesn't move), then the next one is made over it
+		std::size_t begin = 0;
+		while (nodes.size() - begin > 1) {
+			std::size_t end = nodes.size();
+			std::vector<node> level(nodes.begin() + begin, nodes.end());
+			tile(level, [](const node& n) -> const box& { return n.bounds; });
+			std::copy(level.begin(), level.end(), nodes.begin() + begin);
+			for (std::size_t first = begin; first < end; first += fanout) {
+				node parent = { nothing(), std::uint32_t(first), std::uint32_t(std::min<std::size_t>(fanout, end - first)), false };
+				for (std::size_t i = first; i < first + parent.count; ++i)
+					parent.bounds.add(nodes[i].bounds);
+				nodes.push_back(parent);
+			}
+			begin = end;
+		}
+	}
+
+	//Find every shape whose box, grown by 'reach', a point is in
+	void candidates(float x, float y, float reach, std::vector<std::uint32_t>& found) const {
+		if (nodes.empty())
+			return;
+		std::vector<std::uint32_t> pending(1, std::uint32_t(nodes.size() - 1));
+		while (!pending.empty()) {
+			const node& look = nodes[pending.back()];
+			pending.pop_back();
+			if (!look.bounds.holds(x, y, reach))
+				continue;
+			for (std::uint32_t i = look.first; i < look.first + look.count; ++i) {
+				if (!look.leaf)
+					pending.push_back(i);
+				else if (bounds[order[i]].holds(x, y, reach))
+					found.push_back(order[i]);
+			}
+		}
+	}
+
+	//The square of the distance from a point to a line segment
+	static float distanceSquared(float x, float y, float ax, float ay, float bx, float by) {
+		float dx = bx - ax, dy = by - ay;
+		float along = dx * dx + dy * dy > 0.0f ? ((x - ax) * dx + (y - ay) * dy) / (dx * dx + dy * dy) : 0.0f;
+		along = std::max(0.0f, std::min(1.0f, along));
+		float ox = ax + along * dx - x, oy = ay + along * dy - y;
+		return ox * ox + oy * oy;
+	}
+	//True if a ray from a point to the right crosses the edge from a to b (an odd count of crossings is inside)
+	static bool crosses(float x, float y, float ax, float ay, float bx, float by) {
+		return (ay > y) != (by > y) && x < (bx - ax) * (y - ay) / (by - ay) + ax;
+	}
+	//True if a point is inside the polygon with some corners (given as x and y arrays)
+	static bool inside(float x, float y, const float* xs, const float* ys, std::size_t corners) {
+		bool in = false;
+		for (std::size_t i = 0, j = corners - 1; i < corners; j = i++) {
+			if (crosses(x, y, xs[j], ys[j], xs[i], ys[i]))
+				in = !in;
+		}
+		return in;
+	}
+	//The test itself, on the vertices as drawn, with the style of the shape they belong to. The
+	//vertices are gone through once, keeping the last four (the most any one piece needs).
+	static bool touchesPlain(const fgr::glyph& drawn, const fgr::shape& style, float x, float y, float pixel) {
+		if (!drawn.size())
+			return false;
+		float reach = pixel * (style.lineThickness * 0.5f + pickLeeway);
+		reach *= reach;
+		float dotReach = pixel * (style.pointSize * 0.5f + pickLeeway);
+		dotReach *= dotReach;
+		//The last four vertices, the newest at [3], and the first one
+		float xs[4] = { 0.0f, 0.0f, 0.0f, 0.0f }, ys[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float firstX = 0.0f, firstY = 0.0f;
+		//Crossings of the outline so far, for polygons
+		bool in = false;
+		std::size_t i = 0;
+		for (fgr::glyph::const_iterator dot = drawn.begin(); dot != drawn.end(); ++dot, ++i) {
+			for (std::size_t k = 0; k < 3; ++k) {
+				xs[k] = xs[k + 1];
+				ys[k] = ys[k + 1];
+			}
+			xs[3] = dot->x();
+			ys[3] = dot->y();
+			if (!i) {
+				firstX = xs[3];
+				firstY = ys[3];
+			}
+			switch (drawn.mode) {
+			case fgr::glPoints:
+				if ((xs[3] - x) * (xs[3] - x) + (ys[3] - y) * (ys[3] - y) <= dotReach)
+					return true;
+				break;
+			case fgr::glLines:
+				if (i % 2 == 1 && distanceSquared(x, y, xs[2], ys[2], xs[3], ys[3]) <= reach)
+					return true;
+				break;
+			case fgr::glLineStrip:
+			case fgr::glLineLoop:
+			case fgr::glBezier:
+				if (distanceSquared(x, y, i ? xs[2] : xs[3], i ? ys[2] : ys[3], xs[3], ys[3]) <= reach)
+					return true;
+				break;
+			case fgr::glTriangles:
+				if (i % 3 == 2 && inside(x, y, xs + 1, ys + 1, 3))
+					return true;
+				break;
+			case fgr::glTriangleStrip:
+				if (i >= 2 && inside(x, y, xs + 1, ys + 1, 3))
+					return true;
+				break;
+			case fgr::glTriangleFan:
+				if (i >= 2) {
+					float cx[3] = { firstX, xs[2], xs[3] }, cy[3] = { firstY, ys[2], ys[3] };
+					if (inside(x, y, cx, cy, 3))
+						return true;
+				}
+				break;
+			case fgr::glQuads:
+				if (i % 4 == 3 && inside(x, y, xs, ys, 4))
+					return true;
+				break;
+			case fgr::glQuadStrip:
+				if (i >= 3 && i % 2 == 1) {
+					float cx[4] = { xs[0], xs[1], xs[3], xs[2] }, cy[4] = { ys[0], ys[1], ys[3], ys[2] };
+					if (inside(x, y, cx, cy, 4))
+						return true;
+				}
+				break;
+			case fgr::glPolygon:
+				if (i && crosses(x, y, xs[2], ys[2], xs[3], ys[3]))
+					in = !in;
+				break;
+			}
+		}
+		//Loops and polygons close back to the first vertex
+		if (drawn.mode == fgr::glLineLoop && i > 2)
+			return distanceSquared(x, y, xs[3], ys[3], firstX, firstY) <= reach;
+		if (drawn.mode == fgr::glPolygon && i > 2 && crosses(x, y, xs[3], ys[3], firstX, firstY))
+			in = !in;
+		return drawn.mode == fgr::glPolygon && i > 2 && in;
+	}
+};
+
+#endif
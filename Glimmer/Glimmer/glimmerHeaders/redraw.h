@@ -0,0 +1,90 @@
+/* This header file decides when Glimmer actually redraws. Input handlers never render
+ * directly; they mark the scene dirty with redraw::request(), and the request is
+ * turned into (at most) one redisplay per frame according to the pacing policy. */
+#pragma once
+
+#ifndef __redraw_h__
+#define __redraw_h__
+
+#include <string>
+
+namespace redraw {
+	//The ways frames can be paced
+	enum pacing { pVsync, pCapped, pUncapped };
+	//The current pacing policy (set from .glimrc with :pacing)
+	pacing policy = pVsync;
+	//The most frames per second drawn while capped
+	int frameCap = 60;
+	//True if something has changed since the last frame was drawn
+	bool dirty = true;
+	//True if a timer is already waiting to post the next redisplay
+	bool timerPending = false;
+	//GLUT_ELAPSED_TIME at the start of the last frame, in milliseconds
+	int lastFrame = -1000;
+	//Sets the swap interval of whichever context presents frames (the render thread swaps this
+	//out while it's running, since only the thread that owns a context can change it)
+	bool (*applySwapInterval)(int) = glut32::setSwapInterval;
+
+	//Returns the name of a pacing policy
+	std::string pacingName(pacing which) {
+		switch (which) {
+		case pVsync:		return "vsync";
+		case pCapped:		return "capped";
+		case pUncapped:		return "uncapped";
+		default:			return "ERROR - NOT A VALID PACING POLICY";
+		}
+	}
+
+	//Called back once the frame cap allows another frame
+	void timerExpired(int) {
+		timerPending = false;
+		if (dirty)
+			glutPostRedisplay();
+	}
+
+	//Mark the scene dirty and ask for a redisplay. Any number of requests between two
+	//frames become a single frame.
+	void request() {
+		dirty = true;
+		if (policy != pCapped) {
+			glutPostRedisplay();
+			return;
+		}
+		//Capped: wait out the rest of this frame's time slice before posting
+		int interval = 1000 / (frameCap > 0 ? frameCap : 1);
+		int waited = glutGet(GLUT_ELAPSED_TIME) - lastFrame;
+		if (waited >= interval) {
+			glutPostRedisplay();
+		}
+		else if (!timerPending) {
+			timerPending = true;
+			glutTimerFunc(interval - waited, timerExpired, 0);
+		}
+	}
+
+	//Call this instead of drawing when a frame can't be started yet; it's tried again shortly
+	void deferFrame() {
+		dirty = true;
+		if (!timerPending) {
+			timerPending = true;
+			glutTimerFunc(1, timerExpired, 0);
+		}
+	}
+
+	//Call this as a frame starts drawing
+	void frameBegun() {
+		dirty = false;
+		lastFrame = glutGet(GLUT_ELAPSED_TIME);
+	}
+
+	//Switch the pacing policy, turning vertical sync on or off to match
+	void setPolicy(pacing newPolicy, int cap = 0) {
+		policy = newPolicy;
+		if (cap > 0)
+			frameCap = cap;
+		applySwapInterval(policy == pVsync ? 1 : 0);
+		request();
+	}
+}
+
+#endif
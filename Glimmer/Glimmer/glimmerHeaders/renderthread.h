@@ -0,0 +1,169 @@
+/* This header file moves drawing off the main thread. While the render thread is running,
+ * the display callback doesn't draw: it takes a snapshot of the current tab and the console
+ * (sharing the tab's art rather than copying it) and hands it over, and the render thread
+ * draws that snapshot into the window through an OpenGL context of its own, then lets go of
+ * it, so the tab doesn't have to copy its art to make the next change. So input and
+ * console commands keep being handled while a heavy scene draws. There's one snapshot being
+ * drawn and at most one waiting; a new frame isn't taken until the waiting one has been
+ * picked up, so the one drawn next is always the newest. Windows only, like the rest of the
+ * windowing code. */
+#pragma once
+
+#ifndef __renderthread_h__
+#define __renderthread_h__
+
+#include "editor.h"
+#include "redraw.h"
+#include "joiningthread.h"
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+//Draw a whole frame (the editor, the console and the window outline); defined in main.cpp
+void drawFrame(const editor& tab, const std::string& consoleField, const std::string& session);
+
+namespace renderthread {
+	//Everything one frame is drawn from, kept apart from the tab so it can't change while it's being drawn
+	class snapshot {
+	public:
+		//A copy of the current tab
+		editor tab;
+		//What's typed into the console
+		std::string consoleField;
+		//The session directory shown in the file tree
+		std::string session;
+	};
+
+	void stop();
+
+	//The thread that draws
+	joiningthread worker(stop);
+	//Guards everything below it
+	std::mutex lock;
+	std::condition_variable wake;
+	//The snapshot waiting to be drawn (the back buffer), if any
+	std::unique_ptr<snapshot> waiting;
+	//A swap interval waiting to be applied by the render thread (-1 if there isn't one)
+	int swapInterval = -1;
+	//True once the render thread has been asked to finish
+	bool stopping = false;
+	//The window and the context the render thread draws through
+	HDC device = NULL;
+	HGLRC context = NULL;
+
+	//Returns true if frames are being drawn on the render thread
+	bool active() {
+		return worker.joinable();
+	}
+
+	//Returns true if there's room for another snapshot (the last one has been picked up)
+	bool ready() {
+		std::lock_guard<std::mutex> hold(lock);
+		return !waiting;
+	}
+
+	//Hand a frame over to be drawn
+	void publish(std::unique_ptr<snapshot> frame) {
+		{
+			std::lock_guard<std::mutex> hold(lock);
+			waiting = std::move(frame);
+		}
+		wake.notify_one();
+	}
+
+	//Take a snapshot of a tab and the console and hand it over
+	void publish(const editor& tab, const std::string& consoleField, const std::string& session) {
+		std::unique_ptr<snapshot> frame(new snapshot);
+		frame->tab.mirror(tab);
+		frame->consoleField = consoleField;
+		frame->session = session;
+		publish(std::move(frame));
+	}
+
+	//Ask the render thread to change its swap interval (stands in for glut32::setSwapInterval while it runs)
+	bool requestSwapInterval(int interval) {
+		{
+			std::lock_guard<std::mutex> hold(lock);
+			swapInterval = interval;
+		}
+		wake.notify_one();
+		return true;
+	}
+
+	//What the render thread does until it's stopped
+	void loop() {
+		glut32::makeCurrent(device, context);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		{
+			//The chaos game's cloud belongs to whoever draws it, so it's kept from frame to frame
+			fgr::pointcloud cloud;
+			std::size_t cloudKey = 0;
+			while (true) {
+				std::unique_ptr<snapshot> next;
+				int interval;
+				{
+					std::unique_lock<std::mutex> hold(lock);
+					wake.wait(hold, [] { return stopping || waiting || swapInterval >= 0; });
+					if (stopping)
+						break;
+					next = std::move(waiting);
+					interval = swapInterval;
+					swapInterval = -1;
+				}
+				if (interval >= 0)
+					glut32::setSwapInterval(interval);
+				if (!next)
+					continue;
+				next->tab.fractalCloud.swap(cloud);
+				next->tab.fractalCloudKey = cloudKey;
+				ClearScreen();
+				glLoadIdentity();
+				drawFrame(next->tab, next->consoleField, next->session);
+				glut32::swapBuffers(device);
+				//Only the cloud is kept: while the snapshot lives, the tab's art is shared with it
+				cloud.swap(next->tab.fractalCloud);
+				cloudKey = next->tab.fractalCloudKey;
+				next.reset();
+			}
+		}
+		glut32::makeCurrent(NULL, NULL);
+	}
+
+	//Stop drawing on the render thread; the display callback draws again from the next frame
+	void stop() {
+		if (!active())
+			return;
+		{
+			std::lock_guard<std::mutex> hold(lock);
+			stopping = true;
+		}
+		wake.notify_one();
+		worker.join();
+		glut32::deleteContext(context);
+		context = NULL;
+		waiting.reset();
+		redraw::applySwapInterval = glut32::setSwapInterval;
+		redraw::setPolicy(redraw::policy);
+	}
+
+	//Start drawing on the render thread. Call this from the thread GLUT's context is current on.
+	//Returns false if a second context couldn't be made for the window.
+	bool start() {
+		if (active())
+			return true;
+		device = glut32::currentDevice();
+		context = glut32::createSharedContext();
+		if (!context)
+			return false;
+		stopping = false;
+		swapInterval = redraw::policy == redraw::pVsync ? 1 : 0;
+		worker.start(loop);
+		redraw::applySwapInterval = requestSwapInterval;
+		redraw::request();
+		return true;
+	}
+}
+
+#endif
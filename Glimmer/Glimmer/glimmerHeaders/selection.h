@@ -0,0 +1,305 @@
+/* This header file defines what picking out many vertices at once is built on. A vertex is
+ * named by a key holding its shape and its place in that shape, and a set of picked-out
+ * vertices is kept as sorted runs of consecutive keys, so a selection of a whole stroke takes
+ * one run rather than one entry per vertex. Finding the vertices inside a rectangle or a lasso
+ * goes through a grid that sorts every vertex of a graphic into square cells of the plane,
+ * so only the vertices in the cells the outline touches are looked at. A vertex that moves
+ * only has its own entry moved, so the grid keeps up with a drag without being sorted again. */
+#pragma once
+
+#ifndef __selection_h__
+#define __selection_h__
+
+#include "fgrutils.h"
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+//A vertex of a graphic: which shape it's in, and where in that shape it is
+typedef std::uint64_t vertexkey;
+
+//The key of a vertex
+inline vertexkey makeVertexKey(std::size_t shape, std::size_t vertex) {
+	return (vertexkey(shape) << 32) | vertexkey(vertex & 0xFFFFFFFFu);
+}
+//Which shape a key's vertex is in
+inline std::size_t keyShape(vertexkey key) {
+	return std::size_t(key >> 32);
+}
+//Where in its shape a key's vertex is
+inline std::size_t keyVertex(vertexkey key) {
+	return std::size_t(key & 0xFFFFFFFFu);
+}
+
+//A set of vertex keys, kept as sorted runs of consecutive keys
+class indexset {
+public:
+	//Every key from 'first' to 'last', both included (always within one shape)
+	struct run {
+		vertexkey first;
+		vertexkey last;
+		bool operator==(const run& other) const {
+			return first == other.first && last == other.last;
+		}
+	};
+
+	//Forget every key
+	void clear() {
+		spans.clear();
+		count = 0;
+	}
+	bool empty() const {
+		return spans.empty();
+	}
+	//How many keys there are
+	std::size_t size() const {
+		return count;
+	}
+	//The runs, in order
+	const std::vector<run>& runs() const {
+		return spans;
+	}
+	//Hold exactly the keys given (in any order, repeats allowed); the vector is sorted in the process
+	void assign(std::vector<vertexkey>& keys) {
+		clear();
+		std::sort(keys.begin(), keys.end());
+		for (std::size_t i = 0; i < keys.size(); ++i)
+			append(keys[i], keys[i]);
+	}
+	//Add every key of another set
+	void merge(const indexset& other) {
+		std::vector<run> mine;
+		mine.swap(spans);
+		count = 0;
+		std::size_t a = 0, b = 0;
+		while (a < mine.size() || b < other.spans.size()) {
+			const run& next = b >= other.spans.size() || (a < mine.size() && mine[a].first < other.spans[b].first)
+				? mine[a++] : other.spans[b++];
+			appendRun(next);
+		}
+	}
+	//Add every key from 'first' to 'last' (within one shape), none of them before the keys already in the set
+	void append(vertexkey first, vertexkey last) {
+		run span = { first, last };
+		appendRun(span);
+	}
+	//True if a key is in the set
+	bool contains(vertexkey key) const {
+		std::vector<run>::const_iterator after = std::upper_bound(spans.begin(), spans.end(), key,
+			[](vertexkey k, const run& span) { return k < span.first; });
+		return after != spans.begin() && key <= (after - 1)->last;
+	}
+	bool operator==(const indexset& other) const {
+		return count == other.count && spans == other.spans;
+	}
+	//Roughly how much memory the set takes up, in bytes
+	std::size_t bytes() const {
+		return sizeof(indexset) + spans.capacity() * sizeof(run);
+	}
+
+private:
+	std::vector<run> spans;
+	std::size_t count = 0;
+
+	//Add a run that starts no earlier than the last run, joining the two if they touch (repeated keys are ignored)
+	void appendRun(const run& next) {
+		if (!spans.empty() && keyShape(spans.back().last) == keyShape(next.first) && next.first <= spans.back().last + 1) {
+			if (next.last > spans.back().last) {
+				count += std::size_t(next.last - std::max(spans.back().last + 1, next.first) + 1);
+				spans.back().last = next.last;
+			}
+			return;
+		}
+		spans.push_back(next);
+		count += std::size_t(next.last - next.first + 1);
+	}
+};
+
+//Every vertex of a graphic (or a single glyph, as shape 0), sorted into square cells of the plane
+class vertexgrid {
+public:
+	//A vertex, and where it was when it was sorted into its cell
+	struct entry {
+		vertexkey key;
+		float x;
+		float y;
+	};
+
+	//Sort every vertex of a graphic into cells, sized so each holds a few vertices on average
+	void build(const fgr::graphic& art) {
+		start();
+		std::size_t total = 0;
+		float left = INFINITY, right = -INFINITY, bottom = INFINITY, top = -INFINITY;
+		for (fgr::graphic::const_iterator shape = art.begin(); shape != art.end(); ++shape) {
+			for (fgr::glyph::const_iterator dot = shape->begin(); dot != shape->end(); ++dot) {
+				left = std::min(left, dot->x());
+				right = std::max(right, dot->x());
+				bottom = std::min(bottom, dot->y());
+				top = std::max(top, dot->y());
+			}
+			total += shape->size();
+		}
+		sizeCells(total, right - left, top - bottom);
+		for (std::size_t s = 0; s < art.size(); ++s)
+			addGlyph(art[s], s);
+	}
+	void build(const fgr::glyph& art) {
+		start();
+		float left = INFINITY, right = -INFINITY, bottom = INFINITY, top = -INFINITY;
+		for (fgr::glyph::const_iterator dot = art.begin(); dot != art.end(); ++dot) {
+			left = std::min(left, dot->x());
+			right = std::max(right, dot->x());
+			bottom = std::min(bottom, dot->y());
+			top = std::max(top, dot->y());
+		}
+		sizeCells(art.size(), right - left, top - bottom);
+		addGlyph(art, 0);
+	}
+	//How many vertices are in the grid
+	std::size_t size() const {
+		return count;
+	}
+	//Move a vertex to another cell, if it's left its own, rather than sorting every vertex again.
+	//Returns false if the vertex wasn't where it's said to have been.
+	bool move(vertexkey key, const fgr::point& from, const fgr::point& to) {
+		std::unordered_map<std::uint64_t, std::vector<entry> >::iterator cell = cells.find(cellKey(cellOf(from.x()), cellOf(from.y())));
+		if (cell == cells.end())
+			return false;
+		for (std::size_t i = 0; i < cell->second.size(); ++i) {
+			if (cell->second[i].key != key)
+				continue;
+			entry moved = { key, to.x(), to.y() };
+			if (cellOf(to.x()) == cellOf(from.x()) && cellOf(to.y()) == cellOf(from.y())) {
+				cell->second[i] = moved;
+				return true;
+			}
+			cell->second[i] = cell->second.back();
+			cell->second.pop_back();
+			if (cell->second.empty())
+				cells.erase(cell);
+			cells[cellKey(cellOf(to.x()), cellOf(to.y()))].push_back(moved);
+			return true;
+		}
+		return false;
+	}
+	//Add one vertex (whose key isn't in the grid yet)
+	void add(vertexkey key, const fgr::point& at) {
+		entry made = { key, at.x(), at.y() };
+		cells[cellKey(cellOf(made.x), cellOf(made.y))].push_back(made);
+		++count;
+	}
+	//Find the vertex nearest a point, no further than 'reach' from it, leaving one vertex out.
+	//Returns false if there's none that near.
+	bool nearest(const fgr::point& at, float reach, vertexkey skip, entry& found) const {
+		float best = reach * reach;
+		bool any = false;
+		visit(at.x() - reach, at.y() - reach, at.x() + reach, at.y() + reach, [&](const entry& dot) {
+			float dx = dot.x - at.x(), dy = dot.y - at.y();
+			if (dot.key != skip && dx * dx + dy * dy <= best) {
+				best = dx * dx + dy * dy;
+				found = dot;
+				any = true;
+			}
+		});
+		return any;
+	}
+	//Find every vertex inside a rectangle, given by any two opposite corners
+	void within(const fgr::point& corner1, const fgr::point& corner2, std::vector<vertexkey>& found) const {
+		float left = std::min(corner1.x(), corner2.x()), right = std::max(corner1.x(), corner2.x());
+		float bottom = std::min(corner1.y(), corner2.y()), top = std::max(corner1.y(), corner2.y());
+		visit(left, bottom, right, top, [&](const entry& dot) {
+			if (dot.x >= left && dot.x <= right && dot.y >= bottom && dot.y <= top)
+				found.push_back(dot.key);
+		});
+	}
+	//Find every vertex inside a polygon (such as a lasso), counting crossings of its edges
+	void within(const std::vector<fgr::point>& outline, std::vector<vertexkey>& found) const {
+		if (outline.size() < 3)
+			return;
+		float left = INFINITY, right = -INFINITY, bottom = INFINITY, top = -INFINITY;
+		for (std::size_t i = 0; i < outline.size(); ++i) {
+			left = std::min(left, outline[i].x());
+			right = std::max(right, outline[i].x());
+			bottom = std::min(bottom, outline[i].y());
+			top = std::max(top, outline[i].y());
+		}
+		visit(left, bottom, right, top, [&](const entry& dot) {
+			if (dot.x < left || dot.x > right || dot.y < bottom || dot.y > top)
+				return;
+			bool inside = false;
+			for (std::size_t i = 0, j = outline.size() - 1; i < outline.size(); j = i++) {
+				float xi = outline[i].x(), yi = outline[i].y(), xj = outline[j].x(), yj = outline[j].y();
+				if ((yi > dot.y) != (yj > dot.y) && dot.x < (xj - xi) * (dot.y - yi) / (yj - yi) + xi)
+					inside = !inside;
+			}
+			if (inside)
+				found.push_back(dot.key);
+		});
+	}
+
+private:
+	//The side length of a cell, in the art's co-ordinates
+	float cellSize = 1.0f;
+	//The vertices in each cell that has any, by the cell's column and row
+	std::unordered_map<std::uint64_t, std::vector<entry> > cells;
+	std::size_t count = 0;
+
+	void start() {
+		cells.clear();
+		count = 0;
+	}
+	//Pick a cell size that puts about four vertices in each cell, if they were spread evenly
+	void sizeCells(std::size_t total, float width, float height) {
+		float area = std::max(width, 1e-6f) * std::max(height, 1e-6f);
+		cellSize = std::sqrt(area * 4.0f / float(std::max<std::size_t>(total, 1)));
+		cellSize = std::max(cellSize, std::max(width, height) / 4096.0f);
+		if (!(cellSize > 0.0f) || !std::isfinite(cellSize))
+			cellSize = 1.0f;
+		cells.reserve(total / 4 + 1);
+	}
+	//The column or row a co-ordinate is in
+	std::int32_t cellOf(float at) const {
+		float scaled = std::floor(at / cellSize);
+		scaled = std::max(-2.0e9f, std::min(2.0e9f, scaled));
+		return std::int32_t(scaled);
+	}
+	static std::uint64_t cellKey(std::int32_t column, std::int32_t row) {
+		return (std::uint64_t(std::uint32_t(column)) << 32) | std::uint32_t(row);
+	}
+	void addGlyph(const fgr::glyph& art, std::size_t shape) {
+		std::size_t index = 0;
+		for (fgr::glyph::const_iterator dot = art.begin(); dot != art.end(); ++dot, ++index) {
+			entry made = { makeVertexKey(shape, index), dot->x(), dot->y() };
+			cells[cellKey(cellOf(made.x), cellOf(made.y))].push_back(made);
+		}
+		count += art.size();
+	}
+	//Call a function on every vertex in the cells a rectangle touches (and maybe some others)
+	template<class function>
+	void visit(float left, float bottom, float right, float top, function look) const {
+		std::int64_t columns = std::int64_t(cellOf(right)) - cellOf(left) + 1;
+		std::int64_t rows = std::int64_t(cellOf(top)) - cellOf(bottom) + 1;
+		//A rectangle over more cells than there are filled ones just looks at all of them
+		if (columns * rows > std::int64_t(cells.size())) {
+			for (std::unordered_map<std::uint64_t, std::vector<entry> >::const_iterator cell = cells.begin(); cell != cells.end(); ++cell)
+				for (std::size_t i = 0; i < cell->second.size(); ++i)
+					look(cell->second[i]);
+			return;
+		}
+		for (std::int32_t column = cellOf(left); column <= cellOf(right); ++column) {
+			for (std::int32_t row = cellOf(bottom); row <= cellOf(top); ++row) {
+				std::unordered_map<std::uint64_t, std::vector<entry> >::const_iterator cell = cells.find(cellKey(column, row));
+				if (cell == cells.end())
+					continue;
+				for (std::size_t i = 0; i < cell->second.size(); ++i)
+					look(cell->second[i]);
+			}
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,405 @@
+/* This header file defines what snapping a dragged vertex is built on: which kinds of snapping
+ * are on, and a grid of every edge drawn in a graphic to find the nearest one quickly. Vertices are
+ * found through the same grid the selection uses. Both grids keep up with vertices as they're
+ * moved or added one at a time, so a drag that snaps costs only a few cells' worth of work per
+ * motion event, however big the graphic is. */
+#pragma once
+
+#ifndef __snapping_h__
+#define __snapping_h__
+
+#include "fgrutils.h"
+#include "selection.h"
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+namespace snap {
+	//Which kinds of snapping are on (set with :snap). The nearest vertex wins over the nearest
+	//edge, and either wins over the grid.
+	bool toGrid = false;
+	bool toVertices = false;
+	bool toEdges = false;
+	//The spacing of the grid snapped to, in the art's co-ordinates
+	float gridSize = 0.1f;
+	//How close to a vertex or edge the cursor has to be to snap to it, in pixels
+	float reach = 8.0f;
+
+	//True if any kind of snapping is on
+	bool any() {
+		return toGrid || toVertices || toEdges;
+	}
+	//The closest point on the grid
+	fgr::point toGridPoint(const fgr::point& at) {
+		if (!(gridSize > 0.0f))
+			return at;
+		return fgr::point(std::round(at.x() / gridSize) * gridSize, std::round(at.y() / gridSize) * gridSize);
+	}
+}
+
+//Every edge drawn in a graphic (or a single glyph, as shape 0), sorted into square cells of the
+//plane. Which vertices an edge joins depends on the mode its shape is drawn in: none for points,
+//each pair for lines, each one to the next for strips (and back to the first for loops and
+//polygons), and the sides of each triangle or quad. Curves are cut into the straight pieces
+//they're drawn with, so their edges are worked out again when a control point changes.
+class edgegrid {
+public:
+	//Sort every edge of a graphic into cells
+	void build(const fgr::graphic& art) {
+		start(art.size());
+		for (std::size_t s = 0; s < art.size(); ++s)
+			copyGlyph(art[s], s);
+		sizeCells();
+		for (std::size_t s = 0; s < outlines.size(); ++s)
+			fileShape(s);
+	}
+	void build(const fgr::glyph& art) {
+		start(1);
+		copyGlyph(art, 0);
+		sizeCells();
+		fileShape(0);
+	}
+	//True if a shape is a curve, so its edges can't follow its vertices one at a time (see reshape)
+	bool curved(std::size_t shape) const {
+		return shape < outlines.size() && outlines[shape].curved;
+	}
+	//Move a vertex, and with it the edges to and from it. Returns false if there's no such vertex,
+	//or if it's a curve's.
+	bool move(vertexkey key, const fgr::point& to) {
+		std::size_t s = keyShape(key), v = keyVertex(key);
+		if (s >= outlines.size() || outlines[s].curved || v >= outlines[s].corners.size())
+			return false;
+		std::vector<edge> touching;
+		around(s, v, touching);
+		for (std::size_t i = 0; i < touching.size(); ++i)
+			unfile(touching[i]);
+		outlines[s].corners[v] = corner(to);
+		for (std::size_t i = 0; i < touching.size(); ++i)
+			file(touching[i]);
+		return true;
+	}
+	//Add a vertex to the end of a shape, and the edges it makes. Returns false if there's no such
+	//shape, or if it's a curve.
+	bool append(std::size_t shape, const fgr::point& at) {
+		if (shape >= outlines.size() || outlines[shape].curved)
+			return false;
+		//No edge between vertices more than three from the end is made or broken by one more vertex
+		std::size_t count = outlines[shape].corners.size();
+		std::size_t from = count > 3 ? count - 3 : 0;
+		std::vector<edge> changed;
+		eachEdge(shape, from, count, [&](std::size_t a, std::size_t b) { changed.push_back(makeEdge(shape, a, b)); });
+		for (std::size_t i = 0; i < changed.size(); ++i)
+			unfile(changed[i]);
+		outlines[shape].corners.push_back(corner(at));
+		changed.clear();
+		eachEdge(shape, from, count + 1, [&](std::size_t a, std::size_t b) { changed.push_back(makeEdge(shape, a, b)); });
+		for (std::size_t i = 0; i < changed.size(); ++i)
+			file(changed[i]);
+		return true;
+	}
+	//Sort one shape's edges again from the glyph it's drawn from. Returns false if there's no such shape.
+	bool reshape(std::size_t shape, const fgr::glyph& art) {
+		if (shape >= outlines.size())
+			return false;
+		unfileShape(shape);
+		copyGlyph(art, shape);
+		fileShape(shape);
+		return true;
+	}
+	//Find the point on an edge nearest a point, no further than 'reach' from it, leaving out the edges
+	//to and from one vertex (or every edge of its shape, if that's a curve). Returns false if there's
+	//none that near.
+	bool nearest(const fgr::point& at, float reach, vertexkey skip, fgr::point& found) const {
+		float x = at.x(), y = at.y();
+		float best = reach * reach;
+		bool any = false;
+		std::size_t skipShape = keyShape(skip), skipVertex = keyVertex(skip);
+		bool skipWhole = curved(skipShape);
+		auto look = [&](const edge& line) {
+			if (line.shape == skipShape && (skipWhole || line.from == skipVertex || line.to == skipVertex))
+				return;
+			const corner& a = outlines[line.shape].corners[line.from];
+			const corner& b = outlines[line.shape].corners[line.to];
+			float dx = b.x - a.x, dy = b.y - a.y;
+			float length = dx * dx + dy * dy;
+			float along = length > 0.0f ? std::max(0.0f, std::min(1.0f, ((x - a.x) * dx + (y - a.y) * dy) / length)) : 0.0f;
+			float px = a.x + along * dx, py = a.y + along * dy;
+			float distance = (px - x) * (px - x) + (py - y) * (py - y);
+			if (distance <= best) {
+				best = distance;
+				found.x(px);
+				found.y(py);
+				any = true;
+			}
+		};
+		std::int64_t columns = std::int64_t(cellOf(x + reach)) - cellOf(x - reach) + 1;
+		std::int64_t rows = std::int64_t(cellOf(y + reach)) - cellOf(y - reach) + 1;
+		//Reaching over more cells than there are filled ones just looks at all of them
+		if (columns * rows > std::int64_t(cells.size())) {
+			for (std::unordered_map<std::uint64_t, std::vector<edge> >::const_iterator cell = cells.begin(); cell != cells.end(); ++cell)
+				for (std::size_t i = 0; i < cell->second.size(); ++i)
+					look(cell->second[i]);
+		}
+		else {
+			for (std::int32_t column = cellOf(x - reach); column <= cellOf(x + reach); ++column) {
+				for (std::int32_t row = cellOf(y - reach); row <= cellOf(y + reach); ++row) {
+					std::unordered_map<std::uint64_t, std::vector<edge> >::const_iterator cell = cells.find(cellKey(column, row));
+					if (cell == cells.end())
+						continue;
+					for (std::size_t i = 0; i < cell->second.size(); ++i)
+						look(cell->second[i]);
+				}
+			}
+		}
+		for (std::size_t i = 0; i < longEdges.size(); ++i)
+			look(longEdges[i]);
+		return any;
+	}
+
+private:
+	//Where a vertex is
+	struct corner {
+		float x;
+		float y;
+		corner() : x(0.0f), y(0.0f) { }
+		corner(const fgr::point& at) : x(at.x()), y(at.y()) { }
+	};
+	//The vertices one shape's edges run between, and how they're joined
+	struct outline {
+		std::vector<corner> corners;
+		fgr::GLmode mode;
+		//True if the corners are points along a curve rather than the shape's own vertices
+		bool curved;
+		outline() : mode(fgr::glPoints), curved(false) { }
+	};
+	//An edge, by its shape and the corners at either end of it
+	struct edge {
+		std::uint32_t shape;
+		std::uint32_t from;
+		std::uint32_t to;
+		bool operator==(const edge& other) const {
+			return shape == other.shape && from == other.from && to == other.to;
+		}
+	};
+	//An edge over more cells than this goes in a list of its own, which every search looks through
+	enum { mostCells = 16 };
+
+	std::vector<outline> outlines;
+	//The side length of a cell, in the art's co-ordinates
+	float cellSize = 1.0f;
+	//The edges in each cell that has any, by the cell's column and row
+	std::unordered_map<std::uint64_t, std::vector<edge> > cells;
+	//The edges too long to go in cells
+	std::vector<edge> longEdges;
+
+	static edge makeEdge(std::size_t shape, std::size_t from, std::size_t to) {
+		edge made = { std::uint32_t(shape), std::uint32_t(from), std::uint32_t(to) };
+		return made;
+	}
+	void start(std::size_t shapeCount) {
+		outlines.assign(shapeCount, outline());
+		cells.clear();
+		longEdges.clear();
+	}
+	void copyGlyph(const fgr::glyph& art, std::size_t shape) {
+		outline& made = outlines[shape];
+		made.corners.clear();
+		made.mode = art.mode;
+		made.curved = art.bezier;
+		if (art.bezier) {
+			fgr::glyph curve = fgr::evaluateBezier(art, fgr::BEZIER_RESOLUTION);
+			made.mode = curve.mode;
+			made.corners.assign(curve.begin(), curve.end());
+		}
+		else {
+			made.corners.reserve(art.size());
+			for (fgr::glyph::const_iterator dot = art.begin(); dot != art.end(); ++dot)
+				made.corners.push_back(corner(*dot));
+		}
+	}
+	/* Call visit(a, b) for every edge of a shape whose later corner is at least 'from' and before 'to'
+	 * (the edge closing a loop counts as ending at its last corner). */
+	template <typename visitor>
+	void eachEdge(std::size_t shape, std::size_t from, std::size_t to, visitor visit) const {
+		const outline& o = outlines[shape];
+		std::size_t n = o.corners.size();
+		to = std::min(to, n);
+		for (std::size_t m = from; m < to; ++m) {
+			switch (o.mode) {
+			case fgr::glPoints:
+				return;
+			case fgr::glLines:
+				if (m % 2)
+					visit(m - 1, m);
+				break;
+			case fgr::glPolygon:
+				if (n < 3)
+					return;
+			//Fall through: a polygon is outlined like a loop
+			case fgr::glLineLoop:
+				if (m)
+					visit(m - 1, m);
+				if (m == n - 1 && n > 2)
+					visit(m, std::size_t(0));
+				break;
+			case fgr::glTriangles: {
+				std::size_t first = m - m % 3;
+				if (first + 2 >= n)
+					break;
+				if (m % 3 == 1)
+					visit(first, first + 1);
+				else if (m % 3 == 2) {
+					visit(first + 1, first + 2);
+					visit(first + 2, first);
+				}
+				break;
+			}
+			case fgr::glTriangleStrip:
+				if (n < 3)
+					return;
+				if (m >= 1)
+					visit(m - 1, m);
+				if (m >= 2)
+					visit(m - 2, m);
+				break;
+			case fgr::glTriangleFan:
+				if (n < 3)
+					return;
+				if (m >= 1)
+					visit(std::size_t(0), m);
+				if (m >= 2)
+					visit(m - 1, m);
+				break;
+			case fgr::glQuads: {
+				std::size_t first = m - m % 4;
+				if (first + 3 >= n)
+					break;
+				if (m % 4 == 1)
+					visit(first, first + 1);
+				else if (m % 4 == 2)
+					visit(first + 1, first + 2);
+				else if (m % 4 == 3) {
+					visit(first + 2, first + 3);
+					visit(first + 3, first);
+				}
+				break;
+			}
+			case fgr::glQuadStrip:
+				//Each quad's rungs join a pair of vertices, and its sides every other vertex
+				if (n < 4)
+					return;
+				if (m % 2) {
+					visit(m - 1, m);
+					if (m >= 3)
+						visit(m - 2, m);
+				}
+				else if (m >= 2 && m + 1 < n) {
+					visit(m - 2, m);
+				}
+				break;
+			case fgr::glLineStrip:
+			default:
+				if (m)
+					visit(m - 1, m);
+				break;
+			}
+		}
+	}
+	//Every edge to or from one vertex
+	void around(std::size_t shape, std::size_t vertex, std::vector<edge>& touching) const {
+		auto keep = [&](std::size_t a, std::size_t b) {
+			if (a == vertex || b == vertex)
+				touching.push_back(makeEdge(shape, a, b));
+		};
+		//Every other edge to a vertex ends no more than three after it...
+		eachEdge(shape, vertex, vertex + 4, keep);
+		//...except the ones to the first vertex of a fan, or the one closing a loop
+		std::size_t n = outlines[shape].corners.size();
+		if (!vertex && n > 4)
+			eachEdge(shape, outlines[shape].mode == fgr::glTriangleFan ? 4 : n - 1, n, keep);
+	}
+	//Make cells about as big as the average edge is long, so most edges are in one to four cells
+	void sizeCells() {
+		double length = 0.0;
+		std::size_t edges = 0;
+		for (std::size_t s = 0; s < outlines.size(); ++s) {
+			const std::vector<corner>& at = outlines[s].corners;
+			eachEdge(s, 0, at.size(), [&](std::size_t a, std::size_t b) {
+				length += std::fabs(at[b].x - at[a].x) + std::fabs(at[b].y - at[a].y);
+				++edges;
+			});
+		}
+		cellSize = edges ? float(length / double(edges)) : 1.0f;
+		if (!(cellSize > 0.0f) || !std::isfinite(cellSize))
+			cellSize = 1.0f;
+		cells.reserve(edges + 1);
+	}
+	void fileShape(std::size_t shape) {
+		eachEdge(shape, 0, outlines[shape].corners.size(), [&](std::size_t a, std::size_t b) { file(makeEdge(shape, a, b)); });
+	}
+	void unfileShape(std::size_t shape) {
+		eachEdge(shape, 0, outlines[shape].corners.size(), [&](std::size_t a, std::size_t b) { unfile(makeEdge(shape, a, b)); });
+	}
+	//The column or row a co-ordinate is in
+	std::int32_t cellOf(float at) const {
+		float scaled = std::floor(at / cellSize);
+		scaled = std::max(-2.0e9f, std::min(2.0e9f, scaled));
+		return std::int32_t(scaled);
+	}
+	static std::uint64_t cellKey(std::int32_t column, std::int32_t row) {
+		return (std::uint64_t(std::uint32_t(column)) << 32) | std::uint32_t(row);
+	}
+	//The cells the box around an edge covers
+	void span(const edge& line, std::int32_t& left, std::int32_t& bottom, std::int32_t& right, std::int32_t& top) const {
+		const corner& a = outlines[line.shape].corners[line.from];
+		const corner& b = outlines[line.shape].corners[line.to];
+		left = cellOf(std::min(a.x, b.x));
+		right = cellOf(std::max(a.x, b.x));
+		bottom = cellOf(std::min(a.y, b.y));
+		top = cellOf(std::max(a.y, b.y));
+	}
+	//Put an edge into every cell it might cross
+	void file(const edge& line) {
+		std::int32_t left, bottom, right, top;
+		span(line, left, bottom, right, top);
+		if ((std::int64_t(right) - left + 1) * (std::int64_t(top) - bottom + 1) > mostCells) {
+			longEdges.push_back(line);
+			return;
+		}
+		for (std::int32_t column = left; column <= right; ++column) {
+			for (std::int32_t row = bottom; row <= top; ++row)
+				cells[cellKey(column, row)].push_back(line);
+		}
+	}
+	//Take an edge out of the cells it was put in (before either end of it moves)
+	void unfile(const edge& line) {
+		std::int32_t left, bottom, right, top;
+		span(line, left, bottom, right, top);
+		if ((std::int64_t(right) - left + 1) * (std::int64_t(top) - bottom + 1) > mostCells) {
+			std::vector<edge>::iterator found = std::find(longEdges.begin(), longEdges.end(), line);
+			if (found != longEdges.end())
+				longEdges.erase(found);
+			return;
+		}
+		for (std::int32_t column = left; column <= right; ++column) {
+			for (std::int32_t row = bottom; row <= top; ++row) {
+				std::unordered_map<std::uint64_t, std::vector<edge> >::iterator cell = cells.find(cellKey(column, row));
+				if (cell == cells.end())
+					continue;
+				std::vector<edge>::iterator found = std::find(cell->second.begin(), cell->second.end(), line);
+				if (found != cell->second.end()) {
+					*found = cell->second.back();
+					cell->second.pop_back();
+				}
+				if (cell->second.empty())
+					cells.erase(cell);
+			}
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,125 @@
+/* This header file defines the texture atlas that caches thumbnails for the shapes pane.
+ * Each thumbnail is rendered once into the back buffer, copied into a cell of the atlas,
+ * and from then on drawn as a single textured quad. Cells are looked up by a fingerprint
+ * of what they show, so a thumbnail is only re-rendered when its shape actually changes. */
+#pragma once
+
+#ifndef __thumbnails_h__
+#define __thumbnails_h__
+
+#include <vector>
+#include <unordered_map>
+
+class thumbnailAtlas {
+public:
+	//Side length of the atlas texture, in pixels
+	static const int ATLAS_SIZE = 1024;
+	//GL texture holding every cell (0 until first used)
+	GLuint texture;
+	//Side length of one cell, in pixels
+	int cellSize;
+	//How many cells fit along one side of the atlas
+	int columns;
+	//The fingerprint shown in each cell, and the frame each cell was last drawn on
+	std::vector<std::size_t> keys;
+	std::vector<unsigned long> lastUsed;
+	//Which cell (if any) holds each fingerprint
+	std::unordered_map<std::size_t, int> lookup;
+	//Counts frames, so the least recently drawn cell can be reused
+	unsigned long frame;
+	//How many thumbnails were rendered this frame
+	int rendered;
+
+	//Default constructor
+	thumbnailAtlas() {
+		texture = 0;
+		cellSize = 0;
+		columns = 0;
+		frame = 0;
+		rendered = 0;
+	}
+	//Start a frame of thumbnails 'size' pixels across; a change of size throws every cell away
+	void beginFrame(int size) {
+		++frame;
+		rendered = 0;
+		if (size == cellSize && texture)
+			return;
+		cellSize = size;
+		columns = size > 0 ? ATLAS_SIZE / size : 0;
+		keys.assign(std::size_t(columns) * columns, 0);
+		lastUsed.assign(keys.size(), 0);
+		lookup.clear();
+		if (!texture)
+			glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, ATLAS_SIZE, ATLAS_SIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	//Returns the cell showing this fingerprint, or -1 if it isn't cached
+	int find(std::size_t key) {
+		std::unordered_map<std::size_t, int>::iterator itr = lookup.find(key);
+		if (itr == lookup.end())
+			return -1;
+		lastUsed[itr->second] = frame;
+		return itr->second;
+	}
+	//Hand out the least recently drawn cell for a new fingerprint, or -1 if every cell is in use this frame
+	int claim(std::size_t key) {
+		int oldest = -1;
+		for (std::size_t c = 0; c < keys.size(); ++c) {
+			if (lastUsed[c] == frame)
+				continue;
+			if (oldest < 0 || lastUsed[c] < lastUsed[oldest])
+				oldest = int(c);
+			//Never-used cells can't get any older
+			if (!lastUsed[c])
+				break;
+		}
+		if (oldest < 0)
+			return -1;
+		if (lastUsed[oldest])
+			lookup.erase(keys[oldest]);
+		keys[oldest] = key;
+		lastUsed[oldest] = frame;
+		lookup[key] = oldest;
+		return oldest;
+	}
+	//Copy the bottom-left cellSize square of the back buffer into a cell
+	void capture(int cell) {
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glCopyTexSubImage2D(GL_TEXTURE_2D, 0, (cell % columns) * cellSize, (cell / columns) * cellSize,
+			0, 0, cellSize, cellSize);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		++rendered;
+	}
+	//Draw a cell over the rectangle from (left, bottom) to (right, top)
+	void draw(int cell, float left, float bottom, float right, float top) const {
+		float u0 = float((cell % columns) * cellSize) / ATLAS_SIZE;
+		float v0 = float((cell / columns) * cellSize) / ATLAS_SIZE;
+		float u1 = u0 + float(cellSize) / ATLAS_SIZE;
+		float v1 = v0 + float(cellSize) / ATLAS_SIZE;
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glEnable(GL_TEXTURE_2D);
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+		glBegin(GL_QUADS);
+			glTexCoord2f(u0, v0); glVertex2f(left, bottom);
+			glTexCoord2f(u1, v0); glVertex2f(right, bottom);
+			glTexCoord2f(u1, v1); glVertex2f(right, top);
+			glTexCoord2f(u0, v1); glVertex2f(left, top);
+		glEnd();
+		glDisable(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	//DESTRUCTOR
+	~thumbnailAtlas() {
+		if (texture)
+			glDeleteTextures(1, &texture);
+	}
+};
+
+//Every tab shares one atlas; cells are keyed by content, so identical shapes even share a cell
+thumbnailAtlas shapeThumbnails;
+
+#endif
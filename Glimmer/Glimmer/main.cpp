@@ -16,13 +16,18 @@ std::string sessionFilePath;
 #include "fgrutils.h"
 GLint mouseStates[3] = { GLUT_UP, GLUT_UP, GLUT_UP };
 #include "customgl.h"
+#include "redraw.h"
 #include "editor.h"
+#include "renderthread.h"
+#include "headless.h"
 
 //STL/etc. includes
 #include <cmath>
 #include <stdlib.h>
 #include <time.h>
 #include <vector>
+#include <mutex>
+#include "fgrparallel.h"
 
 
 typedef std::list<editor> tabContainerType;
@@ -31,6 +36,12 @@ typedef std::list<editor> tabContainerType;
 tabContainerType tabs;
 //The current tab is pointed to by this
 tabContainerType::iterator currentTab;
+//How much memory the art of the tabs not being viewed may take up before the ones viewed
+//longest ago are put away, in bytes (set with :tabmemory)
+std::size_t tabMemoryBudget = 256 * 1024 * 1024;
+//Counts tab switches, to tell which tabs were viewed longest ago
+unsigned long tabViews = 0;
+#include "autosave.h"
 
 //Exits the program
 void closeProgram();
@@ -45,15 +56,96 @@ bool sessionSaved() {
 	return true;
 }
 
+//How much memory the art of every tab takes up, leaving out the tabs whose art is put away
+std::size_t residentArtBytes() {
+	std::size_t used = 0;
+	for (tabContainerType::iterator itr = tabs.begin(); itr != tabs.end(); ++itr) {
+		if (itr->resident())
+			used += itr->artBytes();
+	}
+	return used;
+}
+
+//Put away the art of the tabs viewed longest ago until the tabs not being viewed fit in the budget
+void fitTabBudget() {
+	std::vector<tabContainerType::iterator> idle;
+	std::size_t used = 0;
+	for (tabContainerType::iterator itr = tabs.begin(); itr != tabs.end(); ++itr) {
+		if (itr == currentTab || !itr->resident())
+			continue;
+		idle.push_back(itr);
+		used += itr->artBytes();
+	}
+	std::sort(idle.begin(), idle.end(), [](tabContainerType::iterator a, tabContainerType::iterator b) {
+		return a->lastViewed < b->lastViewed;
+	});
+	for (std::size_t i = 0; i < idle.size() && used > tabMemoryBudget; ++i) {
+		std::size_t bytes = idle[i]->artBytes();
+		//Put away, unsaved work only lives in a temporary file a crash would take with it
+		autosave::capture(*idle[i]);
+		if (idle[i]->sleep())
+			used -= bytes;
+	}
+}
+
+//Make a tab the current one, bringing its art back if it was put away. Returns false if its
+//art couldn't be read (it's left empty then).
+bool switchTab(tabContainerType::iterator which) {
+	currentTab = which;
+	currentTab->lastViewed = ++tabViews;
+	bool read = currentTab->wake();
+	currentTab->updateWindowName();
+	fitTabBudget();
+	return read;
+}
+
+//Work on several tabs at once, on every core, then finish up on this thread, one tab at a time in
+//the order given. Each job gets its own copy of a tab (sharing the tab's art until it's changed),
+//so the tabs themselves are only ever touched here: job(copy) returns whether it worked, and
+//finish(tab, copy, worked) takes whatever should be kept from the copy. Returns once every tab is finished.
+template<class jobtype, class finishtype>
+void acrossTabs(const std::vector<tabContainerType::iterator>& which, jobtype job, finishtype finish) {
+	std::vector<editor> copies;
+	copies.reserve(which.size());
+	for (std::size_t i = 0; i < which.size(); ++i)
+		copies.emplace_back(*which[i]);
+	//Tabs can take very different amounts of time, so each worker takes the next tab once it's done with one
+	std::vector<char> worked(which.size(), 0);
+	std::mutex lock;
+	std::size_t next = 0;
+	fgr::parallel::forChunks(0, std::min<std::size_t>(which.size(), fgr::parallel::workerCount()),
+		[&](std::size_t, std::size_t, unsigned int) {
+		for (;;) {
+			std::size_t i;
+			{
+				std::lock_guard<std::mutex> hold(lock);
+				if (next >= copies.size())
+					return;
+				i = next++;
+			}
+			worked[i] = job(copies[i]);
+		}
+	});
+	for (std::size_t i = 0; i < which.size(); ++i)
+		finish(which[i], copies[i], worked[i] != 0);
+}
+
 //Closes the tab at the iterator (doesn't check for saving!) and sets the tab iterator to the tab after it
 void closeTab(tabContainerType::iterator& which) {
+	//Whatever wasn't saved is meant to be thrown away, so its copy goes too
+	autosave::forget(which->filepath);
 	which = tabs.erase(which);
 	if (!tabs.size()) {
 		closeProgram();
 	}
+	if (which == tabs.end())
+		which = tabs.begin();
+	//The tab that takes the closed one's place may have been put away
+	which->wake();
 }
 #include "console.h"
 #include "controls.h"
+#include "opener.h"
 
 
 //#include <windows.h>
@@ -65,8 +157,53 @@ void initGL() {
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // Black and opaque
 }
 
+//Draw a whole frame: the editor, the console and the window outline
+void drawFrame(const editor& tab, const std::string& consoleField, const std::string& session) {
+	perf::frameBegun();
+	//Draw the current editor
+	drawEditor(tab, session);
+	//Draw the little console window
+	glLineWidth(1.0f);
+	{
+		perf::timer timing(perf::pConsole);
+		cli::drawField(tab, consoleField);
+	}
+
+	glColor3f(1.0f, 1.0f, 1.0f);
+	setViewport(superWindowPane(), false);
+	outlineViewport(viewport(1, 1, superWindowPane().right(), superWindowPane().top()));
+	perf::frameFinished();
+	//Draw what the frame cost over the corner of the central editor
+	if (perf::shown) {
+		glLineWidth(1.0f);
+		setViewport(tab.centralPane(), false);
+		perf::draw(tab.centralPane().right(), tab.centralPane().top());
+	}
+}
+
 //Contains all gl-code; there should be no need to have any outside of this function
 void renderScene(void) {
+	//If the render thread hasn't picked up the last frame yet, this one waits for it
+	if (renderthread::active() && !renderthread::ready()) {
+		redraw::deferFrame();
+		return;
+	}
+	//Catch up on input that arrived since the last frame
+	redraw::frameBegun();
+	{
+		perf::timer timing(perf::pInput);
+		flushPendingMotion();
+	}
+	//The overlay keeps drawing, so its graph keeps rolling
+	if (perf::shown) {
+		perf::residentBytes = residentArtBytes();
+		redraw::request();
+	}
+	//Hand the frame to the render thread, if it's drawing
+	if (renderthread::active()) {
+		renderthread::publish(*currentTab, cli::getfield(), sessionFilePath);
+		return;
+	}
 	//Screen-cleanup
 	// Clear Color and Depth Buffers
 	ClearScreen();
@@ -75,15 +212,7 @@ void renderScene(void) {
 
 	///////////////////////// DRAWING INSTRUCTIONS ////////////////////////////
 
-	//Draw the current editor
-	drawEditor(*currentTab);
-	//Draw the little console window
-	glLineWidth(1.0f);
-	cli::draw();
-
-	glColor3f(1.0f, 1.0f, 1.0f);
-	setViewport(superWindowPane(), false);
-	outlineViewport(viewport(1, 1, superWindowPane().right(), superWindowPane().top()));
+	drawFrame(*currentTab, cli::getfield(), sessionFilePath);
 
 	//This is the function that refreshes the canvas and implements everything we've 'drawn'
 	glutSwapBuffers();
@@ -100,9 +229,23 @@ void initTabs(int argc, char** argv) {
 		cli::send_message("Started session without arguments.");
 		return;
 	}
-	//Otherwise, its reasonable to assume there's another argument
-	tabs.push_back(editor(std::string(argv[1])));
-	currentTab = tabs.begin();
+	//Otherwise every argument is a file (or a name with wildcards in it) to open in a tab of its own
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; ++i) {
+		std::vector<std::string> matched = glut32::matchFiles(argv[i]);
+		if (matched.empty())
+			cli::send_message("No files match '" + std::string(argv[i]) + '\'', uWarning);
+		paths.insert(paths.end(), matched.begin(), matched.end());
+	}
+	//They're read all at once; only the first has to be ready before the window shows anything
+	opener::start(paths, tabMemoryBudget);
+	if (!opener::showFinished(true))
+		glutTimerFunc(opener::pollInterval, opener::poll, 0);
+	if (tabs.empty()) {
+		tabs.push_back(editor(eGraphic));
+		tabs.back().blankFile = true;
+	}
+	switchTab(tabs.begin());
 	return;
 }
 
@@ -112,13 +255,27 @@ fgr::point testfunc(float t) {
 
 //main function; exists to set up a few things and then enter the glut-main-loop
 int main(int argc, char** argv) {
+	//Headless work never opens a window
+	if (argc > 1 && std::string(argv[1]) == "--bench")
+		return headlessBenchmark(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "--bench-painting")
+		return headlessPaintingBenchmark(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "--export")
+		return headlessExport(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "--bake-atlas")
+		return headlessBakeAtlas(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "--check-gif")
+		return headlessCheckGif(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "--check-snap")
+		return headlessCheckSnap(argc, argv);
+
 	//Initialize GLUT
 	glutInit(&argc, argv);
 
 	////Choose some settings for our Window
 	glutInitWindowPosition(100, 100);
 	glutInitWindowSize(900, 500);
-	//glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
+	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
 
 	//Create the Window
 	glutCreateWindow("GlimmerTitle");
@@ -130,6 +287,9 @@ int main(int argc, char** argv) {
 	//Command line args:
 	initTabs(argc, argv);
 
+	//Frames are only drawn on request; apply the default pacing until .glimrc says otherwise
+	redraw::setPolicy(redraw::policy);
+
 	////Some settings
 	//glutIgnoreKeyRepeat(1);
 	////glutSetCursor(GLUT_CURSOR_NONE); //Hide the cursor
@@ -152,6 +312,9 @@ int main(int argc, char** argv) {
 	//Attempt to load user prefrences
 	cli::source(".glimrc");
 
+	//Keep copies of unsaved work every so often (.glimrc may have changed how often, or turned it off)
+	autosave::schedule();
+
 	initGL();                       // Our own OpenGL initialization
 
 	glutMainLoop();                 // Enter the event-processing loop